@@ -83,43 +83,46 @@ namespace Mapper
 
     public enum Property
     {
-        Data                = 0x0200,
-        Device              = 0x0300,
-        Direction           = 0x0400,
-        Expression          = 0x0500,
-        Host                = 0x0600,
-        Id                  = 0x0700,
-        Instance            = 0x0800,
-        IsLocal             = 0x0900,
-        Jitter              = 0x0A00,
-        Length              = 0x0B00,
-        LibVersion          = 0x0C00,
-        Linked              = 0x0D00,
-        Max                 = 0x0E00,
-        Min                 = 0x0F00,
-        Muted               = 0x1000,
-        Name                = 0x1100,
-        NumInstances        = 0x1200,
-        NumMaps             = 0x1300,
-        NumMapsIn           = 0x1400,
-        NumMapsOut          = 0x1500,
-        NumSigsIn           = 0x1600,
-        NumSigsOut          = 0x1700,
-        Ordinal             = 0x1800,
-        Period              = 0x1900,
-        Port                = 0x1A00,
-        ProcessingLocation  = 0x1B00,
-        Protocol            = 0x1C00,
-        Rate                = 0x1D00,
-        Scope               = 0x1E00,
-        Signal              = 0x1F00,
-        Status              = 0x2100,
-        StealingMode        = 0x2200,
-        Synced              = 0x2300,
-        Type                = 0x2400,
-        Unit                = 0x2500,
-        UseInstances        = 0x2600,
-        Version             = 0x2700
+        Coalesce            = 0x0200,
+        Data                = 0x0300,
+        Deadband            = 0x0400,
+        Device              = 0x0500,
+        Direction           = 0x0600,
+        Expression          = 0x0700,
+        Host                = 0x0800,
+        Id                  = 0x0900,
+        Instance            = 0x0A00,
+        IsLocal             = 0x0B00,
+        Jitter              = 0x0C00,
+        Length              = 0x0D00,
+        LibVersion          = 0x0E00,
+        Linked              = 0x0F00,
+        Max                 = 0x1000,
+        Min                 = 0x1100,
+        Muted               = 0x1200,
+        Name                = 0x1300,
+        NumInstances        = 0x1400,
+        NumMaps             = 0x1500,
+        NumMapsIn           = 0x1600,
+        NumMapsOut          = 0x1700,
+        NumSigsIn           = 0x1800,
+        NumSigsOut          = 0x1900,
+        NumSuppressed       = 0x1A00,
+        Ordinal             = 0x1B00,
+        Period              = 0x1C00,
+        Port                = 0x1D00,
+        ProcessingLocation  = 0x1E00,
+        Protocol            = 0x1F00,
+        Rate                = 0x2000,
+        Scope               = 0x2100,
+        Signal              = 0x2200,
+        Status              = 0x2400,
+        StealingMode        = 0x2500,
+        Synced              = 0x2600,
+        Type                = 0x2700,
+        Unit                = 0x2800,
+        UseInstances        = 0x2900,
+        Version             = 0x2A00
     }
 
     public abstract class Object
@@ -334,6 +337,7 @@ namespace Mapper
             None,       //!< No stealing will take place.
             Oldest,     //!< Steal the oldest instance.
             Newest,     //!< Steal the newest instance.
+            LeastRecent //!< Steal the least-recently updated instance.
         }
 
         private enum HandlerType {
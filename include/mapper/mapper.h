@@ -220,6 +220,46 @@ mpr_list mpr_dev_get_maps(mpr_dev device, mpr_dir direction);
  *  \return             The number of handled messages. May be zero if there was nothing to do. */
 int mpr_dev_poll(mpr_dev device, int block_ms);
 
+/*! Start a background thread that polls this device continuously, so that incoming messages are
+ *  handled and outgoing updates are sent without waiting for the application to call
+ *  mpr_dev_poll().  Signal handlers are called on this thread.  While the thread is running,
+ *  mpr_dev_poll() does nothing, and calls to mpr_sig_set_value(), mpr_sig_set_values() and
+ *  mpr_sig_release_inst() from other threads are passed to the polling thread as if by
+ *  mpr_sig_queue_value(), waiting for the polling thread to make room if the queue is full.
+ *  The polling thread also updates the graph from incoming admin messages, and the graph is not
+ *  locked: other threads must not query or modify the graph, the device, its signals or maps
+ *  while the thread is running.  Do so from signal handlers or after calling
+ *  mpr_dev_stop_polling().
+ *  \param device       The device to poll.
+ *  \param block_ms     Number of milliseconds the thread blocks waiting for messages.  This
+ *                      also bounds the delay of updates passed from other threads.
+ *  \return             Zero if the thread is running, non-zero if it could not be started. */
+int mpr_dev_start_polling(mpr_dev device, int block_ms);
+
+/*! Stop the background polling thread started by mpr_dev_start_polling() and wait for it to
+ *  finish.  This function must not be called from a signal handler.
+ *  \param device       The device to stop polling.
+ *  \return             Zero if no polling thread is running on return, non-zero otherwise. */
+int mpr_dev_stop_polling(mpr_dev device);
+
+/*! Retrieve the file descriptors of the sockets used by a device, so that it can be integrated
+ *  with an external event loop.  Sockets for incoming TCP connections are managed internally
+ *  and are not included; while maps use TCP, mpr_graph_get_next_timeout() is capped so that
+ *  they are still serviced.
+ *  \param device       The device to query.
+ *  \param fds          An array to fill with file descriptors, may be NULL.
+ *  \param num          The size of the fds array.
+ *  \return             The number of file descriptors, which may exceed num. */
+int mpr_dev_get_fds(mpr_dev device, int *fds, int num);
+
+/*! Do only the work that is due for a device without blocking: handle messages waiting on its
+ *  sockets, process updated maps, and run network housekeeping if its deadline has passed.
+ *  Intended to be called from an external event loop, see mpr_dev_get_fds() and
+ *  mpr_graph_get_next_timeout().
+ *  \param device       The device to process.
+ *  \return             The number of handled messages. */
+int mpr_dev_process_ready(mpr_dev device);
+
 /*! Detect whether a device is completely initialized.
  *  \param device       The device to query.
  *  \return             Non-zero if device is completely initialized, i.e., has an allocated
@@ -306,6 +346,55 @@ void mpr_sig_free(mpr_sig signal);
 void mpr_sig_set_value(mpr_sig signal, mpr_id instance, int length, mpr_type type,
                        const void *value);
 
+/*! Update the values of several signal instances in one call.  Each instance is updated as
+ *  with mpr_sig_set_value(), sharing the same timestamp.
+ *  \param signal       The signal to operate on.
+ *  \param num_inst     The number of instances to update.
+ *  \param instances    An array of num_inst instance identifiers.
+ *  \param length       Length of each instance value. Expected to be equal to the signal
+ *                      length.
+ *  \param type         Data type of the values argument.
+ *  \param values       A packed array of num_inst * length values, holding the value of each
+ *                      instance in the order given by the instances argument. */
+void mpr_sig_set_values(mpr_sig signal, int num_inst, const mpr_id *instances, int length,
+                        mpr_type type, const void *values);
+
+/*! Update some elements of a vector signal instance, leaving the other elements unchanged.  Maps
+ *  with element-wise expressions that are processed at the source, or maps without processing,
+ *  send only the updated elements of the destination value.  The instance is not updated
+ *  downstream until all of its elements have a value.  This function must be called from the
+ *  thread that polls the device.
+ *  \param signal       The signal to operate on.
+ *  \param instance     The identifier of the instance to update, or 0 for the default instance.
+ *  \param num          The number of elements to update.
+ *  \param indices      An array of num vector indices.
+ *  \param type         Data type of the values argument.
+ *  \param values       An array of num values, holding the new value of each element in the
+ *                      order given by the indices argument. */
+void mpr_sig_set_elements(mpr_sig signal, mpr_id instance, int num, const int *indices,
+                          mpr_type type, const void *values);
+
+/*! Queue an update of a signal instance from another thread or from an interrupt handler.  The
+ *  update is copied into a fixed-size queue belonging to the signal's device without taking
+ *  locks or allocating memory, and is applied as if by mpr_sig_set_value() during the next call
+ *  to mpr_dev_poll().  Updates are applied in the order they were queued.  Each queued value
+ *  holds at most 128 bytes; larger values are rejected.  The signal must not be freed while
+ *  other threads may still queue updates for it.
+ *  \param signal       The signal to operate on.
+ *  \param instance     The identifier of the instance to update, or 0 for the default
+ *                      instance.
+ *  \param length       Length of the value argument. Expected to be equal to the signal
+ *                      length. A length of zero or a NULL value queues a release of the
+ *                      instance instead.
+ *  \param type         Data type of the value argument.
+ *  \param value        A pointer to the new value, which is copied before returning.
+ *  \param time         The time associated with the update, or MPR_NOW to use the current
+ *                      time.
+ *  \return             Zero if the update was queued, or non-zero if the queue is full or the
+ *                      value is invalid or too large. */
+int mpr_sig_queue_value(mpr_sig signal, mpr_id instance, int length, mpr_type type,
+                        const void *value, mpr_time time);
+
 /*! Get the value of a signal instance.
  *  \param signal       The signal to operate on.
  *  \param instance     A pointer to the identifier of the instance to query,
@@ -389,7 +478,7 @@ mpr_id mpr_sig_get_oldest_inst_id(mpr_sig signal);
 mpr_id mpr_sig_get_newest_inst_id(mpr_sig signal);
 
 /*! Get a signal instance's identifier by its index.  Intended to be used for
- *  iterating over the active instances.
+ *  iterating over the active instances, which are indexed in order of their identifiers.
  *  \param signal       The signal to operate on.
  *  \param index        The numerical index of the instance to retrieve.  Should be between zero
  *                      and the number of instances.
@@ -564,6 +653,13 @@ mpr_list mpr_list_get_next(mpr_list list);
  *  \return             A list of results.  Use mpr_list_get_next() to iterate. */
 mpr_list mpr_list_get_cpy(mpr_list list);
 
+/*! Cache the results of a list of objects, so that its size and indexed items can be retrieved
+ *  in constant time.  The cache is rebuilt automatically when the graph has changed.
+ *  \param list         The list to cache.  It is consumed by this function and must not be used
+ *                      or freed afterwards.
+ *  \return             A list of results.  Use mpr_list_get_next() to iterate. */
+mpr_list mpr_list_get_cached(mpr_list list);
+
 /*! Given a object record pointer returned from a previous object query,
  *  indicate that we are done iterating.
  *  \param list         The previous object record pointer. */
@@ -620,6 +716,15 @@ const char *mpr_graph_get_address(mpr_graph graph);
  *  \return             The number of handled messages. */
 int mpr_graph_poll(mpr_graph graph, int block_ms);
 
+/*! Get the time until a graph or its local devices next have work to do, for use with an
+ *  external event loop that waits on the sockets returned by mpr_dev_get_fds().  Call
+ *  mpr_dev_process_ready() when a socket is readable or the timeout has elapsed.  Updates queued
+ *  from other threads with mpr_sig_queue_value() do not wake the sockets; the thread queueing
+ *  them should also wake the event loop.
+ *  \param graph        The graph to query.
+ *  \return             The number of milliseconds until work is due, or zero if it is due now. */
+int mpr_graph_get_next_timeout(mpr_graph graph);
+
 /*! Free a graph.
  *  \param graph        The graph to free. */
 void mpr_graph_free(mpr_graph graph);
@@ -672,6 +777,36 @@ int mpr_graph_add_cb(mpr_graph graph, mpr_graph_handler *handler, int types, con
  *  \return             User data pointer associated with this callback (if any). */
 void *mpr_graph_remove_cb(mpr_graph graph, mpr_graph_handler *handler, const void *data);
 
+/*! Add an index of objects by the value of a property, which mpr_list_filter() will use to
+ *  find matching objects without testing every object of the graph.  Only equality and range
+ *  comparisons can use an index.  Properties that change as a side effect of other operations,
+ *  such as counts of maps or signals and statistics, cannot be indexed.
+ *  \param graph        The graph to index.
+ *  \param type         The type of objects to index: MPR_DEV, MPR_SIG or MPR_MAP.
+ *  \param property     Symbolic identifier of the property to index.
+ *  \param key          The name of the property to index, used instead of the property
+ *                      identifier if not NULL.
+ *  \return             One if an index was added, otherwise zero. */
+int mpr_graph_add_index(mpr_graph graph, int type, mpr_prop property, const char *key);
+
+/*! Bound the memory used by the graph's records of remote signals, for programs that only need
+ *  device and map information.  Properties of remote signals that are not listed are not stored
+ *  when received, and once the graph holds more than max_signals remote signals the ones updated
+ *  least recently are removed, starting with those of devices that are not subscribed to.
+ *  Signals used by maps are always kept.  Removed signals are reported to graph callbacks with
+ *  the event MPR_OBJ_EXP.
+ *  \param graph        The graph to configure.
+ *  \param num_props    The number of properties in the props array.  If both num_props and
+ *                      num_keys are 0 all properties are kept.
+ *  \param props        The signal properties to keep.  The device, direction, id, length,
+ *                      name and type of signals are always kept.
+ *  \param num_keys     The number of names in the keys array.
+ *  \param keys         The names of the user-defined signal properties to keep.  Other
+ *                      user-defined properties are not stored.
+ *  \param max_signals  The maximum number of remote signals to keep, or 0 for no limit. */
+void mpr_graph_set_retention(mpr_graph graph, int num_props, const mpr_prop *props,
+                             int num_keys, const char **keys, int max_signals);
+
 /*! Return a list of objects.
  *  \param graph        The graph to query.
  *  \param types        Bitflags setting the type of information of interest.
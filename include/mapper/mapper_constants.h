@@ -42,45 +42,48 @@ typedef char mpr_type;
 typedef enum {
     MPR_PROP_UNKNOWN        = 0x0000,
     MPR_PROP_CALIB          = 0x0100,
-    MPR_PROP_DATA           = 0x0200,
-    MPR_PROP_DEV            = 0x0300,
-    MPR_PROP_DIR            = 0x0400,
-    MPR_PROP_EXPR           = 0x0500,
-    MPR_PROP_HOST           = 0x0600,
-    MPR_PROP_ID             = 0x0700,
-    MPR_PROP_INST           = 0x0800,
-    MPR_PROP_IS_LOCAL       = 0x0900,
-    MPR_PROP_JITTER         = 0x0A00,
-    MPR_PROP_LEN            = 0x0B00,
-    MPR_PROP_LIBVER         = 0x0C00,
-    MPR_PROP_LINKED         = 0x0D00,
-    MPR_PROP_MAX            = 0x0E00,
-    MPR_PROP_MIN            = 0x0F00,
-    MPR_PROP_MUTED          = 0x1000,
-    MPR_PROP_NAME           = 0x1100,
-    MPR_PROP_NUM_INST       = 0x1200,
-    MPR_PROP_NUM_MAPS       = 0x1300,
-    MPR_PROP_NUM_MAPS_IN    = 0x1400,
-    MPR_PROP_NUM_MAPS_OUT   = 0x1500,
-    MPR_PROP_NUM_SIGS_IN    = 0x1600,
-    MPR_PROP_NUM_SIGS_OUT   = 0x1700,
-    MPR_PROP_ORDINAL        = 0x1800,
-    MPR_PROP_PERIOD         = 0x1900,
-    MPR_PROP_PORT           = 0x1A00,
-    MPR_PROP_PROCESS_LOC    = 0x1B00,
-    MPR_PROP_PROTOCOL       = 0x1C00,
-    MPR_PROP_RATE           = 0x1D00,
-    MPR_PROP_SCOPE          = 0x1E00,
-    MPR_PROP_SIG            = 0x1F00,
-    MPR_PROP_SLOT           = 0x2000,
-    MPR_PROP_STATUS         = 0x2100,
-    MPR_PROP_STEAL_MODE     = 0x2200,
-    MPR_PROP_SYNCED         = 0x2300,
-    MPR_PROP_TYPE           = 0x2400,
-    MPR_PROP_UNIT           = 0x2500,
-    MPR_PROP_USE_INST       = 0x2600,
-    MPR_PROP_VERSION        = 0x2700,
-    MPR_PROP_EXTRA          = 0x2800
+    MPR_PROP_COALESCE       = 0x0200,
+    MPR_PROP_DATA           = 0x0300,
+    MPR_PROP_DEADBAND       = 0x0400,
+    MPR_PROP_DEV            = 0x0500,
+    MPR_PROP_DIR            = 0x0600,
+    MPR_PROP_EXPR           = 0x0700,
+    MPR_PROP_HOST           = 0x0800,
+    MPR_PROP_ID             = 0x0900,
+    MPR_PROP_INST           = 0x0A00,
+    MPR_PROP_IS_LOCAL       = 0x0B00,
+    MPR_PROP_JITTER         = 0x0C00,
+    MPR_PROP_LEN            = 0x0D00,
+    MPR_PROP_LIBVER         = 0x0E00,
+    MPR_PROP_LINKED         = 0x0F00,
+    MPR_PROP_MAX            = 0x1000,
+    MPR_PROP_MIN            = 0x1100,
+    MPR_PROP_MUTED          = 0x1200,
+    MPR_PROP_NAME           = 0x1300,
+    MPR_PROP_NUM_INST       = 0x1400,
+    MPR_PROP_NUM_MAPS       = 0x1500,
+    MPR_PROP_NUM_MAPS_IN    = 0x1600,
+    MPR_PROP_NUM_MAPS_OUT   = 0x1700,
+    MPR_PROP_NUM_SIGS_IN    = 0x1800,
+    MPR_PROP_NUM_SIGS_OUT   = 0x1900,
+    MPR_PROP_NUM_SUPPRESSED = 0x1A00,
+    MPR_PROP_ORDINAL        = 0x1B00,
+    MPR_PROP_PERIOD         = 0x1C00,
+    MPR_PROP_PORT           = 0x1D00,
+    MPR_PROP_PROCESS_LOC    = 0x1E00,
+    MPR_PROP_PROTOCOL       = 0x1F00,
+    MPR_PROP_RATE           = 0x2000,
+    MPR_PROP_SCOPE          = 0x2100,
+    MPR_PROP_SIG            = 0x2200,
+    MPR_PROP_SLOT           = 0x2300,
+    MPR_PROP_STATUS         = 0x2400,
+    MPR_PROP_STEAL_MODE     = 0x2500,
+    MPR_PROP_SYNCED         = 0x2600,
+    MPR_PROP_TYPE           = 0x2700,
+    MPR_PROP_UNIT           = 0x2800,
+    MPR_PROP_USE_INST       = 0x2900,
+    MPR_PROP_VERSION        = 0x2A00,
+    MPR_PROP_EXTRA          = 0x2B00
 } mpr_prop;
 
 /*! This data structure must be large enough to hold a system pointer or a uin64_t */
@@ -149,9 +152,21 @@ typedef enum {
 typedef enum {
     MPR_STEAL_NONE,     /*!< No stealing will take place. */
     MPR_STEAL_OLDEST,   /*!< Steal the oldest instance. */
-    MPR_STEAL_NEWEST    /*!< Steal the newest instance. */
+    MPR_STEAL_NEWEST,   /*!< Steal the newest instance. */
+    MPR_STEAL_LEAST_RECENT  /*!< Steal the least-recently updated instance. */
 } mpr_steal_type;
 
+/*! Describes how repeated updates are coalesced before map output is sent.  If
+ *  the map also has a maximum output rate (MPR_PROP_RATE) updates are combined
+ *  over each output interval.
+ *  @ingroup map */
+typedef enum {
+    MPR_COALESCE_NONE,      /*!< Every update is sent. */
+    MPR_COALESCE_LATEST,    /*!< Only the latest update per instance is sent. */
+    MPR_COALESCE_MEAN,      /*!< The mean of the updates per instance is sent. */
+    MPR_COALESCE_MAX        /*!< The maximum of the updates per instance is sent. */
+} mpr_coalesce_type;
+
 /*! The set of possible graph events, used to inform callbacks.
  *  @ingroup graph */
 typedef enum {
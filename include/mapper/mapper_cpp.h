@@ -99,6 +99,8 @@ namespace mapper {
     enum class Property
     {
         CALIBRATING         = MPR_PROP_CALIB,
+        COALESCE            = MPR_PROP_COALESCE,
+        DEADBAND            = MPR_PROP_DEADBAND,
         DEVICE              = MPR_PROP_DEV,
         DIRECTION           = MPR_PROP_DIR,
         EXPRESSION          = MPR_PROP_EXPR,
@@ -119,6 +121,7 @@ namespace mapper {
         NUM_MAPS_OUT        = MPR_PROP_NUM_MAPS_OUT,
         NUM_SIGNALS_IN      = MPR_PROP_NUM_SIGS_IN,
         NUM_SIGNALS_OUT     = MPR_PROP_NUM_SIGS_OUT,
+        NUM_SUPPRESSED      = MPR_PROP_NUM_SUPPRESSED,
         ORDINAL             = MPR_PROP_ORDINAL,
         PERIOD              = MPR_PROP_PERIOD,
         PORT                = MPR_PROP_PORT,
@@ -253,7 +256,7 @@ namespace mapper {
             { return List(0); }
 
         int size()
-            { return mpr_list_get_size(_list); }
+            { _cache(); return mpr_list_get_size(_list); }
 
         /* Combination functions */
         /*! Add items found in List rhs to this List (without duplication).
@@ -357,7 +360,7 @@ namespace mapper {
          *  \param idx           The index of the element to retrieve.
          *  \return              The retrieved Object. */
         T operator [] (int idx)
-            { return T(mpr_list_get_idx(_list, idx)); }
+            { _cache(); return T(mpr_list_get_idx(_list, idx)); }
 
         /*! Convert this List to a std::vector of CLASS_NAME.
          *  \return              The converted List results. */
@@ -374,6 +377,10 @@ namespace mapper {
 
     protected:
         mpr_list _list;
+
+        /* Cache the query results so that repeated size and index lookups are constant-time. */
+        void _cache()
+            { _list = mpr_list_get_cached(_list); }
     };
 
     /*! Objects provide a generic representation of Devices, Signals, and Maps. */
@@ -506,7 +513,18 @@ namespace mapper {
         {
             NONE    = MPR_STEAL_NONE,       /*!< No stealing will take place. */
             OLDEST  = MPR_STEAL_OLDEST,     /*!< Steal the oldest instance. */
-            NEWEST  = MPR_STEAL_NEWEST      /*!< Steal the newest instance. */
+            NEWEST  = MPR_STEAL_NEWEST,     /*!< Steal the newest instance. */
+            LEAST_RECENT = MPR_STEAL_LEAST_RECENT   /*!< Steal the least-recently updated
+                                                     *   instance. */
+        };
+
+        /*! Describes how repeated updates are coalesced before map output is sent. */
+        enum class Coalesce
+        {
+            NONE    = MPR_COALESCE_NONE,    /*!< Every update is sent. */
+            LATEST  = MPR_COALESCE_LATEST,  /*!< Only the latest update per instance is sent. */
+            MEAN    = MPR_COALESCE_MEAN,    /*!< The mean of the updates per instance is sent. */
+            MAX     = MPR_COALESCE_MAX      /*!< The maximum of the updates per instance is sent. */
         };
     private:
         /* This constructor accepts a between 2 and 10 signal object arguments inclusive. It is
@@ -737,6 +755,57 @@ namespace mapper {
         template <typename T>
         Signal& set_value(std::vector<T> val)
             { return set_value(&val[0], (int)val.size()); }
+
+        /* Batch update functions, values are packed with one vector per instance */
+        Signal& set_value(const Id *ids, int num_inst, const int *vals, int len)
+            { mpr_sig_set_values(_obj, num_inst, ids, len, MPR_INT32, vals); RETURN_SELF }
+        Signal& set_value(const Id *ids, int num_inst, const float *vals, int len)
+            { mpr_sig_set_values(_obj, num_inst, ids, len, MPR_FLT, vals); RETURN_SELF }
+        Signal& set_value(const Id *ids, int num_inst, const double *vals, int len)
+            { mpr_sig_set_values(_obj, num_inst, ids, len, MPR_DBL, vals); RETURN_SELF }
+        template <typename T, size_t N, size_t M>
+        Signal& set_value(const std::array<Id,N>& ids, const std::array<T,M>& vals)
+            { return set_value(ids.data(), (int)N, vals.data(), N ? (int)(M / N) : 0); }
+        template <typename T>
+        Signal& set_value(const std::vector<Id>& ids, const std::vector<T>& vals)
+        {
+            int num_inst = (int)ids.size();
+            return set_value(ids.data(), num_inst, vals.data(),
+                             num_inst ? (int)vals.size() / num_inst : 0);
+        }
+
+        /* Partial update functions, only the given vector elements are changed */
+        Signal& set_elements(const int *indices, int num, const int *vals)
+            { mpr_sig_set_elements(_obj, 0, num, indices, MPR_INT32, vals); RETURN_SELF }
+        Signal& set_elements(const int *indices, int num, const float *vals)
+            { mpr_sig_set_elements(_obj, 0, num, indices, MPR_FLT, vals); RETURN_SELF }
+        Signal& set_elements(const int *indices, int num, const double *vals)
+            { mpr_sig_set_elements(_obj, 0, num, indices, MPR_DBL, vals); RETURN_SELF }
+        template <typename T>
+        Signal& set_elements(const std::vector<int>& indices, const std::vector<T>& vals)
+        {
+            int num = (int)(indices.size() < vals.size() ? indices.size() : vals.size());
+            return set_elements(indices.data(), num, vals.data());
+        }
+
+        /* Thread-safe update functions, values are applied during the next call to
+         * Device::poll(). Return false if the update queue is full or the value is larger
+         * than 128 bytes. */
+        bool queue_value(const int *val, int len)
+            { return !mpr_sig_queue_value(_obj, 0, len, MPR_INT32, val, MPR_NOW); }
+        bool queue_value(const float *val, int len)
+            { return !mpr_sig_queue_value(_obj, 0, len, MPR_FLT, val, MPR_NOW); }
+        bool queue_value(const double *val, int len)
+            { return !mpr_sig_queue_value(_obj, 0, len, MPR_DBL, val, MPR_NOW); }
+        template <typename T>
+        bool queue_value(T val)
+            { return queue_value(&val, 1); }
+        template <typename T, size_t N>
+        bool queue_value(const std::array<T,N>& val)
+            { return queue_value(val.data(), (int)N); }
+        template <typename T>
+        bool queue_value(const std::vector<T>& val)
+            { return queue_value(val.data(), (int)val.size()); }
         const void *value() const
             { return mpr_sig_get_value(_obj, 0, 0); }
         const void *value(Time time) const
@@ -771,6 +840,31 @@ namespace mapper {
                 mpr_sig_set_value(_sig, _id, len, MPR_DBL, val);
                 return (*this);
             }
+            Instance& set_elements(const int *indices, int num, const int *vals)
+            {
+                mpr_sig_set_elements(_sig, _id, num, indices, MPR_INT32, vals);
+                return (*this);
+            }
+            Instance& set_elements(const int *indices, int num, const float *vals)
+            {
+                mpr_sig_set_elements(_sig, _id, num, indices, MPR_FLT, vals);
+                return (*this);
+            }
+            Instance& set_elements(const int *indices, int num, const double *vals)
+            {
+                mpr_sig_set_elements(_sig, _id, num, indices, MPR_DBL, vals);
+                return (*this);
+            }
+
+            bool queue_value(const int *val, int len)
+                { return !mpr_sig_queue_value(_sig, _id, len, MPR_INT32, val, MPR_NOW); }
+            bool queue_value(const float *val, int len)
+                { return !mpr_sig_queue_value(_sig, _id, len, MPR_FLT, val, MPR_NOW); }
+            bool queue_value(const double *val, int len)
+                { return !mpr_sig_queue_value(_sig, _id, len, MPR_DBL, val, MPR_NOW); }
+            template <typename T>
+            bool queue_value(T val)
+                { return queue_value(&val, 1); }
 
             void release()
                 { mpr_sig_release_inst(_sig, _id); }
@@ -1104,6 +1198,19 @@ namespace mapper {
 
         int poll(int block_ms=0) const
             { return mpr_dev_poll(_obj, block_ms); }
+        bool start_polling(int block_ms=10) const
+            { return !mpr_dev_start_polling(_obj, block_ms); }
+        bool stop_polling() const
+            { return !mpr_dev_stop_polling(_obj); }
+        std::vector<int> fds() const
+        {
+            std::vector<int> fds(mpr_dev_get_fds(_obj, NULL, 0));
+            if (fds.size())
+                mpr_dev_get_fds(_obj, &fds[0], (int)fds.size());
+            return fds;
+        }
+        int process_ready() const
+            { return mpr_dev_process_ready(_obj); }
 
         bool ready() const
             { return mpr_dev_get_is_ready(_obj); }
@@ -1280,6 +1387,8 @@ namespace mapper {
          *  \return             The number of handled messages. */
         int poll(int block_ms=0) const
             { return mpr_graph_poll(_obj, block_ms); }
+        int next_timeout() const
+            { return mpr_graph_get_next_timeout(_obj); }
 
         // subscriptions
         /*! Subscribe to information about a specific Device.
@@ -1340,6 +1449,49 @@ namespace mapper {
             RETURN_SELF
         }
 
+        /*! Index Objects by the value of a Property, speeding up List filters on it.
+         *  \param type     The type of Objects to index.
+         *  \param prop     The Property to index.
+         *  \return         Self. */
+        const Graph& add_index(Type type, Property prop) const
+        {
+            mpr_graph_add_index(_obj, static_cast<int>(type), static_cast<mpr_prop>(prop), NULL);
+            RETURN_SELF
+        }
+
+        /*! Index Objects by the value of a named Property, speeding up List filters on it.
+         *  \param type     The type of Objects to index.
+         *  \param key      The name of the Property to index.
+         *  \return         Self. */
+        const Graph& add_index(Type type, const str_type &key) const
+            { mpr_graph_add_index(_obj, static_cast<int>(type), MPR_PROP_EXTRA, key); RETURN_SELF }
+
+        /*! Bound the memory used by records of remote Signals.
+         *  \param props    The Signal Properties to keep, or an empty list to keep all.
+         *  \param max_sigs The maximum number of remote Signals to keep, or 0 for no limit.
+         *  \return         Self. */
+        const Graph& set_retention(std::initializer_list<Property> props, int max_sigs = 0) const
+            { return set_retention(props, {}, max_sigs); }
+
+        /*! Bound the memory used by records of remote Signals.
+         *  \param props    The Signal Properties to keep.
+         *  \param keys     The names of the user-defined Signal properties to keep.
+         *  \param max_sigs The maximum number of remote Signals to keep, or 0 for no limit.
+         *  \return         Self. */
+        const Graph& set_retention(std::initializer_list<Property> props,
+                                   std::initializer_list<str_type> keys, int max_sigs = 0) const
+        {
+            std::vector<mpr_prop> _props;
+            std::vector<const char*> _keys;
+            for (auto p : props)
+                _props.push_back(static_cast<mpr_prop>(p));
+            for (auto k : keys)
+                _keys.push_back(k);
+            mpr_graph_set_retention(_obj, _props.size(), _props.data(), _keys.size(),
+                                    _keys.data(), max_sigs);
+            RETURN_SELF
+        }
+
         const Graph& print() const
             { mpr_graph_print(_obj); RETURN_SELF }
 
@@ -0,0 +1,20 @@
+
+package mapper.map;
+
+/*! Describes how repeated updates are coalesced before map output is sent. */
+public enum Coalesce {
+    NONE    (0),
+    LATEST  (1),
+    MEAN    (2),
+    MAX     (3);
+
+    Coalesce(int value) {
+        this._value = value;
+    }
+
+    public int value() {
+        return _value;
+    }
+
+    private int _value;
+}
@@ -5,7 +5,8 @@ package mapper.signal;
 public enum StealMode {
     NONE    (0),
     OLDEST  (1),
-    NEWEST  (2);
+    NEWEST  (2),
+    LEAST_RECENT (3);
 
     StealMode(int value) {
         this._value = value;
@@ -15,6 +15,10 @@
 
 #ifdef HAVE_PTHREAD
 #include <pthread.h>
+#include <sched.h>
+#elif defined(HAVE_WIN32_THREADS)
+#include <windows.h>
+#include <process.h>
 #endif
 
 extern const char* net_msg_strings[NUM_MSG_STRINGS];
@@ -23,9 +27,29 @@ extern const char* net_msg_strings[NUM_MSG_STRINGS];
 void mpr_dev_start_servers(mpr_local_dev dev);
 static void mpr_dev_remove_idmap(mpr_local_dev dev, int group, mpr_id_map rem);
 MPR_INLINE static int _process_outgoing_maps(mpr_local_dev dev);
+static void _init_queue(mpr_update_queue_t *q);
+static void _free_queue(mpr_update_queue_t *q);
+static int _process_queued_updates(mpr_local_dev dev);
+
+/* A background thread polling the device, see mpr_dev_start_polling(). */
+typedef struct _mpr_thread_data {
+    mpr_local_dev dev;
+    int block_ms;
+    uint32_t is_active;
+    uint32_t started;   /*!< Set once the thread handle has been stored. */
+#ifdef HAVE_PTHREAD
+    pthread_t thread;
+#elif defined(HAVE_WIN32_THREADS)
+    HANDLE thread;
+    unsigned thread_id;
+#endif
+} mpr_thread_data_t, *mpr_thread_data;
 
 mpr_time ts = {0,1};
 
+/* Maximum timeout while maps use TCP, see mpr_dev_get_timeout(). */
+#define MPR_TCP_POLL_MS 10
+
 static int cmp_qry_linked(const void *ctx, mpr_dev dev)
 {
     int i;
@@ -39,9 +63,20 @@ static int cmp_qry_linked(const void *ctx, mpr_dev dev)
 
 static int cmp_qry_dev_sigs(const void *context_data, mpr_sig sig)
 {
-    mpr_id dev_id = *(mpr_id*)context_data;
-    int dir = *(int*)((char*)context_data + sizeof(mpr_id));
-    return ((dir & sig->dir) && (dev_id == sig->dev->obj.id));
+    mpr_dev dev = *(mpr_dev*)context_data;
+    int dir = *(int*)((char*)context_data + sizeof(mpr_dev));
+    return ((dir & sig->dir) && (dev == sig->dev));
+}
+
+static mpr_sig next_dev_sig(const void *context_data, mpr_sig sig)
+{
+    return sig ? sig->next_dev_sig : (*(mpr_dev*)context_data)->sigs;
+}
+
+static mpr_list new_dev_sigs_query(mpr_dev dev, mpr_dir dir)
+{
+    return mpr_list_new_query_from((const void**)&dev->obj.graph->sigs, (void*)next_dev_sig,
+                                   (void*)cmp_qry_dev_sigs, "vi", &dev, dir);
 }
 
 void init_dev_prop_tbl(mpr_dev dev)
@@ -50,9 +85,9 @@ void init_dev_prop_tbl(mpr_dev dev)
     mpr_tbl tbl;
     mpr_list qry;
 
-    dev->obj.props.synced = mpr_tbl_new();
+    dev->obj.props.synced = mpr_tbl_new(&dev->obj.graph->keys);
     if (!dev->is_local)
-        dev->obj.props.staged = mpr_tbl_new();
+        dev->obj.props.staged = mpr_tbl_new(&dev->obj.graph->keys);
     tbl = dev->obj.props.synced;
 
     /* these properties need to be added in alphabetical order */
@@ -68,16 +103,19 @@ void init_dev_prop_tbl(mpr_dev dev)
     mpr_tbl_link(tbl, PROP(NUM_SIGS_OUT), 1, MPR_INT32, &dev->num_outputs, mod);
     mpr_tbl_link(tbl, PROP(ORDINAL), 1, MPR_INT32, &dev->ordinal, mod);
     if (!dev->is_local) {
-        qry = mpr_list_new_query((const void**)&dev->obj.graph->sigs, (void*)cmp_qry_dev_sigs,
-                                 "hi", dev->obj.id, MPR_DIR_ANY);
+        qry = new_dev_sigs_query(dev, MPR_DIR_ANY);
         mpr_tbl_link(tbl, PROP(SIG), 1, MPR_LIST, qry, NON_MODIFIABLE | PROP_OWNED);
     }
     mpr_tbl_link(tbl, PROP(STATUS), 1, MPR_INT32, &dev->status, mod | LOCAL_ACCESS_ONLY);
     mpr_tbl_link(tbl, PROP(SYNCED), 1, MPR_TIME, &dev->synced, mod | LOCAL_ACCESS_ONLY);
     mpr_tbl_link(tbl, PROP(VERSION), 1, MPR_INT32, &dev->obj.version, mod);
 
-    if (dev->is_local)
+    if (dev->is_local) {
+        int compact = 1;
         mpr_tbl_set(tbl, PROP(LIBVER), NULL, 1, MPR_STR, PACKAGE_VERSION, NON_MODIFIABLE);
+        /* advertise support for compact signal updates, can be disabled by the user */
+        mpr_tbl_set(tbl, PROP(EXTRA), MPR_COMPACT_DATA_KEY, 1, MPR_BOOL, &compact, LOCAL_MODIFY);
+    }
     mpr_tbl_set(tbl, PROP(IS_LOCAL), NULL, 1, MPR_BOOL, &dev->is_local,
                 LOCAL_ACCESS_ONLY | NON_MODIFIABLE);
 }
@@ -97,12 +135,18 @@ mpr_dev mpr_dev_new(const char *name_prefix, mpr_graph g)
         g->own = 0;
     }
 
-    dev = (mpr_local_dev)mpr_list_add_item((void**)&g->devs, sizeof(mpr_local_dev_t));
+    dev = (mpr_local_dev)mpr_list_add_item((void**)&g->devs, sizeof(mpr_local_dev_t), &g->pools);
     dev->obj.type = MPR_DEV;
     dev->obj.graph = g;
     dev->is_local = 1;
+    ++g->version;
 
     init_dev_prop_tbl((mpr_dev)dev);
+    mpr_graph_reindex_obj(g, (mpr_obj)dev);
+
+    /* subscribers cannot catch up from versions older than the device */
+    mpr_dev_record_change((mpr_obj)dev);
+    dev->sync_horizon = dev->obj.version;
 
     dev->prefix = strdup(name_prefix);
     mpr_dev_start_servers(dev);
@@ -116,14 +160,19 @@ mpr_dev mpr_dev_new(const char *name_prefix, mpr_graph g)
     g->net.rtr->dev = dev;
 
     dev->expr_stack = mpr_expr_stack_new();
+    _init_queue(&dev->queue);
 
     dev->ordinal_allocator.val = 1;
-    dev->idmaps.active = (mpr_id_map*) malloc(sizeof(mpr_id_map));
-    dev->idmaps.active[0] = 0;
+    dev->idmaps.active = (mpr_id_map_index) calloc(1, sizeof(mpr_id_map_index_t));
     dev->num_sig_groups = 1;
 
     mpr_net_add_dev(&g->net, dev);
 
+    /* subscribers holding versions from another run of this device need a full sync */
+    dev->session = g->net.random_id;
+    mpr_tbl_set(dev->obj.props.synced, MPR_PROP_EXTRA, MPR_SESSION_KEY, 1, MPR_INT32,
+                &dev->session, NON_MODIFIABLE);
+
     dev->status = MPR_STATUS_STAGED;
     return (mpr_dev)dev;
 }
@@ -135,12 +184,13 @@ void mpr_dev_free(mpr_dev dev)
     mpr_net net;
     mpr_local_dev ldev;
     mpr_list list;
-    int i;
+    int i, j;
     RETURN_UNLESS(dev && dev->is_local);
     if (!dev->obj.graph) {
         free(dev);
         return;
     }
+    mpr_dev_stop_polling(dev);
     ldev = (mpr_local_dev)dev;
     gph = dev->obj.graph;
     net = &gph->net;
@@ -189,6 +239,8 @@ void mpr_dev_free(mpr_dev dev)
             mpr_net_add_msg(net, 0, MSG_LOGOUT, msg);
             mpr_net_send(net);
         }
+        /* stop keeping tombstones for the remaining removals */
+        ldev->registered = 0;
     }
 
     /* Release links to other devices */
@@ -202,13 +254,14 @@ void mpr_dev_free(mpr_dev dev)
 
     /* Release device id maps */
     for (i = 0; i < ldev->num_sig_groups; i++) {
-        while (ldev->idmaps.active[i]) {
-            mpr_id_map map = ldev->idmaps.active[i];
-            ldev->idmaps.active[i] = map->next;
-            free(map);
-        }
+        mpr_id_map_index idx = &ldev->idmaps.active[i];
+        for (j = 0; j < idx->size; j++)
+            FUNC_IF(free, idx->by_LID[j]);
+        FUNC_IF(free, idx->by_LID);
+        FUNC_IF(free, idx->by_GID);
     }
     free(ldev->idmaps.active);
+    _free_queue(&ldev->queue);
 
     while (ldev->idmaps.reserve) {
         mpr_id_map map = ldev->idmaps.reserve;
@@ -220,11 +273,18 @@ void mpr_dev_free(mpr_dev dev)
         while (net->rtr->sigs) {
             mpr_rtr_sig rs = net->rtr->sigs;
             net->rtr->sigs = net->rtr->sigs->next;
+            FUNC_IF(free, rs->slots_by_id);
             free(rs);
         }
         free(net->rtr);
     }
 
+    while (ldev->tombstones) {
+        mpr_tombstone t = ldev->tombstones;
+        ldev->tombstones = t->next;
+        free(t);
+    }
+
     FUNC_IF(lo_server_free, net->servers[SERVER_UDP]);
     FUNC_IF(lo_server_free, net->servers[SERVER_TCP]);
     FUNC_IF(free, dev->prefix);
@@ -251,9 +311,9 @@ void mpr_dev_on_registered(mpr_local_dev dev)
                 idmap->GID |= dev->obj.id;
         }
         sig->obj.id |= dev->obj.id;
+        mpr_graph_reindex_obj(dev->obj.graph, (mpr_obj)sig);
     }
-    qry = mpr_list_new_query((const void**)&dev->obj.graph->sigs, (void*)cmp_qry_dev_sigs,
-                             "hi", dev->obj.id, MPR_DIR_ANY);
+    qry = new_dev_sigs_query((mpr_dev)dev, MPR_DIR_ANY);
     mpr_tbl_set(dev->obj.props.synced, PROP(SIG), NULL, 1, MPR_LIST, qry,
                 NON_MODIFIABLE | PROP_OWNED);
     dev->registered = 1;
@@ -261,10 +321,15 @@ void mpr_dev_on_registered(mpr_local_dev dev)
     dev->status = MPR_STATUS_READY;
 }
 
-MPR_INLINE static int check_types(const mpr_type *types, int len, mpr_type type, int vector_len)
+/* If all elements are already known to share one type (e.g. compact updates) it can be passed
+ * as the argument 'uniform' to skip checking each element. */
+MPR_INLINE static int check_types(const mpr_type *types, int len, mpr_type type, int vector_len,
+                                  mpr_type uniform)
 {
     int i, vals = 0;
     RETURN_ARG_UNLESS(len >= vector_len, -1);
+    if (uniform)
+        return uniform == type ? len : -1;
     for (i = 0; i < len; i++) {
         if (types[i] == type)
             ++vals;
@@ -280,6 +345,69 @@ int mpr_dev_bundle_start(lo_timetag t, void *data)
     return 0;
 }
 
+static void _swap_bytes(void *val, int size)
+{
+    int i;
+    char tmp, *c = (char*)val;
+    for (i = 0; i < size / 2; i++) {
+        tmp = c[i];
+        c[i] = c[size - 1 - i];
+        c[size - 1 - i] = tmp;
+    }
+}
+
+/* Unpack a compact signal update, converting the blob to host byte order in place. Sparse
+ * updates also return the vector index of each packed value.
+ * Returns the number of packed values, or -1 if the blob is malformed. */
+static int _unpack_compact(lo_arg *arg, mpr_compact_hdr_t *hdr, char **vec, uint16_t **indices)
+{
+    int i, num, size, swap;
+    /* received blobs are stored inline in the argument */
+    char *data = &arg->blob.data;
+    int data_size = arg->blob.size;
+    RETURN_ARG_UNLESS(data_size >= (int)sizeof(mpr_compact_hdr_t), -1);
+
+    memcpy(hdr, data, sizeof(mpr_compact_hdr_t));
+    swap = !(hdr->flags & MPR_COMPACT_BIG_ENDIAN) != !mpr_get_is_big_endian();
+    if (swap) {
+        _swap_bytes(&hdr->len, sizeof(hdr->len));
+        _swap_bytes(&hdr->slot, sizeof(hdr->slot));
+        _swap_bytes(&hdr->GID, sizeof(hdr->GID));
+    }
+    RETURN_ARG_UNLESS(mpr_type_get_is_num(hdr->type) && hdr->len, -1);
+    size = mpr_type_get_size(hdr->type);
+    data_size -= sizeof(mpr_compact_hdr_t);
+    *vec = data + sizeof(mpr_compact_hdr_t);
+    *indices = 0;
+    if (hdr->flags & MPR_COMPACT_SPARSE) {
+        num = data_size / (size + sizeof(uint16_t));
+        RETURN_ARG_UNLESS(num > 0 && num < hdr->len
+                          && data_size == num * (size + (int)sizeof(uint16_t)), -1);
+        *indices = (uint16_t*)(*vec + num * size);
+    }
+    else {
+        num = hdr->len;
+        RETURN_ARG_UNLESS(data_size == num * size, -1);
+    }
+
+    if (swap) {
+        for (i = 0; i < num; i++)
+            _swap_bytes(*vec + i * size, size);
+        if (*indices) {
+            for (i = 0; i < num; i++)
+                _swap_bytes(*indices + i, sizeof(uint16_t));
+        }
+        /* store converted header in case the message is dispatched again */
+        hdr->flags ^= MPR_COMPACT_BIG_ENDIAN;
+        memcpy(data, hdr, sizeof(mpr_compact_hdr_t));
+    }
+    if (*indices) {
+        for (i = 0; i < num; i++)
+            RETURN_ARG_UNLESS((*indices)[i] < hdr->len, -1);
+    }
+    return num;
+}
+
 /* Notes:
  * - Incoming signal values may be scalars or vectors, but much match the
  *   length of the target signal or mapping slot.
@@ -309,6 +437,7 @@ int mpr_dev_handler(const char *path, const char *types, lo_arg **argv, int argc
     mpr_id_map idmap;
     mpr_local_map map = 0;
     mpr_local_slot slot = 0;
+    mpr_type uniform = 0;
     float diff;
 
     TRACE_RETURN_UNLESS(sig && (dev = sig->dev), 0,
@@ -316,33 +445,63 @@ int mpr_dev_handler(const char *path, const char *types, lo_arg **argv, int argc
     TRACE_DEV_RETURN_UNLESS(sig->num_inst, 0, "signal '%s' has no instances.\n", sig->name);
     RETURN_ARG_UNLESS(argc, 0);
 
-    /* We need to consider that there may be properties appended to the msg
-     * check length and find properties if any */
-    while (val_len < argc && types[val_len] != MPR_STR)
-        ++val_len;
-    i = val_len;
-    while (i < argc) {
-        /* Parse any attached properties (instance ids, slot number) */
-        TRACE_DEV_RETURN_UNLESS(types[i] == MPR_STR, 0, "error in "
-                                "mpr_dev_handler: unexpected argument type.\n")
-        if ((strcmp(&argv[i]->s, "@in") == 0) && argc >= i + 2) {
-            TRACE_DEV_RETURN_UNLESS(types[i+1] == MPR_INT64, 0, "error in "
+    if (1 == argc && LO_BLOB == types[0]) {
+        /* compact update: the instance id, slot id and packed vector are stored in a blob */
+        mpr_compact_hdr_t hdr;
+        char *vec, *vec_types;
+        uint16_t *indices;
+        int num = _unpack_compact(argv[0], &hdr, &vec, &indices);
+        TRACE_DEV_RETURN_UNLESS(num > 0, 0, "error in mpr_dev_handler: "
+                                "malformed compact update.\n");
+        size = mpr_type_get_size(hdr.type);
+        argc = hdr.len;
+        vec_types = alloca(argc * sizeof(char));
+        argv = alloca(argc * sizeof(lo_arg*));
+        if (indices) {
+            /* expand sparse update to a partial vector */
+            memset(vec_types, MPR_NULL, argc);
+            memset(argv, 0, argc * sizeof(lo_arg*));
+            for (i = 0; i < num; i++) {
+                vec_types[indices[i]] = hdr.type;
+                argv[indices[i]] = (lo_arg*)(vec + i * size);
+            }
+        }
+        else {
+            memset(vec_types, hdr.type, argc);
+            for (i = 0; i < argc; i++)
+                argv[i] = (lo_arg*)(vec + i * size);
+            uniform = hdr.type;
+        }
+        types = vec_types;
+        if (hdr.flags & MPR_COMPACT_HAS_INST)
+            GID = hdr.GID;
+        if (hdr.flags & MPR_COMPACT_HAS_SLOT)
+            slot_idx = hdr.slot;
+    }
+
+    /* Properties (instance id, slot id) are appended to the message as key/value pairs, so we
+     * parse them backwards from the end instead of scanning the vector for the first string. OSC
+     * pads strings to 4-byte boundaries so each key can be matched as a single 32-bit word. */
+    val_len = argc;
+    while (val_len >= 2 && MPR_STR == types[val_len - 2]) {
+        lo_arg *key = argv[val_len - 2], *val = argv[val_len - 1];
+        if (0 == memcmp(&key->s, "@in", 4)) {
+            TRACE_DEV_RETURN_UNLESS(types[val_len - 1] == MPR_INT64, 0, "error in "
                                     "mpr_dev_handler: bad arguments for 'instance' prop.\n")
-            GID = argv[i+1]->i64;
-            i += 2;
+            GID = val->i64;
         }
-        else if ((strcmp(&argv[i]->s, "@sl") == 0) && argc >= i + 2) {
-            TRACE_DEV_RETURN_UNLESS(types[i+1] == MPR_INT32, 0, "error in "
+        else if (0 == memcmp(&key->s, "@sl", 4)) {
+            TRACE_DEV_RETURN_UNLESS(types[val_len - 1] == MPR_INT32, 0, "error in "
                                     "mpr_dev_handler: bad arguments for 'slot' prop.\n")
-            slot_idx = argv[i+1]->i32;
-            i += 2;
+            slot_idx = val->i32;
         }
         else {
 #ifdef DEBUG
-            trace_dev(dev, "error in mpr_dev_handler: unknown property name '%s'.\n", &argv[i]->s);
+            trace_dev(dev, "error in mpr_dev_handler: unknown property name '%s'.\n", &key->s);
 #endif
             return 0;
         }
+        val_len -= 2;
     }
 
     if (slot_idx >= 0) {
@@ -353,17 +512,17 @@ int mpr_dev_handler(const char *path, const char *types, lo_arg **argv, int argc
         TRACE_DEV_RETURN_UNLESS(map->status >= MPR_STATUS_READY, 0, "error in mpr_dev_handler: "
                                 "mapping not yet ready.\n");
         if (map->expr && !map->is_local_only) {
-            vals = check_types(types, val_len, slot->sig->type, slot->sig->len);
+            vals = check_types(types, val_len, slot->sig->type, slot->sig->len, uniform);
             map_manages_inst = mpr_expr_get_manages_inst(map->expr);
         }
         else {
             /* value has already been processed at source device */
             map = 0;
-            vals = check_types(types, val_len, sig->type, sig->len);
+            vals = check_types(types, val_len, sig->type, sig->len, uniform);
         }
     }
     else
-        vals = check_types(types, val_len, sig->type, sig->len);
+        vals = check_types(types, val_len, sig->type, sig->len, uniform);
     RETURN_ARG_UNLESS(vals >= 0, 0);
 
     /* TODO: optionally discard out-of-order messages
@@ -405,7 +564,7 @@ int mpr_dev_handler(const char *path, const char *types, lo_arg **argv, int argc
             if (0 == vals) {
                 /* we can clear signal's reference to map */
                 idmap = sig->idmaps[idmap_idx].map;
-                sig->idmaps[idmap_idx].map = 0;
+                mpr_sig_clear_idmap(sig, idmap_idx);
                 mpr_dev_GID_decref(dev, sig->group, idmap);
             }
             return 0;
@@ -416,8 +575,10 @@ int mpr_dev_handler(const char *path, const char *types, lo_arg **argv, int argc
     else {
         /* use the first available instance */
         idmap_idx = 0;
-        if (!sig->idmaps[0].inst)
-            idmap_idx = mpr_sig_get_idmap_with_LID(sig, sig->inst[0]->id, 1, ts, 1);
+        if (!sig->idmaps[0].inst) {
+            mpr_id id = mpr_sig_get_inst_by_idx(sig, sig->inst_order[0])->id;
+            idmap_idx = mpr_sig_get_idmap_with_LID(sig, id, 1, ts, 1);
+        }
         RETURN_ARG_UNLESS(idmap_idx >= 0, 0);
     }
     si = sig->idmaps[idmap_idx].inst;
@@ -434,8 +595,8 @@ int mpr_dev_handler(const char *path, const char *types, lo_arg **argv, int argc
             if (!sig->use_inst) {
                 /* clear signal's reference to idmap */
                 mpr_dev_LID_decref(dev, sig->group, idmap);
-                sig->idmaps[idmap_idx].map = 0;
-                sig->idmaps[idmap_idx].inst->active = 0;
+                mpr_sig_clear_idmap(sig, idmap_idx);
+                mpr_sig_deactivate_inst(sig, sig->idmaps[idmap_idx].inst);
                 sig->idmaps[idmap_idx].inst = 0;
                 return 0;
             }
@@ -512,11 +673,14 @@ int mpr_dev_handler(const char *path, const char *types, lo_arg **argv, int argc
                 si->has_val = 1;
             if (si->has_val) {
                 memcpy(&si->time, &ts, sizeof(mpr_time));
+                mpr_sig_touch_inst(sig, si);
                 mpr_sig_call_handler(sig, MPR_SIG_UPDATE, idmap->LID, sig->len, si->val, &ts, diff);
+                /* The handler may have released or removed the instance. */
+                si = sig->idmaps[idmap_idx].inst;
                 /* Pass this update downstream if signal is an input and was not updated in handler. */
-                if (   !(sig->dir & MPR_DIR_OUT)
+                if (   si && !(sig->dir & MPR_DIR_OUT)
                     && !get_bitflag(sig->updated_inst, si->idx)) {
-                    mpr_rtr_process_sig(rtr, sig, idmap_idx, si->val, ts);
+                    mpr_rtr_process_sig(rtr, sig, idmap_idx, si->val, types, ts);
                     /* TODO: ensure update is propagated within this poll cycle */
                 }
             }
@@ -578,61 +742,110 @@ void mpr_dev_remove_sig_methods(mpr_local_dev dev, mpr_local_sig sig)
 
 mpr_list mpr_dev_get_sigs(mpr_dev dev, mpr_dir dir)
 {
-    mpr_list qry;
-    RETURN_ARG_UNLESS(dev && dev->obj.graph->sigs, 0);
-    qry = mpr_list_new_query((const void**)&dev->obj.graph->sigs,
-                             (void*)cmp_qry_dev_sigs, "hi", dev->obj.id, dir);
-    return mpr_list_start(qry);
+    RETURN_ARG_UNLESS(dev && dev->sigs, 0);
+    return mpr_list_start(new_dev_sigs_query(dev, dir));
+}
+
+void mpr_dev_add_sig_ref(mpr_dev dev, mpr_sig sig)
+{
+    sig->next_dev_sig = dev->sigs;
+    dev->sigs = sig;
+}
+
+void mpr_dev_remove_sig_ref(mpr_dev dev, mpr_sig sig)
+{
+    mpr_sig *ptr = &dev->sigs;
+    while (*ptr) {
+        if (*ptr == sig) {
+            *ptr = sig->next_dev_sig;
+            break;
+        }
+        ptr = &(*ptr)->next_dev_sig;
+    }
+    sig->next_dev_sig = 0;
 }
 
 mpr_sig mpr_dev_get_sig_by_name(mpr_dev dev, const char *sig_name)
 {
-    mpr_list sigs;
     RETURN_ARG_UNLESS(dev && sig_name, 0);
-    sigs = mpr_list_from_data(dev->obj.graph->sigs);
-    while (sigs) {
-        mpr_sig sig = (mpr_sig)*sigs;
-        if ((sig->dev == dev) && strcmp(sig->name, skip_slash(sig_name))==0)
-            return sig;
-        sigs = mpr_list_get_next(sigs);
-    }
-    return 0;
+    return mpr_graph_get_sig_by_name(dev->obj.graph, dev, sig_name);
 }
 
 static int cmp_qry_dev_maps(const void *context_data, mpr_map map)
 {
-    mpr_id dev_id = *(mpr_id*)context_data;
-    mpr_dir dir = *(int*)((char*)context_data + sizeof(mpr_id));
+    mpr_dev dev = *(mpr_dev*)context_data;
+    mpr_dir dir = *(int*)((char*)context_data + sizeof(mpr_dev));
     int i;
     if (dir == MPR_DIR_BOTH) {
-        RETURN_ARG_UNLESS(map->dst->sig->dev->obj.id == dev_id, 0);
+        RETURN_ARG_UNLESS(map->dst->sig->dev == dev, 0);
         for (i = 0; i < map->num_src; i++)
-            RETURN_ARG_UNLESS(map->src[i]->sig->dev->obj.id == dev_id, 0);
+            RETURN_ARG_UNLESS(map->src[i]->sig->dev == dev, 0);
         return 1;
     }
     if (dir & MPR_DIR_OUT) {
         for (i = 0; i < map->num_src; i++)
-            RETURN_ARG_UNLESS(map->src[i]->sig->dev->obj.id != dev_id, 1);
+            RETURN_ARG_UNLESS(map->src[i]->sig->dev != dev, 1);
     }
     if (dir & MPR_DIR_IN)
-        RETURN_ARG_UNLESS(map->dst->sig->dev->obj.id != dev_id, 1);
+        RETURN_ARG_UNLESS(map->dst->sig->dev != dev, 1);
+    return 0;
+}
+
+/* A map can use several signals of the same device, so it is only returned for the first of
+ * its slots belonging to the device. */
+static mpr_slot first_dev_slot(mpr_map map, mpr_dev dev)
+{
+    int i;
+    if (map->dst->sig->dev == dev)
+        return map->dst;
+    for (i = 0; i < map->num_src; i++) {
+        if (map->src[i]->sig->dev == dev)
+            return map->src[i];
+    }
+    return 0;
+}
+
+/* Walk the maps of each of the device's signals. */
+static mpr_map next_dev_map(const void *context_data, mpr_map map)
+{
+    mpr_dev dev = *(mpr_dev*)context_data;
+    mpr_sig sig;
+    mpr_slot slot;
+    if (map) {
+        slot = first_dev_slot(map, dev);
+        RETURN_ARG_UNLESS(slot, 0);
+        sig = slot->sig;
+        slot = slot->next_sig_slot;
+    }
+    else {
+        sig = dev->sigs;
+        slot = sig ? sig->slots : 0;
+    }
+    while (sig) {
+        for (; slot; slot = slot->next_sig_slot) {
+            if (slot == first_dev_slot(slot->map, dev))
+                return slot->map;
+        }
+        sig = sig->next_dev_sig;
+        slot = sig ? sig->slots : 0;
+    }
     return 0;
 }
 
 mpr_list mpr_dev_get_maps(mpr_dev dev, mpr_dir dir)
 {
     mpr_list qry;
-    RETURN_ARG_UNLESS(dev && dev->obj.graph->maps, 0);
-    qry = mpr_list_new_query((const void**)&dev->obj.graph->maps,
-                             (void*)cmp_qry_dev_maps, "hi", dev->obj.id, dir);
+    RETURN_ARG_UNLESS(dev && dev->sigs && dev->obj.graph->maps, 0);
+    qry = mpr_list_new_query_from((const void**)&dev->obj.graph->maps, (void*)next_dev_map,
+                                  (void*)cmp_qry_dev_maps, "vi", &dev, dir);
     return mpr_list_start(qry);
 }
 
 static int cmp_qry_dev_links(const void *context_data, mpr_link link)
 {
-    mpr_id dev_id = *(mpr_id*)context_data;
-    mpr_dir dir = *(int*)((char*)context_data + sizeof(mpr_id));
-    if (link->devs[0]->obj.id == dev_id) {
+    mpr_dev dev = *(mpr_dev*)context_data;
+    mpr_dir dir = *(int*)((char*)context_data + sizeof(mpr_dev));
+    if (link->devs[0] == dev) {
         switch (dir) {
             case MPR_DIR_BOTH:  return link->num_maps[0] && link->num_maps[1];
             case MPR_DIR_IN:    return link->num_maps[1];
@@ -640,7 +853,7 @@ static int cmp_qry_dev_links(const void *context_data, mpr_link link)
             default:            return 1;
         }
     }
-    else if (link->devs[1]->obj.id == dev_id) {
+    else if (link->devs[1] == dev) {
         switch (dir) {
             case MPR_DIR_BOTH:  return link->num_maps[0] && link->num_maps[1];
             case MPR_DIR_IN:    return link->num_maps[0];
@@ -651,27 +864,55 @@ static int cmp_qry_dev_links(const void *context_data, mpr_link link)
     return 0;
 }
 
+static mpr_link next_dev_link(const void *context_data, mpr_link link)
+{
+    mpr_dev dev = *(mpr_dev*)context_data;
+    if (!link)
+        return dev->links;
+    return link->next_dev_link[link->devs[0] == dev ? 0 : 1];
+}
+
 mpr_list mpr_dev_get_links(mpr_dev dev, mpr_dir dir)
 {
     mpr_list qry;
-    RETURN_ARG_UNLESS(dev && dev->obj.graph->links, 0);
-    qry = mpr_list_new_query((const void**)&dev->obj.graph->links,
-                             (void*)cmp_qry_dev_links, "hi", dev->obj.id, dir);
+    RETURN_ARG_UNLESS(dev && dev->links, 0);
+    qry = mpr_list_new_query_from((const void**)&dev->obj.graph->links, (void*)next_dev_link,
+                                  (void*)cmp_qry_dev_links, "vi", &dev, dir);
     return mpr_list_start(qry);
 }
 
+void mpr_dev_add_link_ref(mpr_dev dev, mpr_link link)
+{
+    int idx = link->devs[0] == dev ? 0 : 1;
+    link->next_dev_link[idx] = dev->links;
+    dev->links = link;
+}
+
+void mpr_dev_remove_link_ref(mpr_dev dev, mpr_link link)
+{
+    mpr_link *ptr = &dev->links;
+    int idx = link->devs[0] == dev ? 0 : 1;
+    while (*ptr) {
+        if (*ptr == link) {
+            *ptr = link->next_dev_link[idx];
+            break;
+        }
+        ptr = &(*ptr)->next_dev_link[(*ptr)->devs[0] == dev ? 0 : 1];
+    }
+    link->next_dev_link[idx] = 0;
+}
+
 mpr_link mpr_dev_get_link_by_remote(mpr_local_dev dev, mpr_dev remote)
 {
-    mpr_list links;
+    mpr_link link;
     RETURN_ARG_UNLESS(dev, 0);
-    links = mpr_list_from_data(dev->obj.graph->links);
-    while (links) {
-        mpr_link link = (mpr_link)*links;
+    link = dev->links;
+    while (link) {
         if (link->devs[0] == (mpr_dev)dev && link->devs[1] == remote)
             return link;
         if (link->devs[1] == (mpr_dev)dev && link->devs[0] == remote)
             return link;
-        links = mpr_list_get_next(links);
+        link = link->next_dev_link[link->devs[0] == (mpr_dev)dev ? 0 : 1];
     }
     return 0;
 }
@@ -704,16 +945,17 @@ MPR_INLINE static int _process_outgoing_maps(mpr_local_dev dev)
     RETURN_ARG_UNLESS(dev->sending, 0);
 
     graph = dev->obj.graph;
+    /* rate-limited maps may flag the device again if output is still held back */
+    dev->sending = 0;
     /* process and send updated maps */
     /* TODO: speed this up! */
     list = mpr_list_from_data(graph->maps);
     while (list) {
         mpr_local_map map = *(mpr_local_map*)list;
         list = mpr_list_get_next(list);
-        if (map->is_local && map->updated && map->expr && !map->muted)
+        if (map->is_local && map->updated && !map->muted)
             mpr_map_send(map, dev->time);
     }
-    dev->sending = 0;
     list = mpr_list_from_data(graph->links);
     while (list) {
         msgs += mpr_link_process_bundles((mpr_link)*list, dev->time, 0);
@@ -729,13 +971,13 @@ void mpr_dev_update_maps(mpr_dev dev) {
         _process_outgoing_maps((mpr_local_dev)dev);
 }
 
-int mpr_dev_poll(mpr_dev dev, int block_ms)
+/* Handle messages and process maps for a device, the caller is responsible for calling
+ * mpr_net_poll() first. */
+static int _poll_dev(mpr_dev dev, int block_ms)
 {
     int admin_count = 0, device_count = 0, status[4];
-    mpr_net net;
-    RETURN_ARG_UNLESS(dev && dev->is_local, 0);
-    net = &dev->obj.graph->net;
-    mpr_net_poll(net);
+    mpr_net net = &dev->obj.graph->net;
+    _process_queued_updates((mpr_local_dev)dev);
 
     if (!((mpr_local_dev)dev)->registered) {
         if (lo_servers_recv_noblock(&net->servers[SERVER_ADMIN], status, 2, block_ms)) {
@@ -772,6 +1014,7 @@ int mpr_dev_poll(mpr_dev dev, int block_ms)
                 device_count += (status[2] > 0) + (status[3] > 0);
             }
             /* check if any signal update bundles need to be sent */
+            _process_queued_updates((mpr_local_dev)dev);
             _process_incoming_maps((mpr_local_dev)dev);
             _process_outgoing_maps((mpr_local_dev)dev);
             ((mpr_local_dev)dev)->polling = 0;
@@ -809,6 +1052,186 @@ int mpr_dev_poll(mpr_dev dev, int block_ms)
     return admin_count + device_count;
 }
 
+int mpr_dev_poll(mpr_dev dev, int block_ms)
+{
+    RETURN_ARG_UNLESS(dev && dev->is_local, 0);
+    /* the background thread owns polling while it is running */
+    RETURN_ARG_UNLESS(!((mpr_local_dev)dev)->thread_data, 0);
+    mpr_net_poll(&dev->obj.graph->net);
+    return _poll_dev(dev, block_ms);
+}
+
+int mpr_dev_process_ready(mpr_dev dev)
+{
+    mpr_graph g;
+    mpr_time t;
+    RETURN_ARG_UNLESS(dev && dev->is_local, 0);
+    RETURN_ARG_UNLESS(!((mpr_local_dev)dev)->thread_data, 0);
+    g = dev->obj.graph;
+
+    /* only run housekeeping when it is due */
+    mpr_time_set(&t, MPR_NOW);
+    if (!mpr_graph_get_housekeeping_timeout(g, mpr_time_as_dbl(t)))
+        mpr_graph_housekeeping(g);
+    return _poll_dev(dev, 0);
+}
+
+int mpr_dev_get_fds(mpr_dev dev, int *fds, int num)
+{
+    int i, count = 0;
+    mpr_net net;
+    RETURN_ARG_UNLESS(dev && dev->is_local, 0);
+    net = &dev->obj.graph->net;
+    for (i = 0; i < 4; i++) {
+        int fd;
+        if (!net->servers[i] || (fd = lo_server_get_socket_fd(net->servers[i])) < 0)
+            continue;
+        if (fds && count < num)
+            fds[count] = fd;
+        ++count;
+    }
+    return count;
+}
+
+int mpr_dev_get_timeout(mpr_local_dev dev, mpr_time now, int max_ms)
+{
+    int i, ms = max_ms, held = 0;
+    mpr_net net = &dev->obj.graph->net;
+    mpr_update_queue_t *q = &dev->queue;
+    double delay;
+    mpr_list maps;
+
+    /* updates queued from other threads */
+    if (q->slots && mpr_atomic_load(&q->slots[q->tail & (MPR_QUEUE_SIZE - 1)].seq) == q->tail + 1)
+        return 0;
+    RETURN_ARG_UNLESS(!dev->receiving, 0);
+
+    maps = mpr_list_from_data(dev->obj.graph->maps);
+    while (maps) {
+        mpr_local_map map = *(mpr_local_map*)maps;
+        maps = mpr_list_get_next(maps);
+        if (!map->is_local)
+            continue;
+        /* outgoing updates, possibly held back by rate limiting */
+        if (dev->sending && map->updated && !map->muted) {
+            RETURN_ARG_UNLESS((delay = mpr_map_get_send_delay(map, now)) > 0, 0);
+            held = 1;
+            if (delay * 1000 < ms)
+                ms = (int)(delay * 1000) + 1;
+        }
+        /* sockets accepted by the TCP server are not exposed by liblo */
+        if (MPR_PROTO_TCP == map->protocol && ms > MPR_TCP_POLL_MS)
+            ms = MPR_TCP_POLL_MS;
+    }
+    /* anything else flagged for sending is due now */
+    RETURN_ARG_UNLESS(!dev->sending || held, 0);
+
+    /* messages held by liblo until their timetag */
+    for (i = SERVER_DEVICE; i < 4; i++) {
+        if (net->servers[i]) {
+            delay = lo_server_next_event_delay(net->servers[i]);
+            if (delay * 1000 < ms)
+                ms = delay > 0 ? (int)(delay * 1000) + 1 : 0;
+        }
+    }
+    return ms;
+}
+
+static void _yield_thread()
+{
+#ifdef HAVE_PTHREAD
+    sched_yield();
+#elif defined(HAVE_WIN32_THREADS)
+    SwitchToThread();
+#endif
+}
+
+#if defined(HAVE_PTHREAD) || defined(HAVE_WIN32_THREADS)
+#ifdef HAVE_PTHREAD
+static void *_poll_thread(void *data)
+#else
+static unsigned __stdcall _poll_thread(void *data)
+#endif
+{
+    mpr_thread_data td = (mpr_thread_data)data;
+    /* wait until the creating thread has stored our handle, since mpr_dev_get_is_poll_thread()
+     * reads it from here on */
+    while (!mpr_atomic_load(&td->started))
+        _yield_thread();
+    while (mpr_atomic_load(&td->is_active)) {
+        mpr_net_poll(&td->dev->obj.graph->net);
+        _poll_dev((mpr_dev)td->dev, td->block_ms);
+    }
+    return 0;
+}
+#endif
+
+int mpr_dev_start_polling(mpr_dev dev, int block_ms)
+{
+    mpr_local_dev ldev = (mpr_local_dev)dev;
+    mpr_thread_data td;
+    RETURN_ARG_UNLESS(dev && dev->is_local, 1);
+    RETURN_ARG_UNLESS(!ldev->thread_data, 0);
+
+    td = (mpr_thread_data) calloc(1, sizeof(mpr_thread_data_t));
+    td->dev = ldev;
+    /* never spin without blocking on the sockets */
+    td->block_ms = block_ms > 0 ? block_ms : 1;
+    td->is_active = 1;
+    ldev->thread_data = td;
+
+#ifdef HAVE_PTHREAD
+    if (!pthread_create(&td->thread, 0, _poll_thread, td)) {
+        mpr_atomic_store(&td->started, 1);
+        return 0;
+    }
+#elif defined(HAVE_WIN32_THREADS)
+    td->thread = (HANDLE)_beginthreadex(NULL, 0, &_poll_thread, td, 0, &td->thread_id);
+    if (td->thread) {
+        mpr_atomic_store(&td->started, 1);
+        return 0;
+    }
+#endif
+    trace_dev(ldev, "could not start polling thread.\n");
+    ldev->thread_data = 0;
+    free(td);
+    return 1;
+}
+
+int mpr_dev_stop_polling(mpr_dev dev)
+{
+    mpr_local_dev ldev = (mpr_local_dev)dev;
+    mpr_thread_data td;
+    RETURN_ARG_UNLESS(dev && dev->is_local, 1);
+    td = ldev->thread_data;
+    RETURN_ARG_UNLESS(td, 0);
+    RETURN_ARG_UNLESS(!mpr_dev_get_is_poll_thread(ldev), 1);
+
+    mpr_atomic_store(&td->is_active, 0);
+#ifdef HAVE_PTHREAD
+    pthread_join(td->thread, NULL);
+#elif defined(HAVE_WIN32_THREADS)
+    WaitForSingleObject(td->thread, INFINITE);
+    CloseHandle(td->thread);
+#endif
+    ldev->thread_data = 0;
+    free(td);
+    return 0;
+}
+
+int mpr_dev_get_is_poll_thread(mpr_local_dev dev)
+{
+    mpr_thread_data td = dev->thread_data;
+    RETURN_ARG_UNLESS(td, 0);
+#ifdef HAVE_PTHREAD
+    return pthread_equal(pthread_self(), td->thread);
+#elif defined(HAVE_WIN32_THREADS)
+    return GetCurrentThreadId() == td->thread_id;
+#else
+    return 0;
+#endif
+}
+
 mpr_time mpr_dev_get_time(mpr_dev dev)
 {
     RETURN_ARG_UNLESS(dev && dev->is_local, MPR_NOW);
@@ -835,9 +1258,80 @@ void mpr_dev_reserve_idmap(mpr_local_dev dev)
     dev->idmaps.reserve = map;
 }
 
+/* Active id maps are indexed by LID and by GID in open-addressed hash tables using linear
+ * probing.  A map is inserted ahead of any older map with the same key so that lookups find
+ * the most recently added one first. */
+MPR_INLINE static mpr_id _idmap_key(mpr_id_map map, int by_GID)
+{
+    return by_GID ? map->GID : map->LID;
+}
+
+static void _index_idmap(mpr_id_map *tbl, int size, mpr_id_map map, int by_GID, int ahead)
+{
+    int i, mask = size - 1;
+    mpr_id key = _idmap_key(map, by_GID);
+    mpr_id_map tmp;
+    for (i = mpr_hash_id(key, size); tbl[i]; i = (i + 1) & mask) {
+        if (ahead && _idmap_key(tbl[i], by_GID) == key) {
+            /* take the place of the older map and carry it further along */
+            tmp = tbl[i];
+            tbl[i] = map;
+            map = tmp;
+        }
+    }
+    tbl[i] = map;
+}
+
+static int _unindex_idmap(mpr_id_map *tbl, int size, mpr_id_map map, int by_GID)
+{
+    int i, j, k, mask = size - 1;
+    RETURN_ARG_UNLESS(size, 0);
+    for (i = mpr_hash_id(_idmap_key(map, by_GID), size); tbl[i] != map; i = (i + 1) & mask)
+        RETURN_ARG_UNLESS(tbl[i], 0);
+    /* shift back following entries that would otherwise become unreachable */
+    for (j = (i + 1) & mask; tbl[j]; j = (j + 1) & mask) {
+        k = mpr_hash_id(_idmap_key(tbl[j], by_GID), size);
+        if (i <= j ? (k <= i || k > j) : (k <= i && k > j)) {
+            tbl[i] = tbl[j];
+            i = j;
+        }
+    }
+    tbl[i] = 0;
+    return 1;
+}
+
+static mpr_id_map *_reindex_idmaps(mpr_id_map *old, int old_size, int size, int by_GID)
+{
+    int i = 0, j;
+    mpr_id_map *tbl = (mpr_id_map*) calloc(size, sizeof(mpr_id_map));
+    RETURN_ARG_UNLESS(old, tbl);
+    /* start after an empty slot so that maps sharing a key are reinserted in probe order */
+    while (old[i])
+        ++i;
+    for (j = 1; j <= old_size; j++) {
+        mpr_id_map map = old[(i + j) & (old_size - 1)];
+        if (map)
+            _index_idmap(tbl, size, map, by_GID, 0);
+    }
+    free(old);
+    return tbl;
+}
+
+static mpr_id_map _find_idmap(mpr_id_map *tbl, int size, mpr_id key, int by_GID)
+{
+    int i;
+    RETURN_ARG_UNLESS(size, 0);
+    for (i = mpr_hash_id(key, size); tbl[i]; i = (i + 1) & (size - 1)) {
+        if (_idmap_key(tbl[i], by_GID) == key)
+            return tbl[i];
+    }
+    return 0;
+}
+
 mpr_id_map mpr_dev_add_idmap(mpr_local_dev dev, int group, mpr_id LID, mpr_id GID)
 {
     mpr_id_map map;
+    mpr_id_map_index idx = &dev->idmaps.active[group];
     if (!dev->idmaps.reserve)
         mpr_dev_reserve_idmap(dev);
     map = dev->idmaps.reserve;
@@ -846,23 +1340,28 @@ mpr_id_map mpr_dev_add_idmap(mpr_local_dev dev, int group, mpr_id LID, mpr_id GI
     map->LID_refcount = 1;
     map->GID_refcount = 0;
     dev->idmaps.reserve = map->next;
-    map->next = dev->idmaps.active[group];
-    dev->idmaps.active[group] = map;
+    map->next = 0;
+
+    if ((idx->count + 1) * 2 > idx->size) {
+        int size = idx->size ? idx->size * 2 : 16;
+        idx->by_LID = _reindex_idmaps(idx->by_LID, idx->size, size, 0);
+        idx->by_GID = _reindex_idmaps(idx->by_GID, idx->size, size, 1);
+        idx->size = size;
+    }
+    _index_idmap(idx->by_LID, idx->size, map, 0, 1);
+    _index_idmap(idx->by_GID, idx->size, map, 1, 1);
+    ++idx->count;
     return map;
 }
 
 static void mpr_dev_remove_idmap(mpr_local_dev dev, int group, mpr_id_map rem)
 {
-    mpr_id_map *map = &dev->idmaps.active[group];
-    while (*map) {
-        if ((*map) == rem) {
-            *map = (*map)->next;
-            rem->next = dev->idmaps.reserve;
-            dev->idmaps.reserve = rem;
-            break;
-        }
-        map = &(*map)->next;
-    }
+    mpr_id_map_index idx = &dev->idmaps.active[group];
+    RETURN_UNLESS(_unindex_idmap(idx->by_LID, idx->size, rem, 0));
+    _unindex_idmap(idx->by_GID, idx->size, rem, 1);
+    --idx->count;
+    rem->next = dev->idmaps.reserve;
+    dev->idmaps.reserve = rem;
 }
 
 int mpr_dev_LID_decref(mpr_local_dev dev, int group, mpr_id_map map)
@@ -893,26 +1392,149 @@ int mpr_dev_GID_decref(mpr_local_dev dev, int group, mpr_id_map map)
 
 mpr_id_map mpr_dev_get_idmap_by_LID(mpr_local_dev dev, int group, mpr_id LID)
 {
-    mpr_id_map map = dev->idmaps.active[group];
-    while (map) {
-        if (map->LID == LID)
-            return map;
-        map = map->next;
-    }
-    return 0;
+    mpr_id_map_index idx = &dev->idmaps.active[group];
+    return _find_idmap(idx->by_LID, idx->size, LID, 0);
 }
 
 mpr_id_map mpr_dev_get_idmap_by_GID(mpr_local_dev dev, int group, mpr_id GID)
 {
-    mpr_id_map map = dev->idmaps.active[group];
-    while (map) {
-        if (map->GID == GID)
-            return map;
-        map = map->next;
+    mpr_id_map_index idx = &dev->idmaps.active[group];
+    return _find_idmap(idx->by_GID, idx->size, GID, 1);
+}
+
+/* Updates from other threads are passed to the polling thread through a bounded ring of slots,
+ * each with a sequence number indicating whether it is ready to be written for a given position
+ * or ready to be read.  Producers claim positions with compare-and-swap and never block or
+ * allocate, except when handing over values too large for a slot on behalf of
+ * mpr_sig_set_value().  The polling thread is the only consumer. */
+static void _init_queue(mpr_update_queue_t *q)
+{
+    uint32_t i;
+    q->slots = (mpr_queued_update_t*) calloc(MPR_QUEUE_SIZE, sizeof(mpr_queued_update_t));
+    for (i = 0; i < MPR_QUEUE_SIZE; i++)
+        q->slots[i].seq = i;
+    q->head = q->tail = 0;
+}
+
+static void _free_queue(mpr_update_queue_t *q)
+{
+    uint32_t pos;
+    RETURN_UNLESS(q->slots);
+    /* free copies held by updates that were never processed */
+    for (pos = q->tail; pos != q->tail + MPR_QUEUE_SIZE; pos++) {
+        mpr_queued_update slot = &q->slots[pos & (MPR_QUEUE_SIZE - 1)];
+        if (mpr_atomic_load(&slot->seq) != pos + 1)
+            break;
+        FUNC_IF(free, slot->ext);
     }
+    free(q->slots);
+    q->slots = 0;
+}
+
+int mpr_dev_queue_update(mpr_local_dev dev, mpr_local_sig sig, mpr_id inst, int len,
+                         mpr_type type, const void *val, mpr_time time, int copy)
+{
+    mpr_update_queue_t *q = &dev->queue;
+    mpr_queued_update slot;
+    uint32_t pos;
+    int size = len * mpr_type_get_size(type);
+    void *ext = 0;
+    RETURN_ARG_UNLESS(q->slots, -1);
+
+    if (size > MPR_QUEUE_VAL_BYTES) {
+        RETURN_ARG_UNLESS(copy && (ext = malloc(size)), -1);
+        memcpy(ext, val, size);
+    }
+
+    pos = mpr_atomic_load(&q->head);
+    while (1) {
+        int32_t diff;
+        slot = &q->slots[pos & (MPR_QUEUE_SIZE - 1)];
+        diff = (int32_t)(mpr_atomic_load(&slot->seq) - pos);
+        if (0 == diff) {
+            if (mpr_atomic_cas(&q->head, &pos, pos + 1))
+                break;
+        }
+        else if (diff < 0) {
+            /* queue is full */
+            FUNC_IF(free, ext);
+            return 1;
+        }
+        else
+            pos = mpr_atomic_load(&q->head);
+    }
+
+    slot->sig = sig;
+    slot->inst = inst;
+    slot->len = len;
+    slot->type = type;
+    mpr_time_set(&slot->time, time);
+    slot->ext = ext;
+    if (len && !ext)
+        memcpy(slot->val.c, val, size);
+
+    /* publish the update to the polling thread */
+    mpr_atomic_store(&slot->seq, pos + 1);
     return 0;
 }
 
+int mpr_dev_hand_over_update(mpr_local_dev dev, mpr_local_sig sig, mpr_id inst, int len,
+                             mpr_type type, const void *val)
+{
+    int result;
+    while ((result = mpr_dev_queue_update(dev, sig, inst, len, type, val, MPR_NOW, 1)) > 0) {
+        /* the queue is full, give the polling thread a chance to drain it */
+        if (!dev->thread_data)
+            break;
+        _yield_thread();
+    }
+    if (result)
+        trace_dev(dev, "could not pass update of signal '%s' to the polling thread.\n",
+                  sig->name);
+    return result;
+}
+
+static int _process_queued_updates(mpr_local_dev dev)
+{
+    mpr_update_queue_t *q = &dev->queue;
+    mpr_queued_update slot;
+    int count = 0;
+    RETURN_ARG_UNLESS(q->slots, 0);
+
+    /* stop after one pass around the ring so that busy producers cannot stall polling */
+    while (count < MPR_QUEUE_SIZE) {
+        slot = &q->slots[q->tail & (MPR_QUEUE_SIZE - 1)];
+        if (mpr_atomic_load(&slot->seq) != q->tail + 1)
+            break;
+        if (slot->sig)
+            mpr_sig_set_value_internal(slot->sig, slot->inst, slot->len, slot->type,
+                                       slot->ext ? slot->ext : slot->val.c, slot->time);
+        if (slot->ext) {
+            free(slot->ext);
+            slot->ext = 0;
+        }
+        /* hand the slot back to producers for the next lap */
+        mpr_atomic_store(&slot->seq, q->tail + MPR_QUEUE_SIZE);
+        ++q->tail;
+        ++count;
+    }
+    return count;
+}
+
+void mpr_dev_unqueue_sig(mpr_local_dev dev, mpr_local_sig sig)
+{
+    mpr_update_queue_t *q = &dev->queue;
+    uint32_t pos;
+    RETURN_UNLESS(q->slots);
+    for (pos = q->tail; pos != q->tail + MPR_QUEUE_SIZE; pos++) {
+        mpr_queued_update slot = &q->slots[pos & (MPR_QUEUE_SIZE - 1)];
+        if (mpr_atomic_load(&slot->seq) != pos + 1)
+            break;
+        if (slot->sig == sig)
+            slot->sig = 0;
+    }
+}
+
 /* Internal LibLo error handler */
 static void handler_error(int num, const char *msg, const char *where)
 {
@@ -976,6 +1598,7 @@ const char *mpr_dev_get_name(mpr_dev dev)
     dev->name = (char*)malloc(len);
     dev->name[0] = 0;
     snprintf(dev->name, len, "%s.%d", dev->prefix, ((mpr_local_dev)dev)->ordinal_allocator.val);
+    mpr_graph_reindex_obj(dev->obj.graph, (mpr_obj)dev);
     return dev->name;
 }
 
@@ -1105,24 +1728,189 @@ int mpr_dev_set_from_msg(mpr_dev dev, mpr_msg m)
                 break;
         }
     }
+    if (updated)
+        mpr_graph_reindex_obj(dev->obj.graph, (mpr_obj)dev);
     return updated;
 }
 
-static int mpr_dev_send_sigs(mpr_local_dev dev, mpr_dir dir)
+/* Stamp a local signal with a new version, which also becomes the version of its device. */
+MPR_INLINE static void _stamp_sig(mpr_sig sig, int version)
+{
+    if (sig && sig->is_local) {
+        sig->obj.version = version;
+        sig->dev->obj.version = version;
+    }
+}
+
+void mpr_dev_record_change(mpr_obj o)
+{
+    int i, version;
+    RETURN_UNLESS(o && o->graph);
+    if (MPR_DEV == o->type) {
+        RETURN_UNLESS(((mpr_dev)o)->is_local);
+        o->version = ++o->graph->local_version;
+    }
+    else if (MPR_SIG == o->type) {
+        RETURN_UNLESS(((mpr_sig)o)->is_local);
+        _stamp_sig((mpr_sig)o, ++o->graph->local_version);
+    }
+    else if (MPR_MAP == o->type) {
+        mpr_map m = (mpr_map)o;
+        RETURN_UNLESS(m->is_local);
+        version = ++o->graph->local_version;
+        ((mpr_local_map)m)->sync_version = version;
+        /* the map counts of its local signals have changed too */
+        _stamp_sig(m->dst->sig, version);
+        for (i = 0; i < m->num_src; i++)
+            _stamp_sig(m->src[i]->sig, version);
+    }
+}
+
+static void _add_tombstone(mpr_local_dev dev, int version, int flags, net_msg_t cmd,
+                           mpr_id id, int num_names, const char **names)
+{
+    int i;
+    size_t len = 0;
+    char *str;
+    mpr_tombstone t, *prev;
+
+    for (i = 0; i < num_names; i++)
+        len += strlen(names[i]) + 1;
+    t = (mpr_tombstone)malloc(sizeof(mpr_tombstone_t) + len);
+    RETURN_UNLESS(t);
+    t->version = version;
+    t->flags = flags;
+    t->cmd = cmd;
+    t->id = id;
+    t->num_names = num_names;
+    for (i = 0, str = t->names; i < num_names; i++) {
+        len = strlen(names[i]) + 1;
+        memcpy(str, names[i], len);
+        str += len;
+    }
+    t->next = dev->tombstones;
+    dev->tombstones = t;
+    dev->obj.version = version;
+
+    if (++dev->num_tombstones > MAX_TOMBSTONES) {
+        /* forget the oldest removal, subscribers that missed it will need a full sync */
+        prev = &dev->tombstones;
+        while ((*prev)->next)
+            prev = &(*prev)->next;
+        dev->sync_horizon = (*prev)->version;
+        free(*prev);
+        *prev = 0;
+        --dev->num_tombstones;
+    }
+}
+
+void mpr_dev_record_removal(mpr_obj o)
+{
+    int i, j, version;
+    char name[1024];
+    const char *names[MAX_NUM_MAP_SRC + 2];
+    RETURN_UNLESS(o && o->graph);
+
+    if (MPR_SIG == o->type) {
+        mpr_sig sig = (mpr_sig)o;
+        /* signals of unregistered devices were never announced */
+        RETURN_UNLESS(sig->is_local && ((mpr_local_dev)sig->dev)->registered);
+        snprintf(name, 1024, "%s%s", sig->dev->name, sig->path);
+        names[0] = name;
+        _add_tombstone((mpr_local_dev)sig->dev, ++o->graph->local_version,
+                       MPR_DIR_IN == sig->dir ? MPR_SIG_IN : MPR_SIG_OUT, MSG_SIG_REM, 0, 1, names);
+    }
+    else if (MPR_MAP == o->type) {
+        mpr_map m = (mpr_map)o;
+        mpr_dev devs[MAX_NUM_MAP_SRC + 1];
+        char *path;
+        int num_devs = 0, num_names = 0, len = 0;
+        /* maps that never became ready were never announced */
+        RETURN_UNLESS(m->is_local && m->status >= MPR_STATUS_READY
+                      && m->num_src <= MAX_NUM_MAP_SRC);
+        version = ++o->graph->local_version;
+
+        /* store the signal names in the same order as in an /unmapped message */
+        if (MPR_DIR_IN == m->dst->dir)
+            num_names = 2;
+        for (i = 0; i < m->num_src; i++) {
+            path = name + len;
+            len += snprintf(path, 1024 - len, "%s%s", m->src[i]->sig->dev->name,
+                            m->src[i]->sig->path) + 1;
+            RETURN_UNLESS(len < 1024);
+            names[num_names++] = path;
+        }
+        path = name + len;
+        len += snprintf(path, 1024 - len, "%s%s", m->dst->sig->dev->name, m->dst->sig->path) + 1;
+        RETURN_UNLESS(len < 1024);
+        if (MPR_DIR_IN == m->dst->dir) {
+            names[0] = path;
+            names[1] = "<-";
+        }
+        else {
+            names[num_names++] = "->";
+            names[num_names++] = path;
+        }
+
+        /* each local device of the map keeps its own tombstone */
+        for (i = -1; i < m->num_src; i++) {
+            mpr_sig sig = i < 0 ? m->dst->sig : m->src[i]->sig;
+            if (!sig->is_local || !((mpr_local_dev)sig->dev)->registered)
+                continue;
+            _stamp_sig(sig, version);
+            for (j = 0; j < num_devs; j++) {
+                if (devs[j] == sig->dev)
+                    break;
+            }
+            if (j < num_devs)
+                continue;
+            devs[num_devs++] = sig->dev;
+            _add_tombstone((mpr_local_dev)sig->dev, version,
+                           sig == m->dst->sig ? MPR_MAP_IN : MPR_MAP_OUT, MSG_UNMAPPED,
+                           m->obj.id, num_names, names);
+        }
+    }
+}
+
+/* Send the removals stamped after a version, oldest first. */
+static void _send_tombstones(mpr_net net, mpr_tombstone t, int flags, int since)
+{
+    int i;
+    const char *name;
+    lo_message msg;
+    RETURN_UNLESS(t && t->version > since);
+    _send_tombstones(net, t->next, flags, since);
+    RETURN_UNLESS(t->flags & flags);
+    msg = lo_message_new();
+    RETURN_UNLESS(msg);
+    for (i = 0, name = t->names; i < t->num_names; i++, name += strlen(name) + 1)
+        lo_message_add_string(msg, name);
+    if (t->id) {
+        lo_message_add_string(msg, mpr_prop_as_str(PROP(ID), 0));
+        lo_message_add_int64(msg, t->id);
+    }
+    mpr_net_add_msg(net, 0, t->cmd, msg);
+}
+
+/* Send the signals of a device changed after a version, or all of them if it is -1. */
+static int mpr_dev_send_sigs(mpr_local_dev dev, mpr_dir dir, int since)
 {
     mpr_list l = mpr_dev_get_sigs((mpr_dev)dev, dir);
     while (l) {
-        mpr_sig_send_state((mpr_sig)*l, MSG_SIG);
+        if ((*l)->version > since)
+            mpr_sig_send_state((mpr_sig)*l, MSG_SIG);
         l = mpr_list_get_next(l);
     }
     return 0;
 }
 
-static int mpr_dev_send_maps(mpr_local_dev dev, mpr_dir dir)
+static int mpr_dev_send_maps(mpr_local_dev dev, mpr_dir dir, int since)
 {
     mpr_list l = mpr_dev_get_maps((mpr_dev)dev, dir);
     while (l) {
-        mpr_map_send_state((mpr_map)*l, -1, MSG_MAPPED);
+        mpr_map m = (mpr_map)*l;
+        if (!m->is_local || ((mpr_local_map)m)->sync_version > since)
+            mpr_map_send_state(m, -1, MSG_MAPPED);
         l = mpr_list_get_next(l);
     }
     return 0;
@@ -1130,7 +1918,7 @@ static int mpr_dev_send_maps(mpr_local_dev dev, mpr_dir dir)
 
 /* Add/renew/remove a subscription. */
 void mpr_dev_manage_subscriber(mpr_local_dev dev, lo_address addr, int flags,
-                               int timeout_sec, int revision)
+                               int timeout_sec, int revision, int session)
 {
     mpr_time t;
     mpr_net net;
@@ -1164,7 +1952,13 @@ void mpr_dev_manage_subscriber(mpr_local_dev dev, lo_address addr, int flags,
                 print_subscription_flags(flags);
 #endif
                 (*s)->lease_exp = t.sec + timeout_sec;
-                flags &= ~(*s)->flags;
+                if (++(*s)->num_renewals >= FULL_SYNC_RENEWALS) {
+                    /* periodically resend everything in case the subscriber has drifted */
+                    (*s)->num_renewals = 0;
+                    revision = -1;
+                }
+                else
+                    flags &= ~(*s)->flags;
                 (*s)->flags = temp;
             }
             break;
@@ -1184,16 +1978,29 @@ void mpr_dev_manage_subscriber(mpr_local_dev dev, lo_address addr, int flags,
         sub->addr = lo_address_new(ip, port);
         sub->lease_exp = t.sec + timeout_sec;
         sub->flags = flags;
+        sub->num_renewals = 0;
         sub->next = dev->subscribers;
         dev->subscribers = sub;
     }
 
-    /* bring new subscriber up to date */
+    /* bring new subscriber up to date, only with the changes since the version it already
+     * holds if it was recorded from this run of the device and we still have a record of
+     * every removal after it */
+    if (session != dev->session || revision < dev->sync_horizon || revision > dev->obj.version)
+        revision = -1;
+    else
+        trace_dev(dev, "sending changes since version %d to subscriber\n", revision);
     net = &dev->obj.graph->net;
     mpr_net_use_mesh(net, addr);
     mpr_dev_send_state((mpr_dev)dev, MSG_DEV);
     mpr_net_send(net);
 
+    if (revision >= 0 && dev->tombstones) {
+        mpr_net_use_mesh(net, addr);
+        _send_tombstones(net, dev->tombstones, flags, revision);
+        mpr_net_send(net);
+    }
+
     if (flags & MPR_SIG) {
         mpr_dir dir = 0;
         if (flags & MPR_SIG_IN)
@@ -1201,7 +2008,7 @@ void mpr_dev_manage_subscriber(mpr_local_dev dev, lo_address addr, int flags,
         if (flags & MPR_SIG_OUT)
             dir |= MPR_DIR_OUT;
         mpr_net_use_mesh(net, addr);
-        mpr_dev_send_sigs(dev, dir);
+        mpr_dev_send_sigs(dev, dir, revision);
         mpr_net_send(net);
     }
     if (flags & MPR_MAP) {
@@ -1211,7 +2018,7 @@ void mpr_dev_manage_subscriber(mpr_local_dev dev, lo_address addr, int flags,
         if (flags & MPR_MAP_OUT)
             dir |= MPR_DIR_OUT;
         mpr_net_use_mesh(net, addr);
-        mpr_dev_send_maps(dev, dir);
+        mpr_dev_send_maps(dev, dir, revision);
         mpr_net_send(net);
     }
 }
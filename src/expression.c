@@ -9,6 +9,7 @@
 
 #define MAX_HIST_SIZE 100
 #define STACK_SIZE 64
+#define STACK_ALIGN 64
 #define N_USER_VARS 16
 #ifdef DEBUG
     #define TRACE_PARSE 0 /* Set non-zero to see trace during parse. */
@@ -31,39 +32,60 @@ typedef union _mpr_expr_val {
  * con: timetags wasted
  * option: create version with unallocated timetags */
 struct _mpr_expr_stack {
-    mpr_expr_val stk;
-    uint8_t *dims;
-    int size;
+    mpr_expr_val stk;       /*!< Stack values, aligned to STACK_ALIGN. */
+    uint8_t *dims;          /*!< Vector length of each stack entry, stored after the values. */
+    void *mem;              /*!< Single allocation holding both arrays. */
+    int size;               /*!< Number of values. */
+    int depth;              /*!< Number of stack entries. */
+    int num_realloc;        /*!< Number of reallocations since the stack was created, including
+                             *   those refused in guard mode. */
+    uint8_t guard;          /*!< 1 if evaluation must not reallocate the stack. */
 };
 
 mpr_expr_stack mpr_expr_stack_new() {
-    mpr_expr_stack stk = malloc(sizeof(struct _mpr_expr_stack));
-    stk->stk = 0;
-    stk->dims = 0;
-    stk->size = 0;
-    return stk;
+    return calloc(1, sizeof(struct _mpr_expr_stack));
 }
 
-static void expr_stack_realloc(mpr_expr_stack stk, int num_samps) {
-    /* Reallocate evaluation stack if necessary. */
-    if (num_samps > stk->size) {
-        stk->size = num_samps;
-        if (stk->stk)
-            stk->stk = realloc(stk->stk, stk->size * sizeof(mpr_expr_val_t));
-        else
-            stk->stk = malloc(stk->size * sizeof(mpr_expr_val_t));
-        if (stk->dims)
-            stk->dims = realloc(stk->dims, stk->size * sizeof(uint8_t));
-        else
-            stk->dims = malloc(stk->size * sizeof(uint8_t));
-    }
+/* Values and dims share one allocation, with the values aligned to a cache line. */
+static void _stack_alloc(mpr_expr_stack stk, int depth, int num_samps)
+{
+    if (stk->guard)
+        trace("warning: evaluation stack reallocated in guard mode\n");
+    FUNC_IF(free, stk->mem);
+    stk->mem = malloc(num_samps * sizeof(mpr_expr_val_t) + depth + STACK_ALIGN - 1);
+    stk->stk = (mpr_expr_val)(((uintptr_t)stk->mem + STACK_ALIGN - 1)
+                              & ~(uintptr_t)(STACK_ALIGN - 1));
+    stk->dims = (uint8_t*)(stk->stk + num_samps);
+    stk->size = num_samps;
+    stk->depth = depth;
+    ++stk->num_realloc;
+}
+
+/* Grow the evaluation stack if necessary. */
+static void expr_stack_realloc(mpr_expr_stack stk, int depth, int num_samps) {
+    if (num_samps > stk->size || depth > stk->depth)
+        _stack_alloc(stk, depth > stk->depth ? depth : stk->depth,
+                     num_samps > stk->size ? num_samps : stk->size);
+}
+
+void mpr_expr_stack_set_size(mpr_expr_stack stk, int depth, int num_samps)
+{
+    if (num_samps != stk->size || depth != stk->depth)
+        _stack_alloc(stk, depth, num_samps);
+}
+
+void mpr_expr_stack_set_guard(mpr_expr_stack stk, int guard)
+{
+    stk->guard = guard ? 1 : 0;
+}
+
+int mpr_expr_stack_get_num_realloc(mpr_expr_stack stk)
+{
+    return stk->num_realloc;
 }
 
 void mpr_expr_stack_free(mpr_expr_stack stk) {
-    if (stk->stk)
-        free(stk->stk);
-    if (stk->dims)
-        free(stk->dims);
+    FUNC_IF(free, stk->mem);
     free(stk);
 }
 
@@ -1404,9 +1426,10 @@ error:
     return -1;
 }
 
-static int precompute(mpr_expr_stack eval_stk, mpr_token_t *stk, int len, int vec_len)
+static int precompute(mpr_token_t *stk, int len, int vec_len)
 {
     int i;
+    struct _mpr_expr_stack eval_stk;
     struct _mpr_expr e = {0, 0, 0, 0, 0, 0, 0, 0, 0, 0, -1, -1};
     mpr_value_t v = {0, 0, 1, 1, 0, 1};
     mpr_value_buffer_t b = {0, 0, -1};
@@ -1424,9 +1447,15 @@ static int precompute(mpr_expr_stack eval_stk, mpr_token_t *stk, int len, int ve
     v.vlen = vec_len;
     v.type = stk[len - 1].gen.datatype;
 
-    expr_stack_realloc(eval_stk, len * vec_len);
+    /* use a scratch stack so that parsing never resizes a device evaluation stack */
+    memset(&eval_stk, 0, sizeof(eval_stk));
+    eval_stk.stk = alloca(len * vec_len * sizeof(mpr_expr_val_t));
+    eval_stk.dims = alloca(len * sizeof(uint8_t));
+    eval_stk.size = len * vec_len;
+    eval_stk.depth = len;
+    eval_stk.guard = 1;
 
-    if (!(mpr_expr_eval(eval_stk, &e, 0, 0, &v, 0, 0, 0) & 1)) {
+    if (!(mpr_expr_eval(&eval_stk, &e, 0, 0, &v, 0, 0, 0) & 1)) {
         free(s);
         return 0;
     }
@@ -1465,8 +1494,7 @@ static int precompute(mpr_expr_stack eval_stk, mpr_token_t *stk, int len, int ve
     return len - 1;
 }
 
-static int check_type(mpr_expr_stack eval_stk, mpr_token_t *stk, int sp, mpr_var_t *vars,
-                      int enable_optimize)
+static int check_type(mpr_token_t *stk, int sp, mpr_var_t *vars, int enable_optimize)
 {
     /* TODO: enable precomputation of const-only vectors */
     int i, arity, can_precompute = 1, optimize = NONE;
@@ -1678,7 +1706,7 @@ static int check_type(mpr_expr_stack eval_stk, mpr_token_t *stk, int sp, mpr_var
     }
     /* if stack within bounds of arity was only constants, we're ok to compute */
     if (enable_optimize && can_precompute) {
-        int len = precompute(eval_stk, &stk[sp - arity], arity + 1, vec_len);
+        int len = precompute(&stk[sp - arity], arity + 1, vec_len);
         return sp - len;
     }
     else
@@ -1699,8 +1727,7 @@ static int substack_len(mpr_token_t *stk, int sp)
     return sp - idx;
 }
 
-static int check_assign_type_and_len(mpr_expr_stack eval_stk, mpr_token_t *stk, int sp,
-                                     mpr_var_t *vars)
+static int check_assign_type_and_len(mpr_token_t *stk, int sp, mpr_var_t *vars)
 {
     int i = sp, optimize = 1, expr_len = 0;
     uint8_t vec_len = 0;
@@ -1718,7 +1745,7 @@ static int check_assign_type_and_len(mpr_expr_stack eval_stk, mpr_token_t *stk,
         return -1;
     }
     promote_token_datatype(&stk[i], stk[sp].gen.datatype);
-    if (check_type(eval_stk, stk, i, vars, optimize) == -1)
+    if (check_type(stk, i, vars, optimize) == -1)
         return -1;
     promote_token_datatype(&stk[i], stk[sp].gen.datatype);
 
@@ -1866,7 +1893,7 @@ static int _eval_stack_size(mpr_token_t *token_stack, int token_stack_len)
 #define POP_OPERATOR_TO_OUTPUT()                                    \
 {                                                                   \
     PUSH_TO_OUTPUT(op[op_idx]);                                     \
-    out_idx = check_type(eval_stk, out, out_idx, vars, 1);          \
+    out_idx = check_type(out, out_idx, vars, 1);                    \
     {FAIL_IF(out_idx < 0, "Malformed expression (3).");}            \
     POP_OPERATOR();                                                 \
 }
@@ -2256,7 +2283,7 @@ mpr_expr mpr_expr_new_from_str(mpr_expr_stack eval_stk, const char *str, int n_i
                     tok.op.idx = pfn_tbl[pfn].op;
                     /* don't use macro here since we don't want to optimize away initialization args */
                     PUSH_TO_OUTPUT(tok);
-                    out_idx = check_type(eval_stk, out, out_idx, vars, 0);
+                    out_idx = check_type(out, out_idx, vars, 0);
                     {FAIL_IF(out_idx < 0, "Malformed expression (11).");}
                 }
                 if (VFN_UNKNOWN != pfn_tbl[pfn].vfn) {
@@ -2531,7 +2558,7 @@ mpr_expr mpr_expr_new_from_str(mpr_expr_stack eval_stk, const char *str, int n_i
                         {FAIL("Malformed expression (5)");}
                     PUSH_TO_OUTPUT(op[op_idx]);
                     if (out[out_idx].toktype == TOK_ASSIGN_USE
-                        && check_assign_type_and_len(eval_stk, out, out_idx, vars) == -1)
+                        && check_assign_type_and_len(out, out_idx, vars) == -1)
                         {FAIL("Malformed expression (6)");}
                     POP_OPERATOR();
                 }
@@ -2539,7 +2566,7 @@ mpr_expr mpr_expr_new_from_str(mpr_expr_stack eval_stk, const char *str, int n_i
                 out[out_idx].gen.flags |= CLEAR_STACK;
 
                 /* check vector length and type */
-                if (check_assign_type_and_len(eval_stk, out, out_idx, vars) == -1)
+                if (check_assign_type_and_len(out, out_idx, vars) == -1)
                     {FAIL("Malformed expression (7)");}
 
                 /* start another sub-expression */
@@ -2778,7 +2805,7 @@ mpr_expr mpr_expr_new_from_str(mpr_expr_stack eval_stk, const char *str, int n_i
         PUSH_TO_OUTPUT(op[op_idx]);
         /* check vector length and type */
         {FAIL_IF(out[out_idx].toktype == TOK_ASSIGN_USE
-                 && check_assign_type_and_len(eval_stk, out, out_idx, vars) == -1,
+                 && check_assign_type_and_len(out, out_idx, vars) == -1,
                  "Malformed expression (9).");}
         POP_OPERATOR();
     }
@@ -2794,7 +2821,7 @@ mpr_expr mpr_expr_new_from_str(mpr_expr_stack eval_stk, const char *str, int n_i
     }
 
     /* check vector length and type */
-    {FAIL_IF(check_assign_type_and_len(eval_stk, out, out_idx, vars) == -1,
+    {FAIL_IF(check_assign_type_and_len(out, out_idx, vars) == -1,
              "Malformed expression (10).");}
 
     {FAIL_IF(replace_special_constants(out, out_idx), "Error replacing special constants."); }
@@ -2843,7 +2870,8 @@ mpr_expr mpr_expr_new_from_str(mpr_expr_stack eval_stk, const char *str, int n_i
     /* TODO: is this the same as n_ins arg passed to this function? */
     expr->n_ins = _get_num_input_slots(expr);
 
-    expr_stack_realloc(eval_stk, expr->stack_size * expr->vec_len);
+    if (eval_stk)
+        expr_stack_realloc(eval_stk, expr->stack_size, expr->stack_size * expr->vec_len);
 
 #if TRACE_PARSE
     printf("expression allocated and initialized\n");
@@ -2861,6 +2889,12 @@ int mpr_expr_get_out_hist_size(mpr_expr expr)
     return expr->out_hist_size;
 }
 
+void mpr_expr_get_stack_size(mpr_expr expr, int *depth, int *num_samps)
+{
+    *depth = expr->stack_size;
+    *num_samps = expr->stack_size * expr->vec_len;
+}
+
 int mpr_expr_get_num_vars(mpr_expr expr)
 {
     return expr->n_vars;
@@ -2904,6 +2938,44 @@ int mpr_expr_get_manages_inst(mpr_expr expr)
     return expr ? expr->inst_ctl >= 0 : 0;
 }
 
+int mpr_expr_get_is_elementwise(mpr_expr expr)
+{
+    int i;
+    mpr_token_t *tok;
+    RETURN_ARG_UNLESS(expr && 1 == expr->n_ins && !expr->n_vars && expr->inst_ctl < 0, 0);
+    RETURN_ARG_UNLESS(expr->in_hist_size[0] <= 1 && expr->out_hist_size <= 1, 0);
+    for (i = 0, tok = expr->tokens; i < expr->n_tokens; i++, tok++) {
+        switch (tok->toktype) {
+            case TOK_LITERAL:
+            case TOK_VLITERAL:
+            case TOK_NEGATE:
+            case TOK_END:
+                break;
+            case TOK_OP:
+                /* conditionals without an else clause may leave the output unassigned */
+                RETURN_ARG_UNLESS(OP_IF != tok->op.idx, 0);
+                break;
+            case TOK_FN:
+                /* functions with memory or side effects depend on more than the current input */
+                RETURN_ARG_UNLESS(tok->fn.idx < FN_DELAY && !fn_tbl[tok->fn.idx].memory, 0);
+                break;
+            case TOK_VAR:
+                /* only whole-vector references to the current input */
+                RETURN_ARG_UNLESS(VAR_X == tok->var.idx && !tok->var.vec_idx
+                                  && tok->gen.vec_len == expr->vec_len, 0);
+                break;
+            case TOK_ASSIGN:
+            case TOK_ASSIGN_USE:
+                RETURN_ARG_UNLESS(VAR_Y == tok->var.idx && !tok->var.vec_idx
+                                  && !tok->var.offset && tok->gen.vec_len == expr->vec_len, 0);
+                break;
+            default:
+                return 0;
+        }
+    }
+    return 1;
+}
+
 #if TRACE_EVAL
 static void print_stack_vec(mpr_expr_val stk, mpr_type type, int vec_len)
 {
@@ -3058,8 +3130,8 @@ int mpr_expr_eval(mpr_expr_stack expr_stk, mpr_expr expr, mpr_value *v_in, mpr_v
     mpr_value_buffer b_out;
     mpr_value x = NULL;
 
-    mpr_expr_val stk = expr_stk->stk;
-    uint8_t *dims = expr_stk->dims;
+    mpr_expr_val stk;
+    uint8_t *dims;
 
     if (!expr) {
 #if TRACE_EVAL
@@ -3068,6 +3140,19 @@ int mpr_expr_eval(mpr_expr_stack expr_stk, mpr_expr expr, mpr_value *v_in, mpr_v
         return 0;
     }
 
+    if (   expr->stack_size > expr_stk->depth
+        || expr->stack_size * expr->vec_len > expr_stk->size) {
+        /* the stack should already have been sized for every map using it */
+        if (expr_stk->guard) {
+            trace("error: evaluation stack too small for expression, skipping evaluation\n");
+            ++expr_stk->num_realloc;
+            return 0;
+        }
+        expr_stack_realloc(expr_stk, expr->stack_size, expr->stack_size * expr->vec_len);
+    }
+    stk = expr_stk->stk;
+    dims = expr_stk->dims;
+
     sp = -expr->vec_len;
     vlen = expr->vec_len;
     tok = expr->start;
@@ -53,8 +53,18 @@ static void set_net_dst(mpr_graph g, mpr_dev d)
     mpr_net_use_bus(&g->net);
 }
 
+/* Retrieve the session token advertised by a device, returns 0 if it has none. */
+static int _get_session(mpr_dev d, int *session)
+{
+    mpr_tbl_record r = mpr_tbl_get(d->obj.props.synced, MPR_PROP_EXTRA, MPR_SESSION_KEY);
+    RETURN_ARG_UNLESS(r && r->val && 1 == r->len && MPR_INT32 == r->type, 0);
+    *session = *(int*)((r->flags & INDIRECT) ? *r->val : r->val);
+    return 1;
+}
+
 static void send_subscribe_msg(mpr_graph g, mpr_dev d, int flags, int timeout)
 {
+    int session;
     char cmd[1024];
     NEW_LO_MSG(msg, return);
     snprintf(cmd, 1024, "/%s/subscribe", d->name);
@@ -87,11 +97,17 @@ static void send_subscribe_msg(mpr_graph g, mpr_dev d, int flags, int timeout)
 
     lo_message_add_string(msg, "@version");
     lo_message_add_int32(msg, d->obj.version);
+    if (d->obj.version >= 0 && _get_session(d, &session)) {
+        lo_message_add_string(msg, "@session");
+        lo_message_add_int32(msg, session);
+    }
 
     mpr_net_add_msg(&g->net, cmd, 0, msg);
     mpr_net_send(&g->net);
 }
 
+static mpr_subscription _get_subscription(mpr_graph g, mpr_dev d);
+
 static void _autosubscribe(mpr_graph g, int flags)
 {
     if (!g->autosub && flags) {
@@ -104,11 +120,13 @@ static void _autosubscribe(mpr_graph g, int flags)
             trace_graph("adjusting flags for existing autorenewing subscription to %s.\n",
                         mpr_dev_get_name(s->dev));
             if (flags & ~s->flags) {
+                /* newly-requested object types need a full sync */
+                s->dev->obj.version = -1;
                 send_subscribe_msg(g, s->dev, flags, AUTOSUB_INTERVAL);
                 /* leave 10-second buffer for subscription renewal */
                 s->lease_expiration_sec = (t.sec + AUTOSUB_INTERVAL - 10);
             }
-            s->flags = flags;
+            s->flags = s->dev->subscribed = flags;
             s = s->next;
         }
         if (msg) {
@@ -130,6 +148,500 @@ static void _autosubscribe(mpr_graph g, int flags)
     g->autosub = flags;
 }
 
+/**** Indices ****/
+
+#define IDX_ID      0
+#define IDX_NAME    1
+#define IDX_INIT_SIZE 16
+
+MPR_INLINE static uint32_t _hash_id(uint64_t id)
+{
+    /* device ids only use the upper 32 bits, so mix them into the lower ones */
+    id ^= id >> 33;
+    id *= 0xff51afd7ed558ccdULL;
+    id ^= id >> 33;
+    return (uint32_t)id;
+}
+
+MPR_INLINE static uint32_t _hash_str(const char *str, uint32_t hash)
+{
+    /* FNV-1a */
+    hash ^= 2166136261u;
+    while (*str) {
+        hash ^= (uint8_t)*str++;
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+/* Signal names are only unique within their device, so the device is part of the key. */
+MPR_INLINE static uint32_t _hash_sig_name(mpr_dev dev, const char *name)
+{
+    return _hash_str(name, _hash_id((uint64_t)(uintptr_t)dev));
+}
+
+static mpr_graph_idx _get_idx(mpr_graph g, mpr_obj o, int which)
+{
+    switch (o->type) {
+        case MPR_DEV:   return which == IDX_ID ? &g->devs_by_id : &g->devs_by_name;
+        case MPR_SIG:   return which == IDX_ID ? &g->sigs_by_id : &g->sigs_by_name;
+        case MPR_MAP:   return which == IDX_ID ? &g->maps_by_id : 0;
+        default:        return 0;
+    }
+}
+
+static void _idx_remove(mpr_graph_idx idx, mpr_obj o, int which)
+{
+    mpr_obj *ptr;
+    RETURN_UNLESS(o->idx[which].indexed);
+    ptr = &idx->buckets[o->idx[which].hash & (idx->size - 1)];
+    while (*ptr) {
+        if (*ptr == o) {
+            *ptr = o->idx[which].next;
+            break;
+        }
+        ptr = &(*ptr)->idx[which].next;
+    }
+    o->idx[which].next = 0;
+    o->idx[which].indexed = 0;
+    --idx->count;
+}
+
+static void _idx_insert(mpr_graph_idx idx, mpr_obj o, int which, uint32_t hash)
+{
+    mpr_obj *bucket;
+    if (idx->count >= idx->size) {
+        /* grow and rehash using the stored hashes */
+        int i, size = idx->size ? idx->size * 2 : IDX_INIT_SIZE;
+        mpr_obj *buckets = (mpr_obj*)calloc(1, sizeof(mpr_obj) * size);
+        for (i = 0; i < idx->size; i++) {
+            mpr_obj next, cur = idx->buckets[i];
+            while (cur) {
+                next = cur->idx[which].next;
+                bucket = &buckets[cur->idx[which].hash & (size - 1)];
+                cur->idx[which].next = *bucket;
+                *bucket = cur;
+                cur = next;
+            }
+        }
+        FUNC_IF(free, idx->buckets);
+        idx->buckets = buckets;
+        idx->size = size;
+    }
+    bucket = &idx->buckets[hash & (idx->size - 1)];
+    o->idx[which].next = *bucket;
+    o->idx[which].hash = hash;
+    o->idx[which].indexed = 1;
+    *bucket = o;
+    ++idx->count;
+}
+
+static void _idx_set(mpr_graph_idx idx, mpr_obj o, int which, int has_key, uint32_t hash)
+{
+    if (!has_key) {
+        _idx_remove(idx, o, which);
+        return;
+    }
+    /* lookups compare the actual key, so only the bucket needs to be right */
+    if (o->idx[which].indexed && o->idx[which].hash == hash)
+        return;
+    _idx_remove(idx, o, which);
+    _idx_insert(idx, o, which, hash);
+}
+
+/* Secondary indices of property values, see mpr_graph_add_index(). */
+
+static int _prop_idx_num(mpr_type type, const void *val, int i, double *num)
+{
+    switch (type) {
+        case MPR_INT32: *num = ((int*)val)[i];          return 1;
+        case MPR_FLT:   *num = ((float*)val)[i];        return 1;
+        case MPR_DBL:   *num = ((double*)val)[i];       return 1;
+        case MPR_TYPE:  *num = ((mpr_type*)val)[i];     return 1;
+        case MPR_INT64:
+        case MPR_TIME:  /* compared as unsigned integers by mpr_list_filter() */
+                        *num = ((uint64_t*)val)[i];     return 1;
+        default:                                        return 0;
+    }
+}
+
+/* Values that are equal according to mpr_list_filter() must hash the same, so numbers are hashed
+ * as doubles to let -0.0 and 0.0 collide. Returns 0 if the value cannot be hashed. */
+static int _hash_prop_val(int len, mpr_type type, const void *val, uint32_t *hash)
+{
+    int i;
+    double num;
+    uint64_t bits;
+    uint32_t h = _hash_id(((uint64_t)type << 32) | (uint32_t)len);
+    RETURN_ARG_UNLESS(val && len > 0, 0);
+    for (i = 0; i < len; i++) {
+        if (MPR_STR == type) {
+            const char *str = 1 == len ? (const char*)val : ((const char**)val)[i];
+            RETURN_ARG_UNLESS(str, 0);
+            h = _hash_str(str, h);
+        }
+        else if (_prop_idx_num(type, val, i, &num)) {
+            num += 0.0;
+            memcpy(&bits, &num, sizeof(double));
+            h = _hash_id(bits ^ h);
+        }
+        else
+            return 0;
+    }
+    *hash = h;
+    return 1;
+}
+
+MPR_INLINE static uint32_t _hash_obj(mpr_obj o)
+{
+    return _hash_id((uint64_t)(uintptr_t)o);
+}
+
+static mpr_prop_idx_entry *_prop_idx_find(mpr_prop_idx idx, mpr_obj o)
+{
+    mpr_prop_idx_entry *ptr;
+    RETURN_ARG_UNLESS(idx->count, 0);
+    ptr = &idx->by_obj[_hash_obj(o) & (idx->size - 1)];
+    while (*ptr && (*ptr)->obj != o)
+        ptr = &(*ptr)->next_by_obj;
+    return *ptr ? ptr : 0;
+}
+
+static void _prop_idx_remove(mpr_prop_idx idx, mpr_obj o)
+{
+    mpr_prop_idx_entry e, *ptr = _prop_idx_find(idx, o);
+    RETURN_UNLESS(ptr);
+    e = *ptr;
+    *ptr = e->next_by_obj;
+    ptr = &idx->by_val[e->hash & (idx->size - 1)];
+    while (*ptr != e)
+        ptr = &(*ptr)->next_by_val;
+    *ptr = e->next_by_val;
+    if (e->sorted_pos >= 0)
+        idx->sorted_dirty = 1;
+    free(e);
+    --idx->count;
+}
+
+static void _prop_idx_insert(mpr_prop_idx idx, mpr_prop_idx_entry e)
+{
+    mpr_prop_idx_entry *bucket;
+    if (idx->count >= idx->size) {
+        /* grow and rehash using the stored hashes */
+        int i, size = idx->size ? idx->size * 2 : IDX_INIT_SIZE;
+        mpr_prop_idx_entry *by_val = calloc(1, sizeof(mpr_prop_idx_entry) * size);
+        mpr_prop_idx_entry *by_obj = calloc(1, sizeof(mpr_prop_idx_entry) * size);
+        for (i = 0; i < idx->size; i++) {
+            mpr_prop_idx_entry next, cur = idx->by_obj[i];
+            while (cur) {
+                next = cur->next_by_obj;
+                bucket = &by_val[cur->hash & (size - 1)];
+                cur->next_by_val = *bucket;
+                *bucket = cur;
+                bucket = &by_obj[_hash_obj(cur->obj) & (size - 1)];
+                cur->next_by_obj = *bucket;
+                *bucket = cur;
+                cur = next;
+            }
+        }
+        FUNC_IF(free, idx->by_val);
+        FUNC_IF(free, idx->by_obj);
+        idx->by_val = by_val;
+        idx->by_obj = by_obj;
+        idx->size = size;
+    }
+    bucket = &idx->by_val[e->hash & (idx->size - 1)];
+    e->next_by_val = *bucket;
+    *bucket = e;
+    bucket = &idx->by_obj[_hash_obj(e->obj) & (idx->size - 1)];
+    e->next_by_obj = *bucket;
+    *bucket = e;
+    if (e->sorted_pos >= 0)
+        idx->sorted_dirty = 1;
+    ++idx->count;
+}
+
+static void _prop_idx_update(mpr_prop_idx idx, mpr_obj o)
+{
+    int len;
+    mpr_type type;
+    const void *val;
+    mpr_prop p;
+    mpr_prop_idx_entry e, *ptr;
+    uint32_t hash;
+    double num = 0;
+    int is_num;
+
+    if (idx->key)
+        p = mpr_obj_get_prop_by_key(o, idx->key, &len, &type, &val, 0);
+    else
+        p = mpr_obj_get_prop_by_idx(o, idx->prop, NULL, &len, &type, &val, 0);
+    if (MPR_PROP_UNKNOWN == p || !_hash_prop_val(len, type, val, &hash)) {
+        _prop_idx_remove(idx, o);
+        return;
+    }
+    /* only single numbers can be found by range */
+    is_num = 1 == len && _prop_idx_num(type, val, 0, &num) && num == num;
+    if (!is_num)
+        num = 0;
+
+    if ((ptr = _prop_idx_find(idx, o))) {
+        e = *ptr;
+        if (e->hash == hash && (e->sorted_pos >= 0) == is_num && e->num == num)
+            return;
+        _prop_idx_remove(idx, o);
+    }
+    e = (mpr_prop_idx_entry)calloc(1, sizeof(mpr_prop_idx_entry_t));
+    e->obj = o;
+    e->hash = hash;
+    e->num = num;
+    e->sorted_pos = is_num ? 0 : -1;
+    _prop_idx_insert(idx, e);
+}
+
+static int _compare_prop_idx_entries(const void *l, const void *r)
+{
+    double nl = (*(mpr_prop_idx_entry*)l)->num, nr = (*(mpr_prop_idx_entry*)r)->num;
+    return (nl > nr) - (nl < nr);
+}
+
+static void _prop_idx_sort(mpr_prop_idx idx)
+{
+    int i;
+    idx->sorted = realloc(idx->sorted, sizeof(mpr_prop_idx_entry) * (idx->count ? idx->count : 1));
+    idx->num_sorted = 0;
+    for (i = 0; i < idx->size; i++) {
+        mpr_prop_idx_entry e = idx->by_obj[i];
+        for (; e; e = e->next_by_obj) {
+            if (e->sorted_pos >= 0)
+                idx->sorted[idx->num_sorted++] = e;
+        }
+    }
+    qsort(idx->sorted, idx->num_sorted, sizeof(mpr_prop_idx_entry), _compare_prop_idx_entries);
+    for (i = 0; i < idx->num_sorted; i++)
+        idx->sorted[i]->sorted_pos = i;
+    idx->sorted_dirty = 0;
+}
+
+static void _update_prop_idxs(mpr_graph g, mpr_obj o)
+{
+    mpr_prop_idx idx;
+    RETURN_UNLESS(o->props.synced);
+    for (idx = g->prop_idxs; idx; idx = idx->next) {
+        if (idx->obj_type == o->type)
+            _prop_idx_update(idx, o);
+    }
+}
+
+static void _unindex_prop_idxs(mpr_graph g, mpr_obj o)
+{
+    mpr_prop_idx idx;
+    for (idx = g->prop_idxs; idx; idx = idx->next) {
+        if (idx->obj_type == o->type)
+            _prop_idx_remove(idx, o);
+    }
+}
+
+static void _free_prop_idxs(mpr_graph g)
+{
+    while (g->prop_idxs) {
+        int i;
+        mpr_prop_idx idx = g->prop_idxs;
+        g->prop_idxs = idx->next;
+        for (i = 0; i < idx->size; i++) {
+            mpr_prop_idx_entry next, e = idx->by_obj[i];
+            while (e) {
+                next = e->next_by_obj;
+                free(e);
+                e = next;
+            }
+        }
+        FUNC_IF(free, idx->by_val);
+        FUNC_IF(free, idx->by_obj);
+        FUNC_IF(free, idx->sorted);
+        FUNC_IF(free, idx->key);
+        free(idx);
+    }
+}
+
+static mpr_prop_idx _find_prop_idx(mpr_graph g, int obj_type, mpr_prop p, const char *key)
+{
+    mpr_prop_idx idx;
+    for (idx = g->prop_idxs; idx; idx = idx->next) {
+        if (idx->obj_type != obj_type)
+            continue;
+        if (key ? (idx->key && !strcmp(idx->key, key)) : (!idx->key && idx->prop == p))
+            return idx;
+    }
+    return 0;
+}
+
+/* Properties that change as a side effect of other operations rather than through the property
+ * functions, so an index on them would go stale. */
+static int _is_volatile_prop(mpr_prop p)
+{
+    switch (p) {
+        case MPR_PROP_DATA:
+        case MPR_PROP_JITTER:
+        case MPR_PROP_LINKED:
+        case MPR_PROP_NUM_INST:
+        case MPR_PROP_NUM_MAPS:
+        case MPR_PROP_NUM_MAPS_IN:
+        case MPR_PROP_NUM_MAPS_OUT:
+        case MPR_PROP_NUM_SIGS_IN:
+        case MPR_PROP_NUM_SIGS_OUT:
+        case MPR_PROP_NUM_SUPPRESSED:
+        case MPR_PROP_PERIOD:
+        case MPR_PROP_SCOPE:
+        case MPR_PROP_SIG:
+        case MPR_PROP_STATUS:
+        case MPR_PROP_SYNCED:
+        case MPR_PROP_VERSION:
+            return 1;
+        default:
+            return 0;
+    }
+}
+
+int mpr_graph_add_index(mpr_graph g, int obj_type, mpr_prop p, const char *key)
+{
+    mpr_prop_idx idx;
+    mpr_list l;
+    RETURN_ARG_UNLESS(g && (MPR_DEV == obj_type || MPR_SIG == obj_type || MPR_MAP == obj_type), 0);
+    if (key && !key[0])
+        key = 0;
+    RETURN_ARG_UNLESS(key || MPR_PROP_UNKNOWN != p, 0);
+    RETURN_ARG_UNLESS(!_is_volatile_prop(key ? mpr_prop_from_str(key) : p), 0);
+    RETURN_ARG_UNLESS(!_find_prop_idx(g, obj_type, p, key), 0);
+
+    idx = (mpr_prop_idx)calloc(1, sizeof(mpr_prop_idx_t));
+    idx->key = key ? strdup(key) : 0;
+    idx->prop = key ? MPR_PROP_UNKNOWN : p;
+    idx->obj_type = obj_type;
+    idx->next = g->prop_idxs;
+    g->prop_idxs = idx;
+
+    l = mpr_graph_get_objs(g, obj_type);
+    while (l) {
+        _prop_idx_update(idx, (mpr_obj)*l);
+        l = mpr_list_get_next(l);
+    }
+    return 1;
+}
+
+mpr_prop_idx mpr_graph_get_prop_idx(mpr_graph g, int obj_type, mpr_prop p, const char *key,
+                                    mpr_op op, int len, mpr_type type, const void *val)
+{
+    int i;
+    uint32_t hash;
+    double num;
+    RETURN_ARG_UNLESS(g && g->prop_idxs, 0);
+    switch (op) {
+        case MPR_OP_EQ:
+            /* string patterns with wildcards can match many values */
+            for (i = 0; MPR_STR == type && val && i < len; i++) {
+                const char *str = 1 == len ? (const char*)val : ((const char**)val)[i];
+                RETURN_ARG_UNLESS(str && !strchr(str, '*'), 0);
+            }
+            RETURN_ARG_UNLESS(_hash_prop_val(len, type, val, &hash), 0);
+            break;
+        case MPR_OP_GT:
+        case MPR_OP_GTE:
+        case MPR_OP_LT:
+        case MPR_OP_LTE:
+            RETURN_ARG_UNLESS(1 == len && _prop_idx_num(type, val, 0, &num) && num == num, 0);
+            break;
+        default:
+            return 0;
+    }
+    return _find_prop_idx(g, obj_type, p, key && key[0] ? key : 0);
+}
+
+mpr_obj mpr_prop_idx_get_next(mpr_prop_idx idx, mpr_obj o, mpr_op op, int len, mpr_type type,
+                              const void *val)
+{
+    mpr_prop_idx_entry e = 0, *ptr;
+    uint32_t hash;
+    double num;
+    int i;
+
+    if (MPR_OP_EQ == op) {
+        _hash_prop_val(len, type, val, &hash);
+        if (o) {
+            RETURN_ARG_UNLESS((ptr = _prop_idx_find(idx, o)), 0);
+            e = (*ptr)->next_by_val;
+        }
+        else if (idx->count)
+            e = idx->by_val[hash & (idx->size - 1)];
+        while (e && e->hash != hash)
+            e = e->next_by_val;
+        return e ? e->obj : 0;
+    }
+
+    /* the remaining operators compare single numbers */
+    _prop_idx_num(type, val, 0, &num);
+    if (idx->sorted_dirty)
+        _prop_idx_sort(idx);
+    if (o) {
+        RETURN_ARG_UNLESS((ptr = _prop_idx_find(idx, o)) && (*ptr)->sorted_pos >= 0, 0);
+        i = (*ptr)->sorted_pos + 1;
+    }
+    else if (MPR_OP_GT == op || MPR_OP_GTE == op) {
+        /* binary search for the first value >= num, the filter decides about equal values */
+        int end = idx->num_sorted;
+        i = 0;
+        while (i < end) {
+            int mid = (i + end) / 2;
+            if (idx->sorted[mid]->num < num)
+                i = mid + 1;
+            else
+                end = mid;
+        }
+    }
+    else
+        i = 0;
+    RETURN_ARG_UNLESS(i < idx->num_sorted, 0);
+    if ((MPR_OP_LT == op || MPR_OP_LTE == op) && idx->sorted[i]->num > num)
+        return 0;
+    return idx->sorted[i]->obj;
+}
+
+void mpr_graph_reindex_obj(mpr_graph g, mpr_obj o)
+{
+    mpr_graph_idx idx;
+    RETURN_UNLESS(g && o);
+    _update_prop_idxs(g, o);
+    RETURN_UNLESS(idx = _get_idx(g, o, IDX_ID));
+    _idx_set(idx, o, IDX_ID, 1, _hash_id(o->id));
+
+    RETURN_UNLESS(idx = _get_idx(g, o, IDX_NAME));
+    if (MPR_DEV == o->type) {
+        mpr_dev dev = (mpr_dev)o;
+        _idx_set(idx, o, IDX_NAME, dev->name != 0, dev->name ? _hash_str(dev->name, 0) : 0);
+    }
+    else {
+        mpr_sig sig = (mpr_sig)o;
+        _idx_set(idx, o, IDX_NAME, sig->name != 0,
+                 sig->name ? _hash_sig_name((mpr_dev)sig->dev, sig->name) : 0);
+    }
+}
+
+static void _unindex_obj(mpr_graph g, mpr_obj o)
+{
+    mpr_graph_idx idx;
+    _unindex_prop_idxs(g, o);
+    if ((idx = _get_idx(g, o, IDX_ID)))
+        _idx_remove(idx, o, IDX_ID);
+    if ((idx = _get_idx(g, o, IDX_NAME)))
+        _idx_remove(idx, o, IDX_NAME);
+}
+
+static void _free_idx(mpr_graph_idx idx)
+{
+    FUNC_IF(free, idx->buckets);
+    memset(idx, 0, sizeof(mpr_graph_idx_t));
+}
+
 void mpr_graph_cleanup(mpr_graph g)
 {
     int staged = 0;
@@ -171,7 +683,7 @@ mpr_graph mpr_graph_new(int subscribe_flags)
         _autosubscribe(g, subscribe_flags);
 
     /* TODO: consider whether graph objects should sync properties over the network. */
-    tbl = g->obj.props.synced = mpr_tbl_new();
+    tbl = g->obj.props.synced = mpr_tbl_new(&g->keys);
     mpr_tbl_link(tbl, PROP(DATA), 1, MPR_PTR, &g->obj.data,
                  LOCAL_MODIFY | INDIRECT | LOCAL_ACCESS_ONLY);
     mpr_tbl_set(tbl, PROP(LIBVER), NULL, 1, MPR_STR, PACKAGE_VERSION, NON_MODIFIABLE);
@@ -180,6 +692,16 @@ mpr_graph mpr_graph_new(int subscribe_flags)
     return g;
 }
 
+static void _free_sig_keys(mpr_graph g)
+{
+    int i;
+    for (i = 0; i < g->num_sig_keys; i++)
+        free(g->sig_keys[i]);
+    FUNC_IF(free, g->sig_keys);
+    g->sig_keys = 0;
+    g->num_sig_keys = 0;
+}
+
 void mpr_graph_free(mpr_graph g)
 {
     mpr_list list;
@@ -231,7 +753,7 @@ void mpr_graph_free(mpr_graph g)
             }
             sigs = mpr_list_get_next(sigs);
             if (no_local_sig_maps)
-                mpr_graph_remove_sig(g, sig, MPR_OBJ_REM);
+                mpr_graph_remove_sig(g, sig, MPR_OBJ_REM, 0);
         }
         if (no_local_dev_maps)
             mpr_graph_remove_dev(g, dev, MPR_OBJ_REM, 1);
@@ -239,18 +761,29 @@ void mpr_graph_free(mpr_graph g)
 
     mpr_net_free(&g->net);
     FUNC_IF(mpr_tbl_free, g->obj.props.synced);
+    _free_idx(&g->devs_by_id);
+    _free_idx(&g->devs_by_name);
+    _free_idx(&g->sigs_by_id);
+    _free_idx(&g->sigs_by_name);
+    _free_idx(&g->maps_by_id);
+    _free_prop_idxs(g);
+    _free_sig_keys(g);
+    mpr_key_pool_free(&g->keys);
+    mpr_list_free_pools(g->pools);
     free(g);
 }
 
 /**** Generic records ****/
 
-static mpr_obj _obj_by_id(mpr_graph g, void *obj_list, mpr_id id)
+static mpr_obj _obj_by_id(mpr_graph_idx idx, mpr_id id)
 {
-    mpr_list objs = mpr_list_from_data(obj_list);
-    while (objs) {
-        if (id == (*objs)->id)
-            return *objs;
-        objs = mpr_list_get_next(objs);
+    mpr_obj o;
+    RETURN_ARG_UNLESS(idx->count, NULL);
+    o = idx->buckets[_hash_id(id) & (idx->size - 1)];
+    while (o) {
+        if (id == o->id)
+            return o;
+        o = o->idx[IDX_ID].next;
     }
     return NULL;
 }
@@ -258,11 +791,11 @@ static mpr_obj _obj_by_id(mpr_graph g, void *obj_list, mpr_id id)
 mpr_obj mpr_graph_get_obj(mpr_graph g, mpr_type type, mpr_id id)
 {
     if (type & MPR_DEV)
-        return _obj_by_id(g, g->devs, id);
+        return _obj_by_id(&g->devs_by_id, id);
     if (type & MPR_SIG)
-        return _obj_by_id(g, g->sigs, id);
+        return _obj_by_id(&g->sigs_by_id, id);
     if (type & MPR_MAP)
-        return _obj_by_id(g, g->maps, id);
+        return _obj_by_id(&g->maps_by_id, id);
     return 0;
 }
 
@@ -301,6 +834,7 @@ int mpr_graph_add_cb(mpr_graph g, mpr_graph_handler *h, int types, const void *u
 void mpr_graph_call_cbs(mpr_graph g, mpr_obj o, mpr_type t, mpr_graph_evt e)
 {
     fptr_list cb = g->callbacks, temp;
+    ++g->version;
     while (cb) {
         temp = cb->next;
         if (cb->types & t)
@@ -338,7 +872,7 @@ static void _remove_by_qry(mpr_graph g, mpr_list l, mpr_graph_evt e)
         l = mpr_list_get_next(l);
         switch ((int)o->type) {
             case MPR_LINK:  mpr_graph_remove_link(g, (mpr_link)o, e);   break;
-            case MPR_SIG:   mpr_graph_remove_sig(g, (mpr_sig)o, e);     break;
+            case MPR_SIG:   mpr_graph_remove_sig(g, (mpr_sig)o, e, 0);  break;
             case MPR_MAP:   mpr_graph_remove_map(g, (mpr_map)o, e);     break;
             default:                                                    break;
         }
@@ -351,11 +885,11 @@ mpr_dev mpr_graph_add_dev(mpr_graph g, const char *name, mpr_msg msg)
 {
     const char *no_slash = skip_slash(name);
     mpr_dev dev = mpr_graph_get_dev_by_name(g, no_slash);
-    int rc = 0, updated = 0;
+    int rc = 0, updated = 0, prev_version = -1, had_session = 0, prev_session = 0, session;
 
     if (!dev) {
         trace_graph("adding device '%s'.\n", name);
-        dev = (mpr_dev)mpr_list_add_item((void**)&g->devs, sizeof(*dev));
+        dev = (mpr_dev)mpr_list_add_item((void**)&g->devs, sizeof(*dev), &g->pools);
         dev->name = strdup(no_slash);
         dev->obj.id = crc32(0L, (const Bytef *)no_slash, strlen(no_slash));
         dev->obj.id <<= 32;
@@ -363,13 +897,29 @@ mpr_dev mpr_graph_add_dev(mpr_graph g, const char *name, mpr_msg msg)
         dev->obj.graph = g;
         dev->is_local = 0;
         init_dev_prop_tbl(dev);
+        mpr_graph_reindex_obj(g, (mpr_obj)dev);
         rc = 1;
     }
 
     if (dev) {
+        if (!rc) {
+            prev_version = dev->obj.version;
+            had_session = _get_session(dev, &prev_session);
+        }
         updated = mpr_dev_set_from_msg(dev, msg);
         if (!rc)
             trace_graph("updated %d props for device '%s'.\n", updated, name);
+        if (prev_version >= 0
+            && (   dev->obj.version < prev_version
+                || (had_session && (!_get_session(dev, &session) || session != prev_session)))) {
+            /* the device has restarted, our copy can't be patched with deltas */
+            mpr_subscription s = _get_subscription(g, dev);
+            if (s) {
+                trace_graph("device '%s' has restarted, resyncing.\n", name);
+                dev->obj.version = -1;
+                send_subscribe_msg(g, dev, s->flags, AUTOSUB_INTERVAL);
+            }
+        }
         mpr_time_set(&dev->synced, MPR_NOW);
 
         if (rc || updated)
@@ -396,8 +946,11 @@ void mpr_graph_remove_dev(mpr_graph g, mpr_dev d, mpr_graph_evt e, int quiet)
     _remove_by_qry(g, mpr_dev_get_sigs(d, MPR_DIR_ANY), e);
 
     mpr_list_remove_item((void**)&g->devs, d);
+    _unindex_obj(g, (mpr_obj)d);
 
-    if (!quiet)
+    if (quiet)
+        ++g->version;
+    else
         mpr_graph_call_cbs(g, (mpr_obj)d, MPR_DEV, e);
 
     FUNC_IF(mpr_tbl_free, d->obj.props.synced);
@@ -409,12 +962,14 @@ void mpr_graph_remove_dev(mpr_graph g, mpr_dev d, mpr_graph_evt e, int quiet)
 mpr_dev mpr_graph_get_dev_by_name(mpr_graph g, const char *name)
 {
     const char *no_slash = skip_slash(name);
-    mpr_list devs = mpr_list_from_data(g->devs);
-    while (devs) {
-        mpr_dev dev = (mpr_dev)*devs;
-        devs = mpr_list_get_next(devs);
+    mpr_obj o;
+    RETURN_ARG_UNLESS(g->devs_by_name.count, 0);
+    o = g->devs_by_name.buckets[_hash_str(no_slash, 0) & (g->devs_by_name.size - 1)];
+    while (o) {
+        mpr_dev dev = (mpr_dev)o;
         if (dev->name && (0 == strcmp(dev->name, no_slash)))
             return dev;
+        o = o->idx[IDX_NAME].next;
     }
     return 0;
 }
@@ -437,6 +992,117 @@ static void _check_dev_status(mpr_graph g, uint32_t time_sec)
 
 /**** Signals ****/
 
+mpr_sig mpr_graph_get_sig_by_name(mpr_graph g, mpr_dev dev, const char *name)
+{
+    const char *no_slash = skip_slash(name);
+    mpr_obj o;
+    RETURN_ARG_UNLESS(g->sigs_by_name.count, 0);
+    o = g->sigs_by_name.buckets[_hash_sig_name(dev, no_slash) & (g->sigs_by_name.size - 1)];
+    while (o) {
+        mpr_sig sig = (mpr_sig)o;
+        if ((sig->dev == dev) && (0 == strcmp(sig->name, no_slash)))
+            return sig;
+        o = o->idx[IDX_NAME].next;
+    }
+    return 0;
+}
+
+static void _lru_unlink(mpr_graph g, mpr_sig s)
+{
+    if (s->lru_prev)
+        s->lru_prev->lru_next = s->lru_next;
+    else if (g->lru_oldest == s)
+        g->lru_oldest = s->lru_next;
+    if (s->lru_next)
+        s->lru_next->lru_prev = s->lru_prev;
+    else if (g->lru_newest == s)
+        g->lru_newest = s->lru_prev;
+    s->lru_prev = s->lru_next = 0;
+}
+
+static void _lru_touch(mpr_graph g, mpr_sig s)
+{
+    RETURN_UNLESS(g->lru_newest != s);
+    _lru_unlink(g, s);
+    s->lru_prev = g->lru_newest;
+    if (g->lru_newest)
+        g->lru_newest->lru_next = s;
+    else
+        g->lru_oldest = s;
+    g->lru_newest = s;
+}
+
+/* Remove the least-recently updated remote signals until the graph is within its limit, first
+ * from devices we are not subscribed to. Signals used by maps and 'keep' are never removed. */
+static void _evict_sigs(mpr_graph g, mpr_sig keep)
+{
+    int any_dev;
+    mpr_sig s, next;
+    for (any_dev = 0; any_dev < 2; any_dev++) {
+        s = g->lru_oldest;
+        while (s && g->num_remote_sigs > g->max_sigs) {
+            next = s->lru_next;
+            if (s != keep && !s->slots && (any_dev || !s->dev->subscribed)) {
+                trace_graph("evicting signal '%s:%s'.\n", s->dev->name, s->name);
+                /* the signal still exists on the network, so keep the device's signal counts */
+                mpr_graph_remove_sig(g, s, MPR_OBJ_EXP, 1);
+            }
+            s = next;
+        }
+    }
+}
+
+void mpr_graph_set_retention(mpr_graph g, int num_props, const mpr_prop *props, int num_keys,
+                             const char **keys, int max_sigs)
+{
+    int i;
+    RETURN_UNLESS(g);
+    g->sig_props = 0;
+    _free_sig_keys(g);
+    if (num_props < 0 || !props)
+        num_props = 0;
+    if (num_keys < 0 || !keys)
+        num_keys = 0;
+    if (num_props || num_keys) {
+        for (i = 0; i < num_props; i++) {
+            /* extra properties are only kept if they are named in keys */
+            if (MASK_PROP_BITFLAGS(props[i]) != PROP(EXTRA))
+                g->sig_props |= (uint64_t)1 << PROP_TO_INDEX(props[i]);
+        }
+        /* these are needed to identify signals and to check maps */
+        g->sig_props |= (  ((uint64_t)1 << PROP_TO_INDEX(PROP(DEV)))
+                         | ((uint64_t)1 << PROP_TO_INDEX(PROP(DIR)))
+                         | ((uint64_t)1 << PROP_TO_INDEX(PROP(ID)))
+                         | ((uint64_t)1 << PROP_TO_INDEX(PROP(LEN)))
+                         | ((uint64_t)1 << PROP_TO_INDEX(PROP(NAME)))
+                         | ((uint64_t)1 << PROP_TO_INDEX(PROP(TYPE))));
+        if (num_keys) {
+            g->sig_keys = (char**)malloc(sizeof(char*) * num_keys);
+            for (i = 0; i < num_keys; i++) {
+                if (keys[i])
+                    g->sig_keys[g->num_sig_keys++] = strdup(keys[i]);
+            }
+        }
+    }
+    g->max_sigs = max_sigs > 0 ? max_sigs : 0;
+    if (g->max_sigs)
+        _evict_sigs(g, 0);
+}
+
+int mpr_graph_keeps_sig_prop(mpr_graph g, mpr_prop prop, const char *key)
+{
+    int i;
+    RETURN_ARG_UNLESS(g->sig_props, 1);
+    if (MASK_PROP_BITFLAGS(prop) != PROP(EXTRA))
+        return (g->sig_props & ((uint64_t)1 << PROP_TO_INDEX(prop))) != 0;
+    RETURN_ARG_UNLESS(key, 0);
+    for (i = 0; i < g->num_sig_keys; i++) {
+        if (0 == strcmp(g->sig_keys[i], key))
+            return 1;
+    }
+    return 0;
+}
+
 mpr_sig mpr_graph_add_sig(mpr_graph g, const char *name, const char *dev_name, mpr_msg msg)
 {
     mpr_sig sig = 0;
@@ -453,7 +1119,7 @@ mpr_sig mpr_graph_add_sig(mpr_graph g, const char *name, const char *dev_name, m
 
     if (!sig) {
         trace_graph("adding signal '%s:%s'.\n", dev_name, name);
-        sig = (mpr_sig)mpr_list_add_item((void**)&g->sigs, sizeof(mpr_sig_t));
+        sig = (mpr_sig)mpr_list_add_item((void**)&g->sigs, sizeof(mpr_sig_t), &g->pools);
 
         /* also add device record if necessary */
         sig->dev = dev;
@@ -461,13 +1127,19 @@ mpr_sig mpr_graph_add_sig(mpr_graph g, const char *name, const char *dev_name, m
         sig->is_local = 0;
 
         mpr_sig_init(sig, MPR_DIR_UNDEFINED, name, 0, 0, 0, 0, 0, 0);
+        mpr_dev_add_sig_ref(dev, sig);
+        mpr_graph_reindex_obj(g, (mpr_obj)sig);
+        ++g->num_remote_sigs;
         rc = 1;
     }
 
     if (sig) {
+        _lru_touch(g, sig);
         updated = mpr_sig_set_from_msg(sig, msg);
         if (!rc)
             trace_graph("updated %d props for signal '%s:%s'.\n", updated, dev_name, name);
+        if (rc && g->max_sigs && g->num_remote_sigs > g->max_sigs)
+            _evict_sigs(g, sig);
 
         if (rc || updated)
             mpr_graph_call_cbs(g, (mpr_obj)sig, MPR_SIG, rc ? MPR_OBJ_NEW : MPR_OBJ_MOD);
@@ -475,7 +1147,7 @@ mpr_sig mpr_graph_add_sig(mpr_graph g, const char *name, const char *dev_name, m
     return sig;
 }
 
-void mpr_graph_remove_sig(mpr_graph g, mpr_sig s, mpr_graph_evt e)
+void mpr_graph_remove_sig(mpr_graph g, mpr_sig s, mpr_graph_evt e, int expire)
 {
     RETURN_UNLESS(s);
 
@@ -483,12 +1155,21 @@ void mpr_graph_remove_sig(mpr_graph g, mpr_sig s, mpr_graph_evt e)
     _remove_by_qry(g, mpr_sig_get_maps(s, MPR_DIR_ANY), e);
 
     mpr_list_remove_item((void**)&g->sigs, s);
+    _unindex_obj(g, (mpr_obj)s);
+    mpr_dev_record_removal((mpr_obj)s);
+    mpr_dev_remove_sig_ref(s->dev, s);
+    if (!s->is_local) {
+        _lru_unlink(g, s);
+        --g->num_remote_sigs;
+    }
     mpr_graph_call_cbs(g, (mpr_obj)s, MPR_SIG, e);
 
-    if (s->dir & MPR_DIR_IN)
-        --s->dev->num_inputs;
-    if (s->dir & MPR_DIR_OUT)
-        --s->dev->num_outputs;
+    if (!expire) {
+        if (s->dir & MPR_DIR_IN)
+            --s->dev->num_inputs;
+        if (s->dir & MPR_DIR_OUT)
+            --s->dev->num_outputs;
+    }
 
     mpr_sig_free_internal(s);
     mpr_list_free_item(s);
@@ -504,7 +1185,7 @@ mpr_link mpr_graph_add_link(mpr_graph g, mpr_dev dev1, mpr_dev dev2)
     if (link)
         return link;
 
-    link = (mpr_link)mpr_list_add_item((void**)&g->links, sizeof(mpr_link_t));
+    link = (mpr_link)mpr_list_add_item((void**)&g->links, sizeof(mpr_link_t), &g->pools);
     if (dev2->is_local) {
         link->devs[LOCAL_DEV] = dev2;
         link->devs[REMOTE_DEV] = dev1;
@@ -515,6 +1196,10 @@ mpr_link mpr_graph_add_link(mpr_graph g, mpr_dev dev1, mpr_dev dev2)
     }
     link->obj.type = MPR_LINK;
     link->obj.graph = g;
+    ++g->version;
+    mpr_dev_add_link_ref(link->devs[0], link);
+    if (link->devs[1] != link->devs[0])
+        mpr_dev_add_link_ref(link->devs[1], link);
     mpr_link_init(link);
     return link;
 }
@@ -524,6 +1209,10 @@ void mpr_graph_remove_link(mpr_graph g, mpr_link l, mpr_graph_evt e)
     RETURN_UNLESS(l);
     _remove_by_qry(g, mpr_link_get_maps(l), e);
     mpr_list_remove_item((void**)&g->links, l);
+    ++g->version;
+    mpr_dev_remove_link_ref(l->devs[0], l);
+    if (l->devs[1] != l->devs[0])
+        mpr_dev_remove_link_ref(l->devs[1], l);
     mpr_link_free(l);
     mpr_list_free_item(l);
 }
@@ -590,8 +1279,8 @@ mpr_map mpr_graph_add_map(mpr_graph g, mpr_id id, int num_src, const char **src_
     /* We could be part of larger "convergent" mapping, so we will retrieve
      * record by mapping id instead of names. */
     if (id) {
-        map = (mpr_map)_obj_by_id(g, (mpr_obj)g->maps, id);
-        if (!map && _obj_by_id(g, (mpr_obj)g->maps, 0)) {
+        map = (mpr_map)_obj_by_id(&g->maps_by_id, id);
+        if (!map && _obj_by_id(&g->maps_by_id, 0)) {
             /* may have staged map stored locally */
             map = mpr_graph_get_map_by_names(g, num_src, src_names, dst_name);
         }
@@ -618,7 +1307,8 @@ mpr_map mpr_graph_add_map(mpr_graph g, mpr_id id, int num_src, const char **src_
         is_local += dst_sig->is_local;
 
         map = (mpr_map)mpr_list_add_item((void**)&g->maps,
-                                         is_local ? sizeof(mpr_local_map_t) : sizeof(mpr_map_t));
+                                         is_local ? sizeof(mpr_local_map_t) : sizeof(mpr_map_t),
+                                         &g->pools);
         map->obj.type = MPR_MAP;
         map->obj.graph = g;
         map->obj.id = id;
@@ -629,6 +1319,7 @@ mpr_map mpr_graph_add_map(mpr_graph g, mpr_id id, int num_src, const char **src_
             map->src[i] = mpr_slot_new(map, src_sigs[i], is_local, 1);
         map->dst = mpr_slot_new(map, dst_sig, is_local, 0);
         mpr_map_init(map);
+        mpr_graph_reindex_obj(g, (mpr_obj)map);
         ++g->staged_maps;
         rc = 1;
     }
@@ -702,6 +1393,8 @@ void mpr_graph_remove_map(mpr_graph g, mpr_map m, mpr_graph_evt e)
 {
     RETURN_UNLESS(m);
     mpr_list_remove_item((void**)&g->maps, m);
+    _unindex_obj(g, (mpr_obj)m);
+    mpr_dev_record_removal((mpr_obj)m);
     mpr_graph_call_cbs(g, (mpr_obj)m, MPR_MAP, e);
     mpr_map_free(m);
     mpr_list_free_item(m);
@@ -772,17 +1465,64 @@ static void renew_subscriptions(mpr_graph g, uint32_t time_sec)
     }
 }
 
+void mpr_graph_housekeeping(mpr_graph g)
+{
+    mpr_time t;
+    mpr_net_poll(&g->net);
+    mpr_time_set(&t, MPR_NOW);
+    renew_subscriptions(g, t.sec);
+    _check_dev_status(g, t.sec);
+}
+
+int mpr_graph_get_housekeeping_timeout(mpr_graph g, double now)
+{
+    double next;
+    mpr_list devs;
+    mpr_subscription s = g->subscriptions;
+    int ms = mpr_net_get_timeout(&g->net, now);
+    RETURN_ARG_UNLESS(ms, 0);
+    next = now + ms * 0.001;
+
+    /* see renew_subscriptions() */
+    while (s) {
+        if (s->lease_expiration_sec < next)
+            next = s->lease_expiration_sec;
+        s = s->next;
+    }
+
+    /* see _check_dev_status() */
+    devs = mpr_list_from_data(g->devs);
+    while (devs) {
+        mpr_dev dev = (mpr_dev)*devs;
+        devs = mpr_list_get_next(devs);
+        if (dev->synced.sec && dev->synced.sec + TIMEOUT_SEC + 1 < next)
+            next = dev->synced.sec + TIMEOUT_SEC + 1;
+    }
+    return mpr_ms_until(next, now);
+}
+
+int mpr_graph_get_next_timeout(mpr_graph g)
+{
+    int i, ms;
+    mpr_time t;
+    double now;
+    RETURN_ARG_UNLESS(g, 0);
+    mpr_time_set(&t, MPR_NOW);
+    now = mpr_time_as_dbl(t);
+
+    ms = mpr_graph_get_housekeeping_timeout(g, now);
+    for (i = 0; i < g->net.num_devs && ms > 0; i++)
+        ms = mpr_dev_get_timeout(g->net.devs[i], t, ms);
+    return ms;
+}
+
 int mpr_graph_poll(mpr_graph g, int block_ms)
 {
     mpr_net n = &g->net;
     int count = 0, status[2], left_ms, elapsed, checked_admin = 0;
-    mpr_time t;
     double then;
 
-    mpr_net_poll(n);
-    mpr_time_set(&t, MPR_NOW);
-    renew_subscriptions(g, t.sec);
-    _check_dev_status(g, t.sec);
+    mpr_graph_housekeeping(g);
 
     if (!block_ms) {
         if (lo_servers_recv_noblock(&n->servers[SERVER_ADMIN], status, 2, 0)) {
@@ -803,10 +1543,7 @@ int mpr_graph_poll(mpr_graph g, int block_ms)
 
         elapsed = (mpr_get_current_time() - then) * 1000;
         if ((elapsed - checked_admin) > 100) {
-            mpr_time_set(&t, MPR_NOW);
-            renew_subscriptions(g, t.sec);
-            mpr_net_poll(n);
-            _check_dev_status(g, t.sec);
+            mpr_graph_housekeeping(g);
             checked_admin = elapsed;
         }
 
@@ -874,7 +1611,7 @@ void mpr_graph_subscribe(mpr_graph g, mpr_dev d, int flags, int timeout)
             s->next = g->subscriptions;
             g->subscriptions = s;
         }
-        d->subscribed = 1;
+        d->subscribed = flags;
         if (s->flags == flags)
             return;
 
@@ -887,13 +1624,19 @@ void mpr_graph_subscribe(mpr_graph g, mpr_dev d, int flags, int timeout)
 
         timeout = AUTOSUB_INTERVAL;
     }
-#ifdef DEBUG
     else {
+        mpr_time t;
+#ifdef DEBUG
         trace_graph("adding temporary %d-second subscription to device '%s' with flags ",
                     timeout, mpr_dev_get_name(d));
         print_subscription_flags(flags);
-    }
 #endif
+        /* only ask for changes if an existing subscription keeps our copy current */
+        if (!_get_subscription(g, d))
+            d->obj.version = -1;
+        mpr_time_set(&t, MPR_NOW);
+        d->sub_lease_end = t.sec + timeout;
+    }
 
     send_subscribe_msg(g, d, flags, timeout);
 }
@@ -905,14 +1648,20 @@ void mpr_graph_unsubscribe(mpr_graph g, mpr_dev d)
     mpr_graph_subscribe(g, d, 0, 0);
 }
 
+static int _subscribed(mpr_dev dev)
+{
+    mpr_time t;
+    RETURN_ARG_UNLESS(dev, 0);
+    if (dev->subscribed || !dev->sub_lease_end)
+        return dev->subscribed;
+    /* temporary subscriptions are not recorded by type */
+    mpr_time_set(&t, MPR_NOW);
+    return dev->sub_lease_end >= t.sec ? MPR_OBJ : 0;
+}
+
 int mpr_graph_subscribed_by_dev(mpr_graph g, const char *name)
 {
-    mpr_dev dev = mpr_graph_get_dev_by_name(g, name);
-    if (dev) {
-        mpr_subscription s = _get_subscription(g, dev);
-        return s ? s->flags : 0;
-    }
-    return 0;
+    return _subscribed(mpr_graph_get_dev_by_name(g, name));
 }
 
 int mpr_graph_subscribed_by_sig(mpr_graph g, const char *name)
@@ -927,11 +1676,7 @@ int mpr_graph_subscribed_by_sig(mpr_graph g, const char *name)
     strncpy(devname, devnamep, devnamelen);
     devname[devnamelen] = 0;
     dev = mpr_graph_get_dev_by_name(g, devname);
-    if (dev) {
-        mpr_subscription s = _get_subscription(g, dev);
-        return s ? s->flags : 0;
-    }
-    return 0;
+    return _subscribed(dev);
 }
 
 void mpr_graph_set_interface(mpr_graph g, const char *iface)
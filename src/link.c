@@ -23,13 +23,13 @@ void mpr_link_init(mpr_link link)
     if (!link->num_maps)
         link->num_maps = (int*)calloc(1, sizeof(int) * 2);
     if (!link->obj.props.synced) {
-        mpr_tbl t = link->obj.props.synced = mpr_tbl_new();
+        mpr_tbl t = link->obj.props.synced = mpr_tbl_new(&link->obj.graph->keys);
         mpr_tbl_link(t, MPR_PROP_DEV, 2, MPR_DEV, &link->devs, NON_MODIFIABLE | LOCAL_ACCESS_ONLY);
         mpr_tbl_link(t, MPR_PROP_ID, 1, MPR_INT64, &link->obj.id, NON_MODIFIABLE);
         mpr_tbl_link(t, MPR_PROP_NUM_MAPS, 2, MPR_INT32, &link->num_maps, NON_MODIFIABLE | INDIRECT);
     }
     if (!link->obj.props.staged)
-        link->obj.props.staged = mpr_tbl_new();
+        link->obj.props.staged = mpr_tbl_new(&link->obj.graph->keys);
 
     if (!link->obj.id && link->devs[LOCAL_DEV]->is_local)
         link->obj.id = mpr_dev_generate_unique_id(link->devs[LOCAL_DEV]);
@@ -74,6 +74,16 @@ void mpr_link_connect(mpr_link link, const char *host, int admin_port,
     mpr_dev_add_link(link->devs[LOCAL_DEV], link->devs[REMOTE_DEV]);
 }
 
+void mpr_link_negotiate_compact(mpr_link link, mpr_msg props)
+{
+    mpr_msg_atom a = props ? mpr_msg_get_prop_by_key(props, MPR_COMPACT_DATA_KEY) : 0;
+    link->compact = (   a && 'T' == a->types[0]
+                     && mpr_obj_get_prop_as_int32((mpr_obj)link->devs[LOCAL_DEV],
+                                                  MPR_PROP_EXTRA, MPR_COMPACT_DATA_KEY));
+    trace_dev(link->devs[LOCAL_DEV], "%s compact signal updates to device '%s'\n",
+              link->compact ? "using" : "not using", link->devs[REMOTE_DEV]->name);
+}
+
 void mpr_link_free(mpr_link link)
 {
     int i;
@@ -48,24 +48,100 @@ typedef int query_compare_func_t(const void *ctx_data, const void *item);
 /*! Function for freeing query context */
 typedef void query_free_func_t(mpr_list_header_t *lh);
 
+/*! Function returning the next candidate item for a query, or the first if item is zero. */
+typedef void *query_next_func_t(const void *ctx_data, const void *item);
+
 /*! Function for handling parallel queries. */
 static int cmp_parallel_query(const void *ctx_data, const void *dev);
 
+/*! Function for handling cached queries. */
+static int cmp_cached_query(const void *ctx_data, const void *item);
+
 /*! Contains some function pointers and data for handling query context. */
 typedef struct _query_info {
     unsigned int size;
     query_compare_func_t *query_compare;
     query_free_func_t *query_free;
+    query_next_func_t *query_next;  /* if set, used instead of walking the list */
     int *data; /* stub */
 } query_info_t;
 
 #define LIST_HEADER_SIZE (sizeof(mpr_list_header_t)-sizeof(int[1]))
 
+/* Graph objects are carved from slab pools of same-sized items owned by the graph. Each item
+ * starts with a pointer to its pool, followed by the list header and the object itself, so that
+ * mpr_list_free_item() can return it without knowing its type. Released items are kept on a free
+ * list and reused, and the chunks themselves are only released by mpr_list_free_pools(). */
+#define POOL_ITEM_OFFSET sizeof(mpr_pool)
+#define POOL_MIN_CHUNK_LEN 16
+#define POOL_MAX_CHUNK_LEN 1024
+
+typedef union _pool_chunk {
+    union _pool_chunk *next;
+    double align;
+} pool_chunk_t;
+
+static mpr_pool get_pool(mpr_pool *pools, size_t item_size)
+{
+    mpr_pool pool = *pools;
+    while (pool && pool->item_size != item_size)
+        pool = pool->next;
+    if (!pool && (pool = (mpr_pool)calloc(1, sizeof(mpr_pool_t)))) {
+        pool->item_size = item_size;
+        pool->next = *pools;
+        *pools = pool;
+    }
+    return pool;
+}
+
+static void *pool_alloc(mpr_pool pool)
+{
+    void *item;
+    if ((item = pool->free_items))
+        pool->free_items = *(void**)item;
+    else {
+        if (!pool->num_unused) {
+            /* grow chunks geometrically so that small graphs stay small */
+            int len = pool->chunk_len ? pool->chunk_len * 2 : POOL_MIN_CHUNK_LEN;
+            pool_chunk_t *chunk;
+            if (len > POOL_MAX_CHUNK_LEN)
+                len = POOL_MAX_CHUNK_LEN;
+            chunk = (pool_chunk_t*)malloc(sizeof(pool_chunk_t) + pool->item_size * len);
+            RETURN_ARG_UNLESS(chunk, 0);
+            chunk->next = (pool_chunk_t*)pool->chunks;
+            pool->chunks = chunk;
+            pool->chunk_len = pool->num_unused = len;
+        }
+        item = ((char*)pool->chunks + sizeof(pool_chunk_t)
+                + pool->item_size * (pool->chunk_len - pool->num_unused));
+        --pool->num_unused;
+    }
+    memset(item, 0, pool->item_size);
+    *(mpr_pool*)item = pool;
+    return item;
+}
+
+void mpr_list_free_pools(mpr_pool pools)
+{
+    while (pools) {
+        mpr_pool pool = pools;
+        pool_chunk_t *chunk;
+        pools = pools->next;
+        while ((chunk = (pool_chunk_t*)pool->chunks)) {
+            pool->chunks = chunk->next;
+            free(chunk);
+        }
+        free(pool);
+    }
+}
+
 /*! Reserve memory for a list item.  Reserves an extra pointer at the
  *  beginning of the structure to allow for a list pointer. */
-static mpr_list_header_t* mpr_list_new_item(size_t size)
+static mpr_list_header_t* mpr_list_new_item(size_t size, mpr_pool *pools)
 {
     mpr_list_header_t *lh=0;
+    mpr_pool pool = 0;
+    char *mem;
 
     /* make sure the compiler is doing what we think it's doing with
      * the size of mpr_list_header_t and location of data */
@@ -74,9 +150,15 @@ static mpr_list_header_t* mpr_list_new_item(size_t size)
     die_unless(LIST_HEADER_SIZE == ((char*)&lh->data - (char*)lh),
                "unexpected offset for data in mpr_list_header_t");
 
-    size += LIST_HEADER_SIZE;
-    lh = calloc(1, size);
-    RETURN_ARG_UNLESS(lh, 0);
+    /* round up to keep the items of a pool aligned */
+    size += POOL_ITEM_OFFSET + LIST_HEADER_SIZE + sizeof(double) - 1;
+    size &= ~(sizeof(double) - 1);
+    if (pools && (pool = get_pool(pools, size)))
+        mem = (char*)pool_alloc(pool);
+    else if ((mem = (char*)calloc(1, size)))
+        *(mpr_pool*)mem = 0;
+    RETURN_ARG_UNLESS(mem, 0);
+    lh = (mpr_list_header_t*)(mem + POOL_ITEM_OFFSET);
     lh->self = &lh->data;
     lh->start = &lh->self;
     lh->query_type = QUERY_STATIC;
@@ -126,9 +208,10 @@ static void *mpr_list_prepend_item(void *item, void **list)
     return item;
 }
 
-void *mpr_list_add_item(void **list, size_t size)
+void *mpr_list_add_item(void **list, size_t size, mpr_pool *pools)
 {
-    mpr_list_header_t* lh = mpr_list_new_item(size);
+    mpr_list_header_t* lh = mpr_list_new_item(size, pools);
+    RETURN_ARG_UNLESS(lh, 0);
     mpr_list_prepend_item(lh, list);
     return lh;
 }
@@ -153,8 +236,17 @@ void mpr_list_remove_item(void **head, void *item)
 /*! Free the memory used by a list item */
 void mpr_list_free_item(void *item)
 {
-    if (item)
-        free(mpr_list_header_by_data(item));
+    mpr_pool pool;
+    char *mem;
+    RETURN_UNLESS(item);
+    mem = (char*)mpr_list_header_by_data(item) - POOL_ITEM_OFFSET;
+    if ((pool = *(mpr_pool*)mem)) {
+        /* return the item to its pool */
+        *(void**)mem = pool->free_items;
+        pool->free_items = mem;
+    }
+    else
+        free(mem);
 }
 
 /** Structures and functions for performing dynamic queries **/
@@ -163,13 +255,23 @@ void mpr_list_free_item(void *item)
  * format and query continuation. Functions specific to particular
  * queries are defined further down with their compare operation. */
 
+/* Queries normally test every item of the list they were created on, but they can instead be
+ * given a function producing a smaller set of candidates, e.g. the signals of one device. The
+ * list is still used as the base for unions with other queries. */
+static void *query_next_candidate(mpr_list_header_t *lh, void *item)
+{
+    if (lh->query_ctx && lh->query_ctx->query_next)
+        return lh->query_ctx->query_next(&lh->query_ctx->data, item);
+    return item ? mpr_list_get_next_internal(item) : *lh->start;
+}
+
 void **mpr_list_query_continuation(mpr_list_header_t *lh)
 {
-    void *item = mpr_list_header_by_data(lh->self)->next;
+    void *item = query_next_candidate(lh, lh->self);
     while (item) {
         if (lh->query_ctx->query_compare(&lh->query_ctx->data, item))
             break;
-        item = mpr_list_get_next_internal(item);
+        item = query_next_candidate(lh, item);
     }
 
     if (item) {
@@ -190,10 +292,9 @@ static void free_query_single_ctx(mpr_list_header_t *lh)
         void *data = &lh->query_ctx->data;
         mpr_list_header_t *lh1 = *(mpr_list_header_t**)data;
         mpr_list_header_t *lh2 = *(mpr_list_header_t**)((char*)data + sizeof(void*));
-        free_query_single_ctx(lh1);
-        free_query_single_ctx(lh2);
+        lh1->query_ctx->query_free(lh1);
+        lh2->query_ctx->query_free(lh2);
     }
-    free(lh->query_ctx);
     free(lh);
 }
 
@@ -260,6 +361,19 @@ else {                                                  \
 }                                                       \
 offset += sizeof(TYPE) * num_args;
 
+/* Query headers and their context are allocated together. */
+#define QUERY_HEADER_SIZE ((LIST_HEADER_SIZE + sizeof(double) - 1) & ~(sizeof(double) - 1))
+
+static mpr_list_header_t *new_query_header(size_t ctx_size)
+{
+    mpr_list_header_t *lh = (mpr_list_header_t*)calloc(1, QUERY_HEADER_SIZE + ctx_size);
+    RETURN_ARG_UNLESS(lh, 0);
+    lh->query_type = QUERY_DYNAMIC;
+    lh->query_ctx = (query_info_t*)((char*)lh + QUERY_HEADER_SIZE);
+    lh->query_ctx->size = ctx_size;
+    return lh;
+}
+
 /* We need to be careful of memory alignment here - for now we will just ensure
  * that string arguments are always passed last. */
 static void **new_query_internal(const void **list, int size, const void *func,
@@ -269,10 +383,9 @@ static void **new_query_internal(const void **list, int size, const void *func,
     int offset = 0, i = 0, j, num_args;
     char *data;
     RETURN_ARG_UNLESS(list && size && func && types, 0);
-    lh = (mpr_list_header_t*)malloc(LIST_HEADER_SIZE);
+    lh = new_query_header(sizeof(query_info_t) + size);
+    RETURN_ARG_UNLESS(lh, 0);
     lh->next = (void*)mpr_list_query_continuation;
-    lh->query_type = QUERY_DYNAMIC;
-    lh->query_ctx = (query_info_t*)malloc(sizeof(query_info_t)+size);
 
     data = (char*)&lh->query_ctx->data;
     while (types[i]) {
@@ -314,21 +427,27 @@ static void **new_query_internal(const void **list, int size, const void *func,
                 }
                 break;
             default:
-                free(lh->query_ctx);
                 free(lh);
                 return 0;
         }
         ++i;
     }
 
-    lh->query_ctx->size = sizeof(query_info_t) + size;
     lh->query_ctx->query_compare = (query_compare_func_t*)func;
     lh->query_ctx->query_free = (query_free_func_t*)free_query_single_ctx;
+    lh->query_ctx->query_next = 0;
     lh->start = (void**)list;
     lh->self = *lh->start;
     return &lh->self;
 }
 
+static void set_query_next(mpr_list list, const void *next)
+{
+    mpr_list_header_t *lh = mpr_list_header_by_self(list);
+    lh->query_ctx->query_next = (query_next_func_t*)next;
+    lh->self = query_next_candidate(lh, 0);
+}
+
 mpr_list mpr_list_new_query(const void **list, const void *func,
                             const char *types, ...)
 {
@@ -345,12 +464,30 @@ mpr_list mpr_list_new_query(const void **list, const void *func,
     return qry;
 }
 
+mpr_list mpr_list_new_query_from(const void **list, const void *next, const void *func,
+                                 const char *types, ...)
+{
+    int size;
+    va_list aq;
+    mpr_list qry;
+    va_start(aq, types);
+    size = get_query_size(types, aq);
+    va_end(aq);
+
+    va_start(aq, types);
+    qry = (mpr_list)new_query_internal(list, size, func, types, aq);
+    va_end(aq);
+    if (qry)
+        set_query_next(qry, next);
+    return qry;
+}
+
 mpr_list mpr_list_start(mpr_list list)
 {
     mpr_list_header_t *lh;
     RETURN_ARG_UNLESS(list, 0);
     lh = mpr_list_header_by_self(list);
-    lh->self = *lh->start;
+    lh->self = query_next_candidate(lh, 0);
     if (QUERY_DYNAMIC == lh->query_type) {
         if (!*list)
             return 0;
@@ -399,6 +536,165 @@ void mpr_list_free(mpr_list list)
         lh->query_ctx->query_free(lh);
 }
 
+/* Cached queries store the results of another list in an array, so that their size and indexed
+ * items can be retrieved in constant time. The source query is kept and the cache is rebuilt from
+ * it whenever the version of the graph has changed since it was last built. Static lists always
+ * start at an object in the graph, so instead of them we cache the graph list they belong to. */
+typedef struct {
+    mpr_list_header_t *src;     /* the query to cache, owned by the cached query, or zero */
+    void **start;               /* the graph list to cache if src is zero */
+    mpr_graph graph;            /* the graph of the cached objects, if any */
+    uint32_t version;           /* graph version at the last rebuild */
+    int size;
+    int alloc_size;
+    int pos;                    /* index of the current item */
+    void **items;
+} cache_ctx_t;
+
+static void cache_rebuild(cache_ctx_t *c)
+{
+    mpr_list_header_t *src = c->src;
+    void *item = src ? query_next_candidate(src, 0) : *c->start;
+    c->size = 0;
+    while (item) {
+        if (!src || src->query_ctx->query_compare(&src->query_ctx->data, item)) {
+            if (c->size >= c->alloc_size) {
+                c->alloc_size = c->alloc_size ? c->alloc_size * 2 : 8;
+                c->items = realloc(c->items, c->alloc_size * sizeof(void*));
+            }
+            c->items[c->size++] = item;
+        }
+        item = src ? query_next_candidate(src, item) : mpr_list_get_next_internal(item);
+    }
+    if (c->size)
+        c->graph = ((mpr_obj)c->items[0])->graph;
+    if (c->graph)
+        c->version = c->graph->version;
+}
+
+/* Rebuild the cache if the graph has changed. Returns 1 if it was rebuilt. */
+static int cache_validate(cache_ctx_t *c)
+{
+    if (c->graph && c->graph->version == c->version)
+        return 0;
+    cache_rebuild(c);
+    return 1;
+}
+
+/* Get the index following item, which was at index idx before any rebuild of the cache. If item
+ * has been removed from the graph we continue with the item that took its place. */
+static int cache_next_idx(cache_ctx_t *c, const void *item, int idx)
+{
+    int i;
+    if (!cache_validate(c) && idx < c->size && c->items[idx] == item)
+        return idx + 1;
+    for (i = 0; i < c->size; i++) {
+        if (c->items[i] == item)
+            return i + 1;
+    }
+    return idx;
+}
+
+static int cmp_cached_query(const void *ctx_data, const void *item)
+{
+    cache_ctx_t *c = (cache_ctx_t*)ctx_data;
+    int i;
+    if (c->src)
+        return c->src->query_ctx->query_compare(&c->src->query_ctx->data, item);
+    for (i = 0; i < c->size; i++) {
+        if (c->items[i] == item)
+            return 1;
+    }
+    return 0;
+}
+
+static void *next_cached_query(const void *ctx_data, const void *item)
+{
+    cache_ctx_t *c = (cache_ctx_t*)ctx_data;
+    if (item)
+        c->pos = cache_next_idx(c, item, c->pos);
+    else {
+        cache_validate(c);
+        c->pos = 0;
+    }
+    return c->pos < c->size ? c->items[c->pos] : 0;
+}
+
+static void free_cached_query(mpr_list_header_t *lh)
+{
+    cache_ctx_t *c = (cache_ctx_t*)&lh->query_ctx->data;
+    if (c->src && c->src->query_ctx->query_free)
+        c->src->query_ctx->query_free(c->src);
+    FUNC_IF(free, c->items);
+    free(lh);
+}
+
+static void **cached_query_continuation(mpr_list_header_t *lh)
+{
+    if ((lh->self = next_cached_query(&lh->query_ctx->data, lh->self)))
+        return &lh->self;
+    free_cached_query(lh);
+    return 0;
+}
+
+mpr_list mpr_list_get_cached(mpr_list list)
+{
+    mpr_list_header_t *src, *lh;
+    cache_ctx_t *c;
+    RETURN_ARG_UNLESS(list, 0);
+    src = mpr_list_header_by_self(list);
+    if (QUERY_DYNAMIC == src->query_type && cmp_cached_query == src->query_ctx->query_compare)
+        return list;
+
+    lh = new_query_header(sizeof(query_info_t) + sizeof(cache_ctx_t));
+    RETURN_ARG_UNLESS(lh, 0);
+    lh->next = (void*)cached_query_continuation;
+    lh->query_ctx->query_compare = cmp_cached_query;
+    lh->query_ctx->query_free = free_cached_query;
+    lh->query_ctx->query_next = next_cached_query;
+
+    c = (cache_ctx_t*)&lh->query_ctx->data;
+    if (QUERY_DYNAMIC == src->query_type) {
+        c->src = src;
+        c->start = src->start;
+    }
+    else {
+        mpr_obj o = (mpr_obj)*list;
+        switch (o->type) {
+            case MPR_DEV:   c->start = (void**)&o->graph->devs;     break;
+            case MPR_SIG:   c->start = (void**)&o->graph->sigs;     break;
+            case MPR_MAP:   c->start = (void**)&o->graph->maps;     break;
+            case MPR_LINK:  c->start = (void**)&o->graph->links;    break;
+            default:        c->start = src->start;                  break;
+        }
+    }
+    lh->start = c->start;
+    cache_rebuild(c);
+
+    /* keep the current position of the source list */
+    c->pos = cache_next_idx(c, *list, 0) - 1;
+    if (c->pos < 0 || c->pos >= c->size) {
+        free_cached_query(lh);
+        return 0;
+    }
+    lh->self = c->items[c->pos];
+    return (mpr_list)&lh->self;
+}
+
+static mpr_obj get_cached_idx(mpr_list_header_t *lh, unsigned int idx)
+{
+    cache_ctx_t *c = (cache_ctx_t*)&lh->query_ctx->data;
+    cache_validate(c);
+    return idx < c->size ? (mpr_obj)c->items[idx] : 0;
+}
+
+static int get_cached_size(mpr_list_header_t *lh)
+{
+    cache_ctx_t *c = (cache_ctx_t*)&lh->query_ctx->data;
+    cache_validate(c);
+    return c->size;
+}
+
 mpr_obj mpr_list_get_idx(mpr_list list, unsigned int idx)
 {
     int i = 0;
@@ -406,6 +702,9 @@ mpr_obj mpr_list_get_idx(mpr_list list, unsigned int idx)
     RETURN_ARG_UNLESS(list && idx >= 0, 0);
     lh = mpr_list_header_by_self(list);
 
+    if (QUERY_DYNAMIC == lh->query_type && cmp_cached_query == lh->query_ctx->query_compare)
+        return get_cached_idx(lh, idx);
+
     /* Reset to beginning of list */
     lh->self = *lh->start;
     mpr_list_start(list);
@@ -437,13 +736,45 @@ static int cmp_parallel_query(const void *ctx_data, const void *list)
     }
 }
 
+/* The result of an intersection or difference is a subset of the first list, so its candidates
+ * can be taken from there. */
+static void *next_parallel_query(const void *ctx_data, const void *item)
+{
+    mpr_list_header_t *lh1 = *(mpr_list_header_t**)ctx_data;
+    return query_next_candidate(lh1, (void*)item);
+}
+
+/* An intersection is also a subset of the second list, e.g. of a filter using a property index. */
+static void *next_parallel_query_rhs(const void *ctx_data, const void *item)
+{
+    mpr_list_header_t *lh2 = *(mpr_list_header_t**)((char*)ctx_data + sizeof(void*));
+    return query_next_candidate(lh2, (void*)item);
+}
+
+static mpr_list new_parallel_query(mpr_list_header_t *lh1, mpr_list_header_t *lh2, binary_op_t op)
+{
+    mpr_list qry = mpr_list_new_query((const void **)lh1->start, (void*)cmp_parallel_query,
+                                      "vvi", &lh1, &lh2, op);
+    if (!qry || OP_UNION == op)
+        return qry;
+    if (lh1->query_ctx && lh1->query_ctx->query_next)
+        set_query_next(qry, (void*)next_parallel_query);
+    else if (OP_INTERSECTION == op && lh2->query_ctx && lh2->query_ctx->query_next)
+        set_query_next(qry, (void*)next_parallel_query_rhs);
+    return qry;
+}
+
 static mpr_list_header_t *mpr_list_header_cpy(mpr_list_header_t *lh)
 {
-    mpr_list_header_t *cpy = (mpr_list_header_t*)malloc(LIST_HEADER_SIZE);
+    mpr_list_header_t *cpy;
+    if (!lh->query_ctx) {
+        cpy = (mpr_list_header_t*)malloc(LIST_HEADER_SIZE);
+        memcpy(cpy, lh, LIST_HEADER_SIZE);
+        return cpy;
+    }
+    cpy = new_query_header(lh->query_ctx->size);
     memcpy(cpy, lh, LIST_HEADER_SIZE);
-    RETURN_ARG_UNLESS(lh->query_ctx, cpy);
-
-    cpy->query_ctx = (query_info_t*)malloc(lh->query_ctx->size);
+    cpy->query_ctx = (query_info_t*)((char*)cpy + QUERY_HEADER_SIZE);
     memcpy(cpy->query_ctx, lh->query_ctx, lh->query_ctx->size);
 
     if (cmp_parallel_query == cpy->query_ctx->query_compare) {
@@ -458,6 +789,14 @@ static mpr_list_header_t *mpr_list_header_cpy(mpr_list_header_t *lh)
         lh1 = *(mpr_list_header_t**)data;
         lh2 = *(mpr_list_header_t**)((char*)data + sizeof(void*));
     }
+    else if (cmp_cached_query == cpy->query_ctx->query_compare) {
+        /* this is a cached query – we need to copy the source list and the cached items */
+        cache_ctx_t *c = (cache_ctx_t*)&cpy->query_ctx->data;
+        if (c->src)
+            c->src = mpr_list_header_cpy(c->src);
+        c->items = malloc(c->alloc_size * sizeof(void*));
+        memcpy(c->items, ((cache_ctx_t*)&lh->query_ctx->data)->items, c->size * sizeof(void*));
+    }
     return cpy;
 }
 
@@ -487,11 +826,11 @@ mpr_list mpr_list_get_isect(mpr_list list1, mpr_list list2)
     RETURN_ARG_UNLESS(list1 && list2, 0);
     lh1 = mpr_list_header_by_self(list1);
     lh2 = mpr_list_header_by_self(list2);
-    return mpr_list_start(mpr_list_new_query((const void **)lh1->start, (void*)cmp_parallel_query,
-                                             "vvi", &lh1, &lh2, OP_INTERSECTION));
+    return mpr_list_start(new_parallel_query(lh1, lh2, OP_INTERSECTION));
 }
 
-static mpr_list mpr_list_filter_internal(mpr_list list, const void *func, const char *types, ...)
+static mpr_list mpr_list_filter_internal(mpr_list list, const void *next, const void *func,
+                                         const char *types, ...)
 {
     int size;
     va_list aq;
@@ -509,14 +848,15 @@ static mpr_list mpr_list_filter_internal(mpr_list list, const void *func, const
     va_start(aq, types);
     filter = new_query_internal((const void **)lh1->start, size, func, types, aq);
     va_end(aq);
+    if (filter && next)
+        set_query_next((mpr_list)filter, next);
 
     if (QUERY_STATIC == lh1->query_type)
         return (mpr_list)filter;
 
     /* return intersection */
     lh2 = mpr_list_header_by_self(filter);
-    return mpr_list_new_query((const void **)lh1->start, (void*)cmp_parallel_query,
-                              "vvi", &lh1, &lh2, OP_INTERSECTION);
+    return new_parallel_query(lh1, lh2, OP_INTERSECTION);
 }
 
 #define COMPARE_TYPE(TYPE)                      \
@@ -589,7 +929,7 @@ static int filter_by_prop(const void *ctx, mpr_obj o)
     int len =         *(int*)       ((char*)ctx + sizeof(int)*2);
     mpr_type type =   *(mpr_type*)  ((char*)ctx + sizeof(int)*3);
     void *val =       *(void**)     ((char*)ctx + sizeof(int)*4);
-    const char *key =  (const char*)((char*)ctx + sizeof(int)*4 + sizeof(void*));
+    const char *key =  (const char*)((char*)ctx + sizeof(int)*4 + sizeof(void*)*2);
     int _len;
     mpr_type _type;
     const void *_val;
@@ -625,14 +965,30 @@ static int filter_by_prop(const void *ctx, mpr_obj o)
     return compare_val(op, len, type, _val, val);
 }
 
+/* If the graph has an index on the filtered property, only the objects it returns for the
+ * filter value are tested. */
+static void *next_by_prop_idx(const void *ctx, const void *o)
+{
+    mpr_op op =       *(int*)       ((char*)ctx + sizeof(int));
+    int len =         *(int*)       ((char*)ctx + sizeof(int)*2);
+    mpr_type type =   *(mpr_type*)  ((char*)ctx + sizeof(int)*3);
+    void *val =       *(void**)     ((char*)ctx + sizeof(int)*4);
+    mpr_prop_idx idx = *(mpr_prop_idx*)((char*)ctx + sizeof(int)*4 + sizeof(void*));
+    return mpr_prop_idx_get_next(idx, (mpr_obj)o, op, len, type, val);
+}
+
 mpr_list mpr_list_filter(mpr_list list, mpr_prop p, const char *key, int len,
                          mpr_type type, const void *val, mpr_op op)
 {
     int mask = MPR_OP_ALL | MPR_OP_ANY;
+    mpr_prop_idx idx;
     if (!list || op <= MPR_OP_UNDEFINED || (op | mask) > (MPR_OP_NEQ | mask))
         return list;
-    return mpr_list_start(mpr_list_filter_internal(list, (void*)filter_by_prop, "iiicvs", p, op,
-                                                   len, type, &val, key));
+    idx = mpr_graph_get_prop_idx(((mpr_obj)*list)->graph, ((mpr_obj)*list)->type, p, key, op,
+                                 len, type, val);
+    return mpr_list_start(mpr_list_filter_internal(list, idx ? (void*)next_by_prop_idx : 0,
+                                                   (void*)filter_by_prop, "iiicvvs", p, op, len,
+                                                   type, &val, &idx, key));
 }
 
 mpr_list mpr_list_get_diff(mpr_list list1, mpr_list list2)
@@ -642,8 +998,7 @@ mpr_list mpr_list_get_diff(mpr_list list1, mpr_list list2)
     RETURN_ARG_UNLESS(list2, list1);
     lh1 = mpr_list_header_by_self(list1);
     lh2 = mpr_list_header_by_self(list2);
-    return mpr_list_start(mpr_list_new_query((const void **)lh1->start, (void*)cmp_parallel_query,
-                                             "vvi", &lh1, &lh2, OP_DIFFERENCE));
+    return mpr_list_start(new_parallel_query(lh1, lh2, OP_DIFFERENCE));
 }
 
 int mpr_list_get_size(mpr_list list)
@@ -653,6 +1008,8 @@ int mpr_list_get_size(mpr_list list)
     RETURN_ARG_UNLESS(list, 0);
     lh = mpr_list_header_by_self(list);
     RETURN_ARG_UNLESS(lh->start && *lh->start, 0);
+    if (QUERY_DYNAMIC == lh->query_type && cmp_cached_query == lh->query_ctx->query_compare)
+        return get_cached_size(lh);
     if (QUERY_DYNAMIC == lh->query_type) {
         /* use a copy */
         list = mpr_list_get_cpy(list);
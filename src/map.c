@@ -69,20 +69,27 @@ static int _cmp_qry_scopes(const void *ctx, mpr_dev d)
 void mpr_map_init(mpr_map m)
 {
     int i, is_local = 0;
-    mpr_tbl t = m->obj.props.synced = mpr_tbl_new();
+    mpr_tbl t = m->obj.props.synced = mpr_tbl_new(&m->obj.graph->keys);
     mpr_list q = mpr_list_new_query((const void**)&m->obj.graph->devs,
                                     (void*)_cmp_qry_scopes, "v", &m);
-    m->obj.props.staged = mpr_tbl_new();
+    m->obj.props.staged = mpr_tbl_new(&m->obj.graph->keys);
+    /* a negative deadband disables it, zero only drops repeated values */
+    m->deadband = -1;
 
     /* these properties need to be added in alphabetical order */
+    mpr_tbl_link(t, PROP(COALESCE), 1, MPR_INT32, &m->coalesce, REMOTE_MODIFY);
     mpr_tbl_link(t, PROP(DATA), 1, MPR_PTR, &m->obj.data,
                  MODIFIABLE | INDIRECT | LOCAL_ACCESS_ONLY);
+    mpr_tbl_link(t, PROP(DEADBAND), 1, MPR_FLT, &m->deadband, REMOTE_MODIFY);
     mpr_tbl_link(t, PROP(EXPR), 1, MPR_STR, &m->expr_str, MODIFIABLE | INDIRECT);
     mpr_tbl_link(t, PROP(ID), 1, MPR_INT64, &m->obj.id, NON_MODIFIABLE | LOCAL_ACCESS_ONLY);
     mpr_tbl_link(t, PROP(MUTED), 1, MPR_BOOL, &m->muted, MODIFIABLE);
     mpr_tbl_link(t, PROP(NUM_SIGS_IN), 1, MPR_INT32, &m->num_src, NON_MODIFIABLE);
+    mpr_tbl_link(t, PROP(NUM_SUPPRESSED), 1, MPR_INT32, &m->num_suppressed,
+                 NON_MODIFIABLE | LOCAL_ACCESS_ONLY);
     mpr_tbl_link(t, PROP(PROCESS_LOC), 1, MPR_INT32, &m->process_loc, MODIFIABLE);
     mpr_tbl_link(t, PROP(PROTOCOL), 1, MPR_INT32, &m->protocol, REMOTE_MODIFY);
+    mpr_tbl_link(t, PROP(RATE), 1, MPR_FLT, &m->rate, REMOTE_MODIFY);
     mpr_tbl_link(t, PROP(SCOPE), 1, MPR_LIST, q, NON_MODIFIABLE | PROP_OWNED);
     mpr_tbl_link(t, PROP(STATUS), 1, MPR_INT32, &m->status, NON_MODIFIABLE);
     mpr_tbl_link(t, PROP(USE_INST), 1, MPR_BOOL, &m->use_inst, REMOTE_MODIFY);
@@ -161,9 +168,11 @@ mpr_map mpr_map_new(int num_src, mpr_sig *src, int num_dst, mpr_sig *dst)
         is_local = 1;
 
     m = (mpr_map)mpr_list_add_item((void**)&g->maps,
-                                   is_local ? sizeof(mpr_local_map_t) : sizeof(mpr_map_t));
+                                   is_local ? sizeof(mpr_local_map_t) : sizeof(mpr_map_t),
+                                   &g->pools);
     m->obj.type = MPR_MAP;
     m->obj.graph = g;
+    ++g->version;
     m->num_src = num_src;
     m->is_local = 0;
     m->src = (mpr_slot*)malloc(sizeof(mpr_slot) * num_src);
@@ -180,8 +189,11 @@ mpr_map mpr_map_new(int num_src, mpr_sig *src, int num_dst, mpr_sig *dst)
                 ((mpr_sig)o)->type = src[order[i]]->type;
             }
             dev = ((mpr_sig)o)->dev;
-            if (!dev->obj.id)
+            if (!dev->obj.id) {
                 dev->obj.id = src[order[i]]->dev->obj.id;
+                mpr_graph_reindex_obj(g, (mpr_obj)dev);
+            }
+            mpr_graph_reindex_obj(g, o);
         }
         m->src[i] = mpr_slot_new(m, (mpr_sig)o, is_local, 1);
         m->src[i]->id = i;
@@ -194,6 +206,7 @@ mpr_map mpr_map_new(int num_src, mpr_sig *src, int num_dst, mpr_sig *dst)
         m->obj.id = mpr_dev_generate_unique_id((*dst)->dev);
 
     mpr_map_init(m);
+    mpr_graph_reindex_obj(g, (mpr_obj)m);
     m->protocol = MPR_PROTO_UDP;
     ++g->staged_maps;
     return m;
@@ -440,6 +453,358 @@ static int _update_scope(mpr_map m, mpr_msg_atom a)
  * 4) when it comes to "to release" idmap, send release and decref LID
  */
 
+/* Coalesced or rate-limited updates are tracked on local source slots when processing
+ * takes place at a remote destination, since no expression is evaluated locally. */
+static int _tracks_pending(mpr_local_map m)
+{
+    return (   (MPR_COALESCE_NONE != m->coalesce || m->rate > 0)
+            && MPR_LOC_DST == m->process_loc && MPR_DIR_OUT == m->dst->dir);
+}
+
+static void _alloc_pending(mpr_local_map m)
+{
+    int i, pending = _tracks_pending(m);
+    for (i = 0; i < m->num_src; i++) {
+        mpr_sig sig = m->src[i]->sig;
+        if (sig->is_local)
+            mpr_slot_alloc_pending(m->src[i], pending ? mpr_sig_get_num_inst_idx(sig) : 0);
+    }
+}
+
+/* Returns 1 if an outgoing map evaluates its expression locally. */
+static int _evaluates_output(mpr_local_map m)
+{
+    return (   m->expr && m->num_inst && MPR_DIR_OUT == m->src[0]->dir
+            && (m->is_local_only || MPR_LOC_SRC == m->process_loc));
+}
+
+/* Helper to read a vector element as a double, returns 0 if the element is NULL. */
+static int _get_elem_dbl(const void *val, mpr_type type, int idx, double *d)
+{
+    switch (type) {
+        case MPR_INT32: *d = ((int*)val)[idx];      return 1;
+        case MPR_FLT:   *d = ((float*)val)[idx];    return 1;
+        case MPR_DBL:   *d = ((double*)val)[idx];   return 1;
+        default:                                    return 0;
+    }
+}
+
+/* Maps with a deadband remember the last output sent for each instance. */
+static void _reset_sent(mpr_local_map m, int inst_idx)
+{
+    int i, len = m->dst->sig->len;
+    double *sent;
+    RETURN_UNLESS(m->sent_vals);
+    sent = m->sent_vals + inst_idx * len;
+    for (i = 0; i < len; i++)
+        sent[i] = NAN;
+}
+
+static void _alloc_sent(mpr_local_map m)
+{
+    int i;
+    if (m->deadband < 0 || !_evaluates_output(m)) {
+        FUNC_IF(free, m->sent_vals);
+        m->sent_vals = 0;
+        return;
+    }
+    m->sent_vals = realloc(m->sent_vals, m->num_inst * m->dst->sig->len * sizeof(double));
+    for (i = 0; i < m->num_inst; i++)
+        _reset_sent(m, i);
+}
+
+/* Maps with element-wise expressions that are processed locally track which elements of each
+ * source instance have changed, so that only those elements of the output are sent. All
+ * elements start out dirty so the first update of each instance carries the whole vector. */
+static void _alloc_dirty(mpr_local_map m)
+{
+    int size, len = m->dst->sig->len;
+    if (   len < 2 || m->num_src > 1 || m->src[0]->sig->len != len || !_evaluates_output(m)
+        || !mpr_expr_get_is_elementwise(m->expr)) {
+        FUNC_IF(free, m->dirty_elems);
+        m->dirty_elems = 0;
+        return;
+    }
+    size = m->num_inst * (len / 8 + 1);
+    m->dirty_elems = realloc(m->dirty_elems, size);
+    memset(m->dirty_elems, 0xFF, size);
+}
+
+void mpr_map_set_dirty(mpr_local_map m, int inst_idx, const mpr_type *types)
+{
+    int i, len = m->dst->sig->len;
+    char *dirty;
+    RETURN_UNLESS(m->dirty_elems && inst_idx < m->num_inst);
+    dirty = m->dirty_elems + inst_idx * (len / 8 + 1);
+    if (!types) {
+        memset(dirty, 0xFF, len / 8 + 1);
+        return;
+    }
+    for (i = 0; i < len; i++) {
+        if (MPR_NULL != types[i])
+            set_bitflag(dirty, i);
+    }
+}
+
+/* Replace the unchanged elements of an evaluated output with MPR_NULL and clear the dirty
+ * elements of this instance. An output with no changed elements is left whole, since a vector
+ * of nulls would be received as an instance release. */
+static void _mask_clean(mpr_local_map m, int inst_idx, mpr_type *types)
+{
+    int i, len = m->dst->sig->len;
+    char *dirty;
+    RETURN_UNLESS(m->dirty_elems);
+    dirty = m->dirty_elems + inst_idx * (len / 8 + 1);
+    for (i = 0; i < len; i++) {
+        if (get_bitflag(dirty, i) && MPR_NULL != types[i])
+            break;
+    }
+    if (i < len) {
+        for (i = 0; i < len; i++) {
+            if (!get_bitflag(dirty, i))
+                types[i] = MPR_NULL;
+        }
+    }
+    memset(dirty, 0, len / 8 + 1);
+}
+
+/* Returns 1 if no element of an output value has changed by at least the deadband since
+ * the last value sent for this instance, otherwise records the value as sent. Elements that
+ * have not changed at all never count as changed, so a deadband of zero drops repeated values. */
+static int _suppress(mpr_local_map m, int inst_idx, const void *val, const mpr_type *types)
+{
+    int i, len = m->dst->sig->len;
+    double d, *sent;
+    RETURN_ARG_UNLESS(m->sent_vals, 0);
+    sent = m->sent_vals + inst_idx * len;
+    for (i = 0; i < len; i++) {
+        if (!_get_elem_dbl(val, types[i], i, &d))
+            continue;
+        if (isnan(sent[i]) || (d != sent[i] && fabs(d - sent[i]) >= m->deadband))
+            break;
+    }
+    if (i == len) {
+        ++m->num_suppressed;
+        return 1;
+    }
+    for (i = 0; i < len; i++) {
+        if (_get_elem_dbl(val, types[i], i, &d))
+            sent[i] = d;
+    }
+    return 0;
+}
+
+/* Rate-limited maps that are processed locally combine the evaluated output for
+ * each instance until the next output interval. */
+static void _alloc_held(mpr_local_map m)
+{
+    int size;
+    if (m->rate <= 0 || !_evaluates_output(m)) {
+        FUNC_IF(free, m->held_vals);
+        FUNC_IF(free, m->held_counts);
+        FUNC_IF(free, m->held_idmaps);
+        FUNC_IF(free, m->held_inst);
+        m->held_vals = 0;
+        m->held_counts = 0;
+        m->held_idmaps = 0;
+        m->held_inst = 0;
+        m->held = 0;
+        return;
+    }
+    /* any output held back so far is discarded */
+    size = m->num_inst * m->dst->sig->len;
+    m->held_vals = realloc(m->held_vals, size * sizeof(double));
+    m->held_counts = realloc(m->held_counts, size * sizeof(int));
+    memset(m->held_counts, 0, size * sizeof(int));
+    m->held_idmaps = realloc(m->held_idmaps, m->num_inst * sizeof(mpr_id_map));
+    m->held_inst = realloc(m->held_inst, m->num_inst / 8 + 1);
+    memset(m->held_inst, 0, m->num_inst / 8 + 1);
+    m->held = 0;
+}
+
+/* Combine an evaluated output value with any output already held for this instance. */
+static void _hold_inst(mpr_local_map m, int inst_idx, void *val, mpr_type *types,
+                       mpr_id_map idmap)
+{
+    int i, len = m->dst->sig->len;
+    double *held = m->held_vals + inst_idx * len;
+    int *counts = m->held_counts + inst_idx * len;
+    for (i = 0; i < len; i++) {
+        double d;
+        if (!_get_elem_dbl(val, types[i], i, &d))
+            continue;
+        if (!counts[i])
+            held[i] = d;
+        else if (MPR_COALESCE_MEAN == m->coalesce)
+            held[i] += d;
+        else if (MPR_COALESCE_MAX == m->coalesce) {
+            if (d > held[i])
+                held[i] = d;
+        }
+        else
+            held[i] = d;
+        ++counts[i];
+    }
+    m->held_idmaps[inst_idx] = idmap;
+    set_bitflag(m->held_inst, inst_idx);
+    m->held = 1;
+}
+
+static void _send_held_inst(mpr_local_map m, mpr_local_slot src_slot, int inst_idx,
+                            uint8_t bundle_idx)
+{
+    int i, len = m->dst->sig->len;
+    mpr_type type = m->dst->sig->type, *types;
+    double *held = m->held_vals + inst_idx * len;
+    int *counts = m->held_counts + inst_idx * len;
+    lo_message msg;
+    void *val;
+
+    RETURN_UNLESS(get_bitflag(m->held_inst, inst_idx));
+    unset_bitflag(m->held_inst, inst_idx);
+
+    types = alloca(len * sizeof(mpr_type));
+    val = alloca(len * mpr_type_get_size(type));
+    for (i = 0; i < len; i++) {
+        double d;
+        if (!counts[i]) {
+            /* value of vector elements can be <type> or NULL */
+            types[i] = MPR_NULL;
+            continue;
+        }
+        d = MPR_COALESCE_MEAN == m->coalesce ? held[i] / counts[i] : held[i];
+        switch (type) {
+            case MPR_INT32: ((int*)val)[i] = (int)d;        break;
+            case MPR_FLT:   ((float*)val)[i] = (float)d;    break;
+            case MPR_DBL:   ((double*)val)[i] = d;          break;
+            default:                                        break;
+        }
+        types[i] = type;
+        counts[i] = 0;
+    }
+    RETURN_UNLESS(!_suppress(m, inst_idx, val, types));
+    msg = mpr_map_build_msg(m, src_slot, val, types, m->held_idmaps[inst_idx]);
+    mpr_link_add_msg(m->dst->link, m->dst->sig, msg,
+                     *(mpr_time*)mpr_value_get_time(&m->dst->val, inst_idx),
+                     m->protocol, bundle_idx);
+}
+
+static void _send_held(mpr_local_map m, mpr_local_slot src_slot, uint8_t bundle_idx)
+{
+    int i;
+    for (i = 0; i < m->num_inst; i++)
+        _send_held_inst(m, src_slot, i, bundle_idx);
+    m->held = 0;
+}
+
+void mpr_map_clear_inst(mpr_local_map m, int inst_idx)
+{
+    int i;
+    RETURN_UNLESS(m && inst_idx >= 0);
+    for (i = 0; i < m->num_src; i++)
+        mpr_slot_clear_inst(m->src[i], inst_idx);
+    mpr_slot_clear_inst(m->dst, inst_idx);
+    RETURN_UNLESS(inst_idx < m->num_inst);
+    for (i = 0; i < m->num_vars; i++) {
+        /* user variables keep position 0 since they have no history */
+        mpr_value v = &m->vars[i];
+        memset(v->inst[inst_idx].samps, 0, v->mlen * v->vlen * mpr_type_get_size(v->type));
+        memset(v->inst[inst_idx].times, 0, v->mlen * sizeof(mpr_time));
+    }
+    if (m->held_inst) {
+        int len = m->dst->sig->len;
+        unset_bitflag(m->held_inst, inst_idx);
+        memset(m->held_counts + inst_idx * len, 0, len * sizeof(int));
+    }
+    if (m->updated_inst)
+        unset_bitflag(m->updated_inst, inst_idx);
+    _reset_sent(m, inst_idx);
+    mpr_map_set_dirty(m, inst_idx, 0);
+}
+
+/* Returns 1 if a rate-limited map must hold back its output at this time. */
+static int _rate_limited(mpr_local_map m, mpr_time time)
+{
+    RETURN_ARG_UNLESS(m->rate > 0, 0);
+    if (mpr_time_get_diff(time, m->last_sent) < 1.0 / m->rate) {
+        /* check again during the next device poll */
+        m->rtr->dev->sending = 1;
+        return 1;
+    }
+    mpr_time_set(&m->last_sent, time);
+    return 0;
+}
+
+double mpr_map_get_send_delay(mpr_local_map m, mpr_time time)
+{
+    double delay;
+    RETURN_ARG_UNLESS(m->rate > 0, 0);
+    delay = 1.0 / m->rate - mpr_time_get_diff(time, m->last_sent);
+    return delay > 0 ? delay : 0;
+}
+
+/* Source slot used to look up instance idmaps for outgoing maps.
+ * temporary solution: use most multitudinous source signal for idmap
+ * permanent solution: move idmaps to map? */
+static mpr_local_slot _get_idmap_src_slot(mpr_local_map m)
+{
+    int i;
+    mpr_local_slot src_slot = m->src[0];
+    for (i = 1; i < m->num_src; i++) {
+        if (m->src[i]->sig->num_inst > src_slot->sig->num_inst)
+            src_slot = m->src[i];
+    }
+    return src_slot;
+}
+
+/* Send any updates held back by coalescing or rate limiting. */
+static void _flush(mpr_local_map m)
+{
+    int i;
+    for (i = 0; i < m->num_src; i++)
+        mpr_map_send_pending(m, m->src[i], -1);
+    if (m->held)
+        _send_held(m, _get_idmap_src_slot(m), m->rtr->dev->bundle_idx % NUM_BUNDLES);
+    m->rtr->dev->sending = 1;
+}
+
+static void _send_pending_inst(mpr_local_map m, mpr_local_slot slot, int idmap_idx,
+                               mpr_type *types, uint8_t bundle_idx)
+{
+    lo_message msg;
+    mpr_local_sig sig = (mpr_local_sig)slot->sig;
+    mpr_sig_inst si = sig->idmaps[idmap_idx].inst;
+    RETURN_UNLESS(si && get_bitflag(slot->pending_inst, si->idx));
+    unset_bitflag(slot->pending_inst, si->idx);
+    RETURN_UNLESS(si->has_val);
+    msg = mpr_map_build_msg(m, slot, si->val, types,
+                            sig->use_inst ? sig->idmaps[idmap_idx].map : 0);
+    mpr_link_add_msg(m->dst->link, m->dst->sig, msg, si->time, m->protocol, bundle_idx);
+}
+
+void mpr_map_send_pending(mpr_local_map m, mpr_local_slot slot, int idmap_idx)
+{
+    int i;
+    mpr_local_sig sig;
+    mpr_type *types;
+    uint8_t bundle_idx;
+    RETURN_UNLESS(slot->pending_inst);
+
+    sig = (mpr_local_sig)slot->sig;
+    bundle_idx = m->rtr->dev->bundle_idx % NUM_BUNDLES;
+
+    /* bundle latest signal value without type coercion */
+    types = alloca(sig->len * sizeof(mpr_type));
+    memset(types, sig->type, sig->len);
+
+    if (idmap_idx >= 0)
+        _send_pending_inst(m, slot, idmap_idx, types, bundle_idx);
+    else {
+        for (i = 0; i < sig->idmap_len; i++)
+            _send_pending_inst(m, slot, i, types, bundle_idx);
+    }
+}
+
 /* only called for outgoing maps */
 void mpr_map_send(mpr_local_map m, mpr_time time)
 {
@@ -454,18 +819,24 @@ void mpr_map_send(mpr_local_map m, mpr_time time)
     mpr_value *src_vals;
     char *types;
 
-    RETURN_UNLESS(m->updated && m->expr && MPR_DIR_OUT == m->src[0]->dir && !m->muted);
+    RETURN_UNLESS(m->updated && !m->muted);
+
+    if (_tracks_pending(m)) {
+        /* processing is remote: send the latest value of each updated source instance */
+        if (_rate_limited(m, time))
+            return;
+        for (i = 0; i < m->num_src; i++)
+            mpr_map_send_pending(m, m->src[i], -1);
+        m->updated = 0;
+        return;
+    }
+
+    RETURN_UNLESS(m->expr && MPR_DIR_OUT == m->src[0]->dir);
 
     dev = m->rtr->dev;
     bundle_idx = dev->bundle_idx % NUM_BUNDLES;
 
-    /* temporary solution: use most multitudinous source signal for idmap
-     * permanent solution: move idmaps to map? */
-    src_slot = m->src[0];
-    for (i = 1; i < m->num_src; i++) {
-        if (m->src[i]->sig->num_inst > src_slot->sig->num_inst)
-            src_slot = m->src[i];
-    }
+    src_slot = _get_idmap_src_slot(m);
     src_sig = (mpr_local_sig)src_slot->sig;
     idmaps = src_sig->idmaps;
 
@@ -508,8 +879,14 @@ void mpr_map_send(mpr_local_map m, mpr_time time)
 
         /* send instance release if dst is instanced and either src or map is also instanced. */
         if (idmap && status & EXPR_RELEASE_BEFORE_UPDATE && m->use_inst) {
+            if (m->held_inst) {
+                /* send the final value before releasing the instance */
+                _send_held_inst(m, src_slot, i, bundle_idx);
+            }
             msg = mpr_map_build_msg(m, 0, 0, 0, idmap);
             mpr_link_add_msg(dst_slot->link, dst_slot->sig, msg, time, m->protocol, bundle_idx);
+            _reset_sent(m, i);
+            mpr_map_set_dirty(m, i, 0);
             if (map_manages_inst) {
                 mpr_dev_LID_decref(dev, 0, idmap);
                 idmap = m->idmap = 0;
@@ -518,19 +895,30 @@ void mpr_map_send(mpr_local_map m, mpr_time time)
         if (status & EXPR_UPDATE) {
             /* send instance update */
             void *result = mpr_value_get_samp(&dst_slot->val, i);
+            _mask_clean(m, i, types);
             if (map_manages_inst && !idmap) {
                 /* create an id_map and store it in the map */
                 idmap = m->idmap = mpr_dev_add_idmap(dev, 0, 0, 0);
             }
-            msg = mpr_map_build_msg(m, src_slot, result, types, idmap);
-            mpr_link_add_msg(dst_slot->link, dst_slot->sig, msg,
-                             *(mpr_time*)mpr_value_get_time(&dst_slot->val, i),
-                             m->protocol, bundle_idx);
+            if (m->held_inst)
+                _hold_inst(m, i, result, types, idmap);
+            else if (!_suppress(m, i, result, types)) {
+                msg = mpr_map_build_msg(m, src_slot, result, types, idmap);
+                mpr_link_add_msg(dst_slot->link, dst_slot->sig, msg,
+                                 *(mpr_time*)mpr_value_get_time(&dst_slot->val, i),
+                                 m->protocol, bundle_idx);
+            }
         }
         /* send instance release if dst is instanced and either src or map is also instanced. */
         if (idmap && status & EXPR_RELEASE_AFTER_UPDATE && m->use_inst) {
+            if (m->held_inst) {
+                /* send the final value before releasing the instance */
+                _send_held_inst(m, src_slot, i, bundle_idx);
+            }
             msg = mpr_map_build_msg(m, 0, 0, 0, idmap);
             mpr_link_add_msg(dst_slot->link, dst_slot->sig, msg, time, m->protocol, bundle_idx);
+            _reset_sent(m, i);
+            mpr_map_set_dirty(m, i, 0);
             if (map_manages_inst) {
                 mpr_dev_LID_decref(dev, 0, idmap);
                 idmap = m->idmap = 0;
@@ -541,6 +929,15 @@ void mpr_map_send(mpr_local_map m, mpr_time time)
     }
     clear_bitflags(m->updated_inst, m->num_inst);
     m->updated = 0;
+
+    if (m->held) {
+        if (_rate_limited(m, time)) {
+            /* keep the map in the outgoing queue until the interval has elapsed */
+            m->updated = 1;
+        }
+        else
+            _send_held(m, src_slot, bundle_idx);
+    }
 }
 
 /* only called for incoming maps */
@@ -638,6 +1035,7 @@ void mpr_map_receive(mpr_local_map m, mpr_time time)
             memcpy(si->val, result, type_size);
             memcpy(&si->time, &time, sizeof(mpr_time));
             si->has_val = 1;
+            mpr_sig_touch_inst(dst_sig, si);
 
             mpr_sig_call_handler(dst_sig, MPR_SIG_UPDATE, idmap ? idmap->LID : 0,
                                  dst_sig->len, si->val, &time, diff);
@@ -647,7 +1045,7 @@ void mpr_map_receive(mpr_local_map m, mpr_time time)
                 /* mark instance as updated */
                 set_bitflag(dst_sig->updated_inst, si->idx);
                 ((mpr_local_dev)dst_sig->dev)->sending = dst_sig->updated = 1;
-                mpr_rtr_process_sig(m->rtr, dst_sig, i, si->val, time);
+                mpr_rtr_process_sig(m->rtr, dst_sig, i, si->val, 0, time);
             }
         }
 
@@ -666,6 +1064,69 @@ void mpr_map_receive(mpr_local_map m, mpr_time time)
     m->updated = 0;
 }
 
+/* Helper to add a vector value as a single compact blob if the destination link has negotiated
+ * support for it and the vector length fits the header. Partial vector updates are packed as the
+ * values of the elements that are present followed by their indices. */
+static int _add_compact_val(lo_message msg, mpr_local_map m, mpr_local_slot slot, int len,
+                            const void *val, const mpr_type *types, mpr_id_map idmap)
+{
+    int i, j, num = 0, size, data_size;
+    mpr_type type = MPR_NULL;
+    mpr_compact_hdr_t *hdr;
+    char *data;
+    uint16_t *indices;
+    lo_blob blob;
+    RETURN_ARG_UNLESS(len > 1 && len <= MPR_COMPACT_MAX_LEN, 0);
+    RETURN_ARG_UNLESS(m->dst->link && m->dst->link->compact, 0);
+    for (i = 0; i < len; i++) {
+        if (MPR_NULL == types[i])
+            continue;
+        if (MPR_NULL == type)
+            type = types[i];
+        else
+            RETURN_ARG_UNLESS(types[i] == type, 0);
+        ++num;
+    }
+    RETURN_ARG_UNLESS(num && mpr_type_get_is_num(type), 0);
+
+    size = mpr_type_get_size(type);
+    data_size = num * size;
+    if (num < len)
+        data_size += num * sizeof(uint16_t);
+    hdr = alloca(sizeof(mpr_compact_hdr_t) + data_size);
+    memset(hdr, 0, sizeof(mpr_compact_hdr_t));
+    hdr->flags = mpr_get_is_big_endian() ? MPR_COMPACT_BIG_ENDIAN : 0;
+    hdr->type = type;
+    hdr->len = len;
+    if (m->use_inst && idmap) {
+        hdr->flags |= MPR_COMPACT_HAS_INST;
+        hdr->GID = idmap->GID;
+    }
+    if (slot) {
+        hdr->flags |= MPR_COMPACT_HAS_SLOT;
+        hdr->slot = slot->id;
+    }
+    data = (char*)(hdr + 1);
+    if (num < len) {
+        hdr->flags |= MPR_COMPACT_SPARSE;
+        indices = (uint16_t*)(data + num * size);
+        for (i = 0, j = 0; i < len; i++) {
+            if (MPR_NULL == types[i])
+                continue;
+            memcpy(data + j * size, (char*)val + i * size, size);
+            indices[j++] = i;
+        }
+    }
+    else
+        memcpy(data, val, data_size);
+
+    blob = lo_blob_new(sizeof(mpr_compact_hdr_t) + data_size, hdr);
+    RETURN_ARG_UNLESS(blob, 0);
+    lo_message_add_blob(msg, blob);
+    lo_blob_free(blob);
+    return 1;
+}
+
 /*! Build a value update message for a given map. */
 lo_message mpr_map_build_msg(mpr_local_map m, mpr_local_slot slot, const void *val,
                              mpr_type *types, mpr_id_map idmap)
@@ -677,6 +1138,9 @@ lo_message mpr_map_build_msg(mpr_local_map m, mpr_local_slot slot, const void *v
     else if (slot)
         len = slot->sig->len;
 
+    if (val && types && _add_compact_val(msg, m, slot, len, val, types, idmap))
+        return msg;
+
     if (val && types) {
         /* value of vector elements can be <type> or NULL */
         for (i = 0; i < len; i++) {
@@ -715,6 +1179,8 @@ void mpr_map_alloc_values(mpr_local_map m)
     mpr_value_t *vars;
     const char **var_names;
 
+    _alloc_pending(m);
+
     /* If there is no expression or the processing is remote,
      * then no memory needs to be (re)allocated. */
     RETURN_UNLESS(m->expr
@@ -727,9 +1193,10 @@ void mpr_map_alloc_values(mpr_local_map m)
     if (MPR_DIR_OUT == m->dst->dir) {
         int max_num_inst = 0;
         for (i = 0; i < m->num_src; i++) {
+            int src_num_inst = mpr_sig_get_num_inst_idx(m->src[i]->sig);
             hist_size = mpr_expr_get_in_hist_size(e, i);
-            max_num_inst = _max(m->src[i]->sig->num_inst, max_num_inst);
-            mpr_slot_alloc_values(m->src[i], m->src[i]->sig->num_inst, hist_size);
+            max_num_inst = _max(src_num_inst, max_num_inst);
+            mpr_slot_alloc_values(m->src[i], src_num_inst, hist_size);
         }
         hist_size = mpr_expr_get_out_hist_size(e);
         /* allocate enough dst slot and variable instances for the most multitudinous source signal */
@@ -738,13 +1205,13 @@ void mpr_map_alloc_values(mpr_local_map m)
     }
     else if (MPR_DIR_IN == m->dst->dir) {
         /* allocate enough instances for destination signal */
+        num_inst = mpr_sig_get_num_inst_idx(m->dst->sig);
         for (i = 0; i < m->num_src; i++) {
             hist_size = mpr_expr_get_in_hist_size(e, i);
-            mpr_slot_alloc_values(m->src[i], m->dst->sig->num_inst, hist_size);
+            mpr_slot_alloc_values(m->src[i], num_inst, hist_size);
         }
         hist_size = mpr_expr_get_out_hist_size(e);
-        mpr_slot_alloc_values(m->dst, m->dst->sig->num_inst, hist_size);
-        num_inst = m->dst->sig->num_inst;
+        mpr_slot_alloc_values(m->dst, num_inst, hist_size);
     }
 
     num_vars = mpr_expr_get_num_vars(e);
@@ -793,6 +1260,10 @@ void mpr_map_alloc_values(mpr_local_map m)
         m->updated_inst = realloc(m->updated_inst, num_inst / 8 + 1);
     else
         m->updated_inst = calloc(1, num_inst / 8 + 1);
+
+    _alloc_held(m);
+    _alloc_sent(m);
+    _alloc_dirty(m);
 }
 
 /* Helper to replace a map's expression only if the given string
@@ -809,7 +1280,7 @@ static int _replace_expr_str(mpr_local_map m, const char *expr_str)
         src_types[i] = m->src[i]->sig->type;
         src_lens[i] = m->src[i]->sig->len;
     }
-    expr = mpr_expr_new_from_str(m->rtr->dev->expr_stack, expr_str, m->num_src, src_types,
+    expr = mpr_expr_new_from_str(0, expr_str, m->num_src, src_types,
                                  src_lens, m->dst->sig->type, m->dst->sig->len);
     RETURN_ARG_UNLESS(expr, 1);
 
@@ -1172,6 +1643,7 @@ static int _set_expr(mpr_local_map m, const char *expr)
     if (!_replace_expr_str(m, expr)) {
         mpr_time now;
         char *types = alloca(m->dst->sig->len * sizeof(char));
+        mpr_rtr_size_expr_stack(m->rtr);
         mpr_map_alloc_values(m);
         /* evaluate expression to intialise literals */
         mpr_time_set(&now, MPR_NOW);
@@ -1344,6 +1816,10 @@ int mpr_map_set_from_msg(mpr_map m, mpr_msg msg, int override)
                     }
                     updated += mpr_tbl_set(tbl, PROP(PROCESS_LOC), NULL, 1,
                                            MPR_INT32, &loc, REMOTE_MODIFY);
+                    _alloc_pending(lm);
+                    _alloc_held(lm);
+                    _alloc_sent(lm);
+                    _alloc_dirty(lm);
                 }
                 else
                     updated += mpr_tbl_set(tbl, PROP(PROCESS_LOC), NULL, 1,
@@ -1417,6 +1893,56 @@ int mpr_map_set_from_msg(mpr_map m, mpr_msg msg, int override)
                                        &pro, REMOTE_MODIFY);
                 break;
             }
+            case PROP(COALESCE): {
+                mpr_coalesce_type c;
+                if (!mpr_type_get_is_str(a->types[0]))
+                    break;
+                c = mpr_coalesce_from_str(&(a->vals[0])->s);
+                if (c == m->coalesce)
+                    break;
+                if (m->is_local && ((mpr_local_map)m)->rtr) {
+                    /* send any updates that are still waiting */
+                    _flush((mpr_local_map)m);
+                }
+                updated += mpr_tbl_set(tbl, PROP(COALESCE), NULL, 1, MPR_INT32, &c, REMOTE_MODIFY);
+                if (m->is_local && ((mpr_local_map)m)->rtr)
+                    _alloc_pending((mpr_local_map)m);
+                break;
+            }
+            case PROP(DEADBAND): {
+                float deadband;
+                if (!mpr_type_get_is_num(a->types[0]))
+                    break;
+                set_coerced_val(1, a->types[0], a->vals[0], 1, MPR_FLT, &deadband);
+                if (deadband < 0)
+                    deadband = -1;
+                if (!mpr_tbl_set(tbl, PROP(DEADBAND), NULL, 1, MPR_FLT, &deadband, REMOTE_MODIFY))
+                    break;
+                ++updated;
+                if (m->is_local && ((mpr_local_map)m)->rtr)
+                    _alloc_sent((mpr_local_map)m);
+                break;
+            }
+            case PROP(RATE): {
+                float rate;
+                if (!mpr_type_get_is_num(a->types[0]))
+                    break;
+                set_coerced_val(1, a->types[0], a->vals[0], 1, MPR_FLT, &rate);
+                if (rate < 0)
+                    rate = 0;
+                if (rate == m->rate)
+                    break;
+                if (m->is_local && ((mpr_local_map)m)->rtr) {
+                    /* send any updates that are still waiting */
+                    _flush((mpr_local_map)m);
+                }
+                updated += mpr_tbl_set(tbl, PROP(RATE), NULL, 1, MPR_FLT, &rate, REMOTE_MODIFY);
+                if (m->is_local && ((mpr_local_map)m)->rtr) {
+                    _alloc_pending((mpr_local_map)m);
+                    _alloc_held((mpr_local_map)m);
+                }
+                break;
+            }
             case PROP(USE_INST): {
                 int use_inst = a->types[0] == 'T';
                 if (m->is_local && m->use_inst && !use_inst) {
@@ -1498,6 +2024,8 @@ done:
         /* check if mapping is now "ready" */
         _check_status((mpr_local_map)m);
     }
+    if (updated)
+        mpr_graph_reindex_obj(m->obj.graph, (mpr_obj)m);
     return updated;
 }
 
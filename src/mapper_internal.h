@@ -31,6 +31,48 @@ if (!(a)) { trace_dev(dev, __VA_ARGS__); return ret; }
 #define MPR_INLINE __inline
 #endif
 
+/**** Atomic operations ****/
+
+#if defined(_MSC_VER) && !defined(__clang__)
+#include <intrin.h>
+MPR_INLINE static uint32_t mpr_atomic_load(uint32_t *p)
+{
+    return *(volatile uint32_t*)p;
+}
+
+MPR_INLINE static void mpr_atomic_store(uint32_t *p, uint32_t val)
+{
+    _InterlockedExchange((volatile long*)p, (long)val);
+}
+
+MPR_INLINE static int mpr_atomic_cas(uint32_t *p, uint32_t *expected, uint32_t desired)
+{
+    uint32_t prev = (uint32_t)_InterlockedCompareExchange((volatile long*)p, (long)desired,
+                                                          (long)*expected);
+    if (prev == *expected)
+        return 1;
+    *expected = prev;
+    return 0;
+}
+#else
+MPR_INLINE static uint32_t mpr_atomic_load(uint32_t *p)
+{
+    return __atomic_load_n(p, __ATOMIC_ACQUIRE);
+}
+
+MPR_INLINE static void mpr_atomic_store(uint32_t *p, uint32_t val)
+{
+    __atomic_store_n(p, val, __ATOMIC_RELEASE);
+}
+
+/*! Compare-and-swap, on failure the current value is written to expected. */
+MPR_INLINE static int mpr_atomic_cas(uint32_t *p, uint32_t *expected, uint32_t desired)
+{
+    return __atomic_compare_exchange_n(p, expected, desired, 0, __ATOMIC_ACQ_REL,
+                                       __ATOMIC_RELAXED);
+}
+#endif
+
 /**** Debug macros ****/
 
 /*! Debug tracer */
@@ -85,6 +127,11 @@ void mpr_net_remove_dev_methods(mpr_net n, mpr_local_dev d);
 
 void mpr_net_poll(mpr_net n);
 
+/*! Return the number of milliseconds until mpr_net_poll() next has housekeeping to do.
+ *  \param n            The network structure.
+ *  \param now          The current time in seconds, as returned by mpr_time_as_dbl(). */
+int mpr_net_get_timeout(mpr_net n, double now);
+
 void mpr_net_init(mpr_net n, const char *iface, const char *group, int port);
 
 void mpr_net_use_bus(mpr_net n);
@@ -113,7 +160,7 @@ if (!VARNAME) {                                     \
 int mpr_dev_set_from_msg(mpr_dev dev, mpr_msg msg);
 
 void mpr_dev_manage_subscriber(mpr_local_dev dev, lo_address address, int flags,
-                               int timeout_seconds, int revision);
+                               int timeout_seconds, int revision, int session);
 
 /*! Return the list of inter-device links associated with a given device.
  *  \param dev          Device record query.
@@ -129,6 +176,15 @@ mpr_list mpr_dev_get_maps(mpr_dev dev, mpr_dir dir);
  *  \return             Information about the signal, or zero if not found. */
 mpr_sig mpr_dev_get_sig_by_name(mpr_dev dev, const char *sig_name);
 
+/*! Add or remove a signal from the device's own list of signals, which is used to answer
+ *  queries such as mpr_dev_get_sigs() without walking every signal in the graph. */
+void mpr_dev_add_sig_ref(mpr_dev dev, mpr_sig sig);
+void mpr_dev_remove_sig_ref(mpr_dev dev, mpr_sig sig);
+
+/*! Add or remove a link from the device's own list of links. */
+void mpr_dev_add_link_ref(mpr_dev dev, mpr_link link);
+void mpr_dev_remove_link_ref(mpr_dev dev, mpr_link link);
+
 mpr_id mpr_dev_get_unused_sig_id(mpr_local_dev dev);
 
 int mpr_dev_add_link(mpr_dev dev, mpr_dev rem);
@@ -167,10 +223,46 @@ mpr_id_map mpr_dev_get_idmap_by_LID(mpr_local_dev dev, int group, mpr_id LID);
 
 mpr_id_map mpr_dev_get_idmap_by_GID(mpr_local_dev dev, int group, mpr_id GID);
 
+/*! Push a signal update to the device's queue, may be called from any thread.  Values too
+ *  large for a queue slot are rejected unless copy is non-zero, in which case they are copied
+ *  to the heap.  Returns zero on success, a positive value if the queue is full, or a negative
+ *  value on error. */
+int mpr_dev_queue_update(mpr_local_dev dev, mpr_local_sig sig, mpr_id inst, int len,
+                         mpr_type type, const void *val, mpr_time time, int copy);
+
+/*! Pass an update from another thread to the device's polling thread, waiting for room if
+ *  the queue is full.  Returns non-zero if the update was dropped. */
+int mpr_dev_hand_over_update(mpr_local_dev dev, mpr_local_sig sig, mpr_id inst, int len,
+                             mpr_type type, const void *val);
+
+/*! Discard any queued updates for a signal that is being freed. */
+void mpr_dev_unqueue_sig(mpr_local_dev dev, mpr_local_sig sig);
+
+/*! Return non-zero if called from the device's background polling thread. */
+int mpr_dev_get_is_poll_thread(mpr_local_dev dev);
+
+/*! Return the number of milliseconds until the device has updates or maps to process, at most
+ *  max_ms.  Network housekeeping is not included, see mpr_graph_get_housekeeping_timeout(). */
+int mpr_dev_get_timeout(mpr_local_dev dev, mpr_time now, int max_ms);
+
+/*! Return non-zero if a background thread is polling the device and the caller is another
+ *  thread, in which case signal updates must be handed over through the update queue. */
+#define mpr_dev_off_poll_thread(DEV) \
+    ((DEV)->thread_data && !mpr_dev_get_is_poll_thread(DEV))
+
 const char *mpr_dev_get_name(mpr_dev dev);
 
 void mpr_dev_send_state(mpr_dev dev, net_msg_t cmd);
 
+/*! Stamp a change to a local device, signal or map with a new version, so that subscribers
+ *  catching up from an earlier version are sent the object again. */
+void mpr_dev_record_change(mpr_obj obj);
+
+/*! Keep a tombstone for a local signal or map about to be removed, so that subscribers
+ *  catching up from an earlier version are told about the removal. Called when the object
+ *  is removed from the graph. */
+void mpr_dev_record_removal(mpr_obj obj);
+
 /*! Find information for a registered link.
  *  \param dev          Device record to query.
  *  \param remote       Remote device.
@@ -190,6 +282,13 @@ mpr_obj mpr_graph_get_obj(mpr_graph g, mpr_type type, mpr_id id);
  *  \return             Information about the device, or zero if not found. */
 mpr_dev mpr_graph_get_dev_by_name(mpr_graph g, const char *name);
 
+/*! Find information for a signal belonging to a specific device.
+ *  \param g            The graph to query.
+ *  \param dev          Device owning the signal.
+ *  \param name         Name of the signal to find.
+ *  \return             Information about the signal, or zero if not found. */
+mpr_sig mpr_graph_get_sig_by_name(mpr_graph g, mpr_dev dev, const char *name);
+
 mpr_map mpr_graph_get_map_by_names(mpr_graph g, int num_src, const char **srcs, const char *dst);
 
 /*! Call registered graph callbacks for a given object type.
@@ -201,6 +300,13 @@ void mpr_graph_call_cbs(mpr_graph g, mpr_obj o, mpr_type t, mpr_graph_evt e);
 
 void mpr_graph_cleanup(mpr_graph g);
 
+/*! Run network and graph housekeeping: send cached messages, handle device registration and
+ *  clock sync, renew subscriptions and expire devices that have stopped responding. */
+void mpr_graph_housekeeping(mpr_graph g);
+
+/*! Return the number of milliseconds until mpr_graph_housekeeping() next has work to do. */
+int mpr_graph_get_housekeeping_timeout(mpr_graph g, double now);
+
 /***** Router *****/
 
 void mpr_rtr_remove_sig(mpr_rtr r, mpr_rtr_sig rs);
@@ -209,9 +315,19 @@ void mpr_rtr_num_inst_changed(mpr_rtr r, mpr_local_sig sig, int size);
 
 void mpr_rtr_remove_inst(mpr_rtr rtr, mpr_local_sig sig, int idx);
 
+/*! Size the device evaluation stack for the largest expression of all local maps, so that
+ *  evaluation never needs to reallocate it. */
+void mpr_rtr_size_expr_stack(mpr_rtr rtr);
+
 /*! For a given signal instance, calculate mapping outputs and forward to
  *  destinations. */
-void mpr_rtr_process_sig(mpr_rtr rtr, mpr_local_sig sig, int inst_idx, const void *val, mpr_time t);
+void mpr_rtr_process_sig(mpr_rtr rtr, mpr_local_sig sig, int inst_idx, const void *val,
+                         const mpr_type *types, mpr_time t);
+
+/*! Forward the current values of several instances of an instanced signal, visiting each
+ *  outgoing map once for the whole batch. */
+void mpr_rtr_process_sig_insts(mpr_rtr rtr, mpr_local_sig sig, int num, const int *idmap_idxs,
+                               mpr_time t);
 
 void mpr_rtr_add_map(mpr_rtr rtr, mpr_local_map map);
 
@@ -288,6 +404,19 @@ int mpr_sig_get_idmap_with_GID(mpr_local_sig sig, mpr_id GID, int flags, mpr_tim
 /*! Release a specific signal instance. */
 void mpr_sig_release_inst_internal(mpr_local_sig sig, int inst_idx);
 
+/*! Mark a signal instance as inactive and return it to the free list. */
+void mpr_sig_deactivate_inst(mpr_local_sig sig, mpr_sig_inst si);
+
+/*! Update a signal instance with an explicit timestamp, releasing it if len is zero. */
+void mpr_sig_set_value_internal(mpr_local_sig sig, mpr_id id, int len, mpr_type type,
+                                const void *val, mpr_time time);
+
+/*! Clear a signal's reference to the device id map at the given index. */
+void mpr_sig_clear_idmap(mpr_local_sig sig, int idmap_idx);
+
+/*! Mark a signal instance as the most recently updated. */
+void mpr_sig_touch_inst(mpr_local_sig sig, mpr_sig_inst si);
+
 /**** Links ****/
 
 mpr_link mpr_link_new(mpr_local_dev local_dev, mpr_dev remote_dev);
@@ -302,6 +431,17 @@ void mpr_link_remove_map(mpr_link link, mpr_local_map rem);
 void mpr_link_init(mpr_link link);
 void mpr_link_connect(mpr_link link, const char *host, int admin_port,
                       int data_port);
+
+/* Devices advertise support for compact signal updates using this property. */
+#define MPR_COMPACT_DATA_KEY "compact_data"
+
+/* Devices advertise a random token for each run so subscribers can tell a restart apart. */
+#define MPR_SESSION_KEY "session"
+
+/*! Enable compact signal updates on a link if both devices support them.
+ *  \param link         The link to negotiate.
+ *  \param props        Properties announced by the remote device. */
+void mpr_link_negotiate_compact(mpr_link link, mpr_msg props);
 void mpr_link_free(mpr_link link);
 int mpr_link_process_bundles(mpr_link link, mpr_time t, int idx);
 void mpr_link_add_msg(mpr_link link, mpr_sig dst, lo_message msg, mpr_time t, mpr_proto proto, int idx);
@@ -320,8 +460,32 @@ void mpr_map_alloc_values(mpr_local_map map);
  *  \param time         Timestamp for this update. */
 void mpr_map_send(mpr_local_map map, mpr_time time);
 
+/*! Return the number of seconds until a rate-limited map may send again, or zero if it may
+ *  send now. */
+double mpr_map_get_send_delay(mpr_local_map map, mpr_time time);
+
 void mpr_map_receive(mpr_local_map map, mpr_time time);
 
+/*! Send coalesced updates waiting on a source slot.
+ *  \param map          The map to flush.
+ *  \param slot         The local source slot.
+ *  \param idmap_idx    Index of a single signal idmap to flush, or -1 for all. */
+void mpr_map_send_pending(mpr_local_map map, mpr_local_slot slot, int idmap_idx);
+
+/*! Record which input elements of an instance have changed, for maps that only send the
+ *  changed elements of their output.
+ *  \param map          The map.
+ *  \param inst_idx     Index of the updated instance.
+ *  \param types        Element types of the update, with MPR_NULL for unchanged elements,
+ *                      or 0 to mark the whole vector. */
+void mpr_map_set_dirty(mpr_local_map map, int inst_idx, const mpr_type *types);
+
+/*! Clear the values and pending output a map keeps for an instance index whose signal
+ *  instance has been removed, so that the index can be reused by another instance.
+ *  \param map          The map.
+ *  \param inst_idx     Index of the removed instance. */
+void mpr_map_clear_inst(mpr_local_map map, int inst_idx);
+
 lo_message mpr_map_build_msg(mpr_local_map map, mpr_local_slot slot, const void *val,
                              mpr_type *types, mpr_id_map idmap);
 
@@ -336,6 +500,9 @@ mpr_proto mpr_protocol_from_str(const char *string);
 
 const char *mpr_steal_as_str(mpr_steal_type stl);
 
+const char *mpr_coalesce_as_str(mpr_coalesce_type c);
+mpr_coalesce_type mpr_coalesce_from_str(const char *string);
+
 int mpr_map_send_state(mpr_map map, int slot, net_msg_t cmd);
 
 void mpr_map_init(mpr_map map);
@@ -348,6 +515,8 @@ mpr_slot mpr_slot_new(mpr_map map, mpr_sig sig, unsigned char is_local, unsigned
 
 void mpr_slot_alloc_values(mpr_local_slot slot, int num_inst, int hist_size);
 
+void mpr_slot_alloc_pending(mpr_local_slot slot, int num_inst);
+
 void mpr_slot_free(mpr_slot slot);
 
 void mpr_slot_free_value(mpr_local_slot slot);
@@ -358,7 +527,7 @@ void mpr_slot_add_props_to_msg(lo_message msg, mpr_slot slot, int is_dest, int s
 
 int mpr_slot_match_full_name(mpr_slot slot, const char *full_name);
 
-void mpr_slot_remove_inst(mpr_local_slot slot, int idx);
+void mpr_slot_clear_inst(mpr_local_slot slot, int idx);
 
 /**** Graph ****/
 
@@ -387,11 +556,19 @@ mpr_sig mpr_graph_add_sig(mpr_graph g, const char *sig_name,
 mpr_map mpr_graph_add_map(mpr_graph g, mpr_id id, int num_src, const char **src_names,
                           const char *dst_name);
 
+/*! Check whether the graph's retention settings keep a property of remote signals.
+ *  \param g            The graph to check.
+ *  \param prop         The symbolic identifier of the property.
+ *  \param key          The name of the property, used for extra properties.
+ *  \return             Non-zero if the property should be stored. */
+int mpr_graph_keeps_sig_prop(mpr_graph g, mpr_prop prop, const char *key);
+
 /*! Remove a device from the graph. */
 void mpr_graph_remove_dev(mpr_graph g, mpr_dev dev, mpr_graph_evt evt, int quiet);
 
-/*! Remove a signal from the graph. */
-void mpr_graph_remove_sig(mpr_graph g, mpr_sig sig, mpr_graph_evt evt);
+/*! Remove a signal from the graph.  If expire is non-zero the signal is only forgotten
+ *  locally and still counts towards its device's number of signals. */
+void mpr_graph_remove_sig(mpr_graph g, mpr_sig sig, mpr_graph_evt evt, int expire);
 
 /*! Remove a link from the graph. */
 void mpr_graph_remove_link(mpr_graph g, mpr_link link, mpr_graph_evt evt);
@@ -399,6 +576,33 @@ void mpr_graph_remove_link(mpr_graph g, mpr_link link, mpr_graph_evt evt);
 /*! Remove a map from the graph. */
 void mpr_graph_remove_map(mpr_graph g, mpr_map map, mpr_graph_evt evt);
 
+/*! Update the graph's hash indices after the id or name of an object has changed. This must be
+ *  called whenever either is assigned outside of the graph functions.
+ *  \param g            The graph containing the object.
+ *  \param obj          The object to reindex. */
+void mpr_graph_reindex_obj(mpr_graph g, mpr_obj obj);
+
+/*! Find a property index that can provide the candidates for a filter on graph objects.
+ *  \param g            The graph containing the objects.
+ *  \param obj_type     The type of the filtered objects.
+ *  \param prop         The filtered property, used if key is not set.
+ *  \param key          The filtered property key, or zero.
+ *  \param op           The comparison operator of the filter.
+ *  \param len          The length of the filter value.
+ *  \param type         The type of the filter value.
+ *  \param val          The filter value.
+ *  \return             The property index, or zero if none can be used. */
+mpr_prop_idx mpr_graph_get_prop_idx(mpr_graph g, int obj_type, mpr_prop prop, const char *key,
+                                    mpr_op op, int len, mpr_type type, const void *val);
+
+/*! Get the next candidate of a filter from a property index returned by
+ *  mpr_graph_get_prop_idx(). Candidates must still be tested against the filter.
+ *  \param idx          The property index.
+ *  \param obj          The previous candidate, or zero to get the first one.
+ *  \return             The next candidate, or zero if there are no more. */
+mpr_obj mpr_prop_idx_get_next(mpr_prop_idx idx, mpr_obj obj, mpr_op op, int len, mpr_type type,
+                              const void *val);
+
 /*! Print graph contents to the screen.  Useful for debugging, only works when
  *  compiled in debug mode. */
 void mpr_graph_print(mpr_graph g);
@@ -418,6 +622,16 @@ int mpr_parse_names(const char *string, char **devnameptr, char **signameptr);
  *  \return         A mpr_msg structure. Free when done using mpr_msg_free. */
 mpr_msg mpr_msg_parse_props(int argc, const mpr_type *types, lo_arg **argv);
 
+/*! Parse a message like mpr_msg_parse_props(), into a structure provided by the caller so that
+ *  message handlers can keep it on the stack.
+ *  \param msg      The structure to use.
+ *  \param argc     Number of arguments in the argv array.
+ *  \param types    String containing message parameter types.
+ *  \param argv     Vector of lo_arg structures.
+ *  \return         The msg argument, or zero if there were no properties.  Call mpr_msg_free
+ *                  when done to release atoms that did not fit in the structure. */
+mpr_msg mpr_msg_parse_props_into(mpr_msg_t *msg, int argc, const mpr_type *types, lo_arg **argv);
+
 void mpr_msg_free(mpr_msg msg);
 
 /*! Look up the value of a message parameter by symbolic identifier.
@@ -426,6 +640,12 @@ void mpr_msg_free(mpr_msg msg);
  *  \return         Pointer to mpr_msg_atom, or zero if not found. */
 mpr_msg_atom mpr_msg_get_prop(mpr_msg msg, mpr_prop prop);
 
+/*! Look up the value of an extra message parameter by name.
+ *  \param msg      Structure containing parameter info.
+ *  \param key      Name of the property to look for.
+ *  \return         Pointer to mpr_msg_atom, or zero if not found. */
+mpr_msg_atom mpr_msg_get_prop_by_key(mpr_msg msg, const char *key);
+
 void mpr_msg_add_typed_val(lo_message msg, int len, mpr_type type, const void *val);
 
 /*! Prepare a lo_message for sending based on a map struct. */
@@ -457,6 +677,10 @@ const char *mpr_expr_get_var_name(mpr_expr expr, int idx);
 
 int mpr_expr_get_manages_inst(mpr_expr expr);
 
+/*! Returns 1 if each element of the expression output depends only on the same element of a
+ *  single input, with no history, variables or reductions. */
+int mpr_expr_get_is_elementwise(mpr_expr expr);
+
 #ifdef DEBUG
 void printexpr(const char*, mpr_expr);
 #endif
@@ -485,13 +709,33 @@ int mpr_expr_get_num_input_slots(mpr_expr expr);
 
 void mpr_expr_free(mpr_expr expr);
 
+/*! Get the evaluation stack size needed by an expression.
+ *  \param expr         The expression.
+ *  \param depth        Location for the number of stack entries.
+ *  \param num_samps    Location for the number of stack values. */
+void mpr_expr_get_stack_size(mpr_expr expr, int *depth, int *num_samps);
+
 mpr_expr_stack mpr_expr_stack_new();
 void mpr_expr_stack_free(mpr_expr_stack stk);
 
+/*! Reallocate an evaluation stack to an exact size.  Values and entry lengths are held in a
+ *  single allocation aligned to a cache line. */
+void mpr_expr_stack_set_size(mpr_expr_stack stk, int depth, int num_samps);
+
+/*! Guard mode is used to verify that polling a device with established maps never reallocates
+ *  its evaluation stack.  Expressions that do not fit on the stack are not evaluated instead of
+ *  reallocating the stack during evaluation, and any other reallocation is reported. */
+void mpr_expr_stack_set_guard(mpr_expr_stack stk, int guard);
+
+/*! Return the number of times the stack has been reallocated, including reallocations refused
+ *  in guard mode. */
+int mpr_expr_stack_get_num_realloc(mpr_expr_stack stk);
+
 /**** String tables ****/
 
-/*! Create a new string table. */
-mpr_tbl mpr_tbl_new(void);
+/*! Create a new string table.
+ * \param keys     Pool used to intern the keys of extra properties. */
+mpr_tbl mpr_tbl_new(mpr_key_pool keys);
 
 /*! Clear the contents of a string table.
  * \param tab Table to free. */
@@ -557,21 +801,38 @@ void mpr_tbl_add_to_msg(mpr_tbl tab, mpr_tbl updates, lo_message msg);
  *  removal to propagate to subscribed graph instances and peer devices. */
 void mpr_tbl_clear_empty(mpr_tbl tab);
 
+/*! Free a pool of interned keys along with any keys still held. */
+void mpr_key_pool_free(mpr_key_pool keys);
+
 int match_pattern(const char* s, const char* p);
 
 /**** Lists ****/
 
 void *mpr_list_from_data(const void *data);
 
-void *mpr_list_add_item(void **list, size_t size);
+/*! Allocate a zeroed item and prepend it to a list.
+ * \param list     The list to add the item to.
+ * \param size     The size of the item.
+ * \param pools    Pools to allocate the item from, or zero to allocate it on its own.
+ * \return         The new item. */
+void *mpr_list_add_item(void **list, size_t size, mpr_pool *pools);
 
 void mpr_list_remove_item(void **list, void *item);
 
 void mpr_list_free_item(void *item);
 
+/*! Release the chunks of a set of pools, including any items still allocated from them. */
+void mpr_list_free_pools(mpr_pool pools);
+
 mpr_list mpr_list_new_query(const void **list, const void *func,
                             const mpr_type *types, ...);
 
+/*! Create a query like mpr_list_new_query(), but take candidate items from the function next
+ *  instead of testing every item of list. next(ctx, 0) returns the first candidate and
+ *  next(ctx, item) the one following item; func is still applied to each candidate. */
+mpr_list mpr_list_new_query_from(const void **list, const void *next, const void *func,
+                                 const mpr_type *types, ...);
+
 mpr_list mpr_list_start(mpr_list list);
 
 /**** Time ****/
@@ -585,6 +846,15 @@ double mpr_get_current_time(void);
  *  \return             The difference a-b in seconds. */
 double mpr_time_get_diff(mpr_time minuend, mpr_time subtrahend);
 
+/*! Return the number of milliseconds from now until a deadline, rounded up, or zero if the
+ *  deadline has passed.
+ *  \param deadline     The deadline in seconds, as returned by mpr_time_as_dbl().
+ *  \param now          The current time in seconds. */
+MPR_INLINE static int mpr_ms_until(double deadline, double now)
+{
+    return deadline > now ? (int)((deadline - now) * 1000) + 1 : 0;
+}
+
 /**** Properties ****/
 
 /*! Helper for printing typed values.
@@ -628,8 +898,6 @@ void mpr_value_realloc(mpr_value val, int vec_len, mpr_type type,
 
 void mpr_value_reset_inst(mpr_value v, int idx);
 
-int mpr_value_remove_inst(mpr_value v, int idx);
-
 void mpr_value_set_samp(mpr_value v, int idx, void *s, mpr_time t);
 
 /*! Helper to find the pointer to the current value in a mpr_value_t. */
@@ -683,12 +951,25 @@ MPR_INLINE static int check_sig_length(int length)
     return (length < 1 || length > MPR_MAX_VECTOR_LEN);
 }
 
+/*! Helper to hash a 64-bit id into a table whose size is a power of two. */
+MPR_INLINE static int mpr_hash_id(mpr_id id, int size)
+{
+    return (int)((id * 0x9E3779B97F4A7C15ULL) >> 32) & (size - 1);
+}
+
 /*! Helper to check if bitfields match completely. */
 MPR_INLINE static int bitmatch(unsigned int a, unsigned int b)
 {
     return (a & b) == b;
 }
 
+/*! Helper to check the byte order of this host. */
+MPR_INLINE static int mpr_get_is_big_endian(void)
+{
+    const uint16_t one = 1;
+    return 0 == *(const uint8_t*)&one;
+}
+
 /*! Helper to check if type is a number. */
 MPR_INLINE static int mpr_type_get_is_num(mpr_type type)
 {
@@ -741,6 +1022,11 @@ MPR_INLINE static int get_bitflag(char *bytearray, int idx)
     return bytearray[idx / 8] & 1 << (idx % 8);
 }
 
+MPR_INLINE static void unset_bitflag(char *bytearray, int idx)
+{
+    bytearray[idx / 8] &= ~(1 << (idx % 8));
+}
+
 MPR_INLINE static int compare_bitflags(char *l, char *r, int num_flags)
 {
     return memcmp(l, r, num_flags / 8 + 1);
@@ -751,4 +1037,23 @@ MPR_INLINE static void clear_bitflags(char *bytearray, int num_flags)
     memset(bytearray, 0, num_flags / 8 + 1);
 }
 
+/*! Return the instance of a local signal stored at a given index. */
+MPR_INLINE static mpr_sig_inst mpr_sig_get_inst_by_idx(mpr_local_sig sig, int idx)
+{
+    int chunk, n = idx + 1;
+#ifdef __GNUC__
+    chunk = 31 - __builtin_clz(n);
+#else
+    for (chunk = 0; n >> (chunk + 1); chunk++) ;
+#endif
+    return &sig->inst_chunks[chunk][n - (1 << chunk)];
+}
+
+/*! Return the number of instance indices of a signal, which may include indices left vacant
+ *  by removed instances of a local signal. */
+MPR_INLINE static int mpr_sig_get_num_inst_idx(mpr_sig sig)
+{
+    return sig->is_local ? ((mpr_local_sig)sig)->num_inst_idx : sig->num_inst;
+}
+
 #endif /* __MAPPER_INTERNAL_H__ */
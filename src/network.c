@@ -549,6 +549,7 @@ static void mpr_net_probe_dev_name(mpr_net net, mpr_local_dev dev)
 
     /* Calculate an id from the name and store it in id.val */
     dev->obj.id = (mpr_id) crc32(0L, (const Bytef *)name, strlen(name)) << 32;
+    mpr_graph_reindex_obj(net->graph, (mpr_obj)dev);
 
     /* For the same reason, we can't use mpr_net_send() here. */
     lo_send(net->addr.bus, net_msg_strings[MSG_NAME_PROBE], "si", name, net->random_id);
@@ -738,6 +739,27 @@ void mpr_net_poll(mpr_net net)
     return;
 }
 
+int mpr_net_get_timeout(mpr_net net, double now)
+{
+    int i;
+    double next;
+
+    /* cached messages are sent at the start of the next poll */
+    RETURN_ARG_UNLESS(!net->bundle, 0);
+
+    /* name collisions are resolved at the granularity of a regular polling interval */
+    for (i = 0; i < net->num_devs; i++) {
+        if (!net->devs[i]->registered)
+            return 100;
+    }
+
+    /* see mpr_net_maybe_send_ping() */
+    next = net->next_sub_ping + 1;
+    if (net->num_devs && net->next_bus_ping < next)
+        next = net->next_bus_ping;
+    return mpr_ms_until(next, now);
+}
+
 /*! Algorithm for checking collisions and allocating resources. */
 static int check_collisions(mpr_net net, mpr_allocated resource)
 {
@@ -804,6 +826,7 @@ static int handler_dev(const char *path, const char *types, lo_arg **av, int ac,
     mpr_dev remote;
     mpr_graph graph;
     int i, j, data_port, found;
+    mpr_msg_t props_buf;
     mpr_msg props = 0;
     mpr_msg_atom atom;
     mpr_list links = 0, cpy;
@@ -818,7 +841,7 @@ static int handler_dev(const char *path, const char *types, lo_arg **av, int ac,
     name = &av[0]->s;
 
     if (graph->autosub || mpr_graph_subscribed_by_dev(graph, name)) {
-        props = mpr_msg_parse_props(ac-1, &types[1], &av[1]);
+        props = mpr_msg_parse_props_into(&props_buf, ac-1, &types[1], &av[1]);
 #ifdef DEBUG
         trace_net("received /device ");
         lo_message_pp(msg);
@@ -874,7 +897,7 @@ static int handler_dev(const char *path, const char *types, lo_arg **av, int ac,
     }
     /* Retrieve the port */
     if (!props)
-        props = mpr_msg_parse_props(ac-1, &types[1], &av[1]);
+        props = mpr_msg_parse_props_into(&props_buf, ac-1, &types[1], &av[1]);
     atom = mpr_msg_get_prop(props, MPR_PROP_PORT);
     if (!atom || atom->len != 1 || atom->types[0] != MPR_INT32) {
         trace_net("can't perform /linkTo, port unknown\n");
@@ -890,6 +913,7 @@ static int handler_dev(const char *path, const char *types, lo_arg **av, int ac,
         if (mpr_link_get_is_local(link)) {
             trace_dev(dev, "establishing link to %s.\n", name)
             mpr_link_connect(link, host, atoi(admin_port), data_port);
+            mpr_link_negotiate_compact(link, props);
             found = 1;
             break;
         }
@@ -960,11 +984,12 @@ static int handler_dev_mod(const char *path, const char *types, lo_arg **av,
 {
     mpr_net net = (mpr_net)user;
     mpr_local_dev dev = net->devs ? net->devs[0] : 0;
+    mpr_msg_t props_buf;
     mpr_msg props;
 
     RETURN_ARG_UNLESS(dev && mpr_dev_get_is_ready((mpr_dev)dev)
                       && ac >= 2 && MPR_STR == types[0], 0);
-    props = mpr_msg_parse_props(ac, types, av);
+    props = mpr_msg_parse_props_into(&props_buf, ac, types, av);
     trace_dev(dev, "received /%s/modify + %d properties.\n", path, props->num_atoms);
     if (mpr_dev_set_from_msg((mpr_dev)dev, props)) {
         inform_device_subscribers(net, dev);
@@ -1034,7 +1059,7 @@ static int handler_subscribe(const char *path, const char *types, lo_arg **av,
 {
     mpr_net net = (mpr_net)user;
     mpr_local_dev dev = net->devs ? net->devs[0] : 0;
-    int i, version = -1, flags = 0, timeout_seconds = 0;
+    int i, version = -1, session = 0, has_session = 0, flags = 0, timeout_seconds = 0;
 
 #ifdef DEBUG
     trace_dev(dev, "received /subscribe ");
@@ -1069,6 +1094,14 @@ static int handler_subscribe(const char *path, const char *types, lo_arg **av,
             if (i < ac && MPR_INT32 == types[i])
                 version = av[i]->i;
         }
+        else if (0 == strcmp(&av[i]->s, "@session")) {
+            /* next argument is the device session the version was recorded from */
+            ++i;
+            if (i < ac && MPR_INT32 == types[i]) {
+                session = av[i]->i;
+                has_session = 1;
+            }
+        }
         else if (0 == strcmp(&av[i]->s, "@lease")) {
             /* next argument is lease timeout in seconds */
             ++i;
@@ -1083,8 +1116,12 @@ static int handler_subscribe(const char *path, const char *types, lo_arg **av,
         }
     }
 
+    /* a version without a session token can't be trusted to come from this run */
+    if (!has_session)
+        version = -1;
+
     /* add or renew subscription */
-    mpr_dev_manage_subscriber(dev, addr, flags, timeout_seconds, version);
+    mpr_dev_manage_subscriber(dev, addr, flags, timeout_seconds, version, session);
     return 0;
 }
 
@@ -1093,8 +1130,10 @@ static int handler_sig(const char *path, const char *types, lo_arg **av, int ac,
                        lo_message msg, void *user)
 {
     mpr_net net;
+    mpr_dev dev;
     char *full_sig_name, *signamep, *devnamep, devname[1024];
     int devnamelen;
+    mpr_msg_t props_buf;
     mpr_msg props;
 
     RETURN_ARG_UNLESS(ac >= 2 && MPR_STR == types[0], 1);
@@ -1115,7 +1154,18 @@ static int handler_sig(const char *path, const char *types, lo_arg **av, int ac,
     }
 #endif
 
-    props = mpr_msg_parse_props(ac-1, &types[1], &av[1]);
+    /* Local devices may need any signal for maps, otherwise only parse the properties of
+     * signals we are subscribed to or already have a record of. */
+    if (   !net->devs && !(net->graph->autosub & MPR_SIG)
+        && !(mpr_graph_subscribed_by_dev(net->graph, devname) & MPR_SIG)) {
+        dev = mpr_graph_get_dev_by_name(net->graph, devname);
+        if (!dev || !mpr_dev_get_sig_by_name(dev, signamep)) {
+            trace_net("ignoring /signal %s:%s, not subscribed.\n", devname, signamep);
+            return 0;
+        }
+    }
+
+    props = mpr_msg_parse_props_into(&props_buf, ac-1, &types[1], &av[1]);
     mpr_graph_add_sig(net->graph, signamep, devname, props);
     mpr_msg_free(props);
     return 0;
@@ -1157,6 +1207,7 @@ static int handler_sig_mod(const char *path, const char *types, lo_arg **av,
     mpr_net net = (mpr_net)user;
     mpr_local_dev dev = net->devs ? net->devs[0] : 0;
     mpr_sig sig;
+    mpr_msg_t props_buf;
     mpr_msg props;
     RETURN_ARG_UNLESS(dev && mpr_dev_get_is_ready((mpr_dev)dev) && ac > 1 && MPR_STR == types[0], 0);
 
@@ -1164,10 +1215,11 @@ static int handler_sig_mod(const char *path, const char *types, lo_arg **av,
     sig = mpr_dev_get_sig_by_name((mpr_dev)dev, &av[0]->s);
     TRACE_DEV_RETURN_UNLESS(sig, 0, "no signal found with name '%s'.\n", &av[0]->s);
 
-    props = mpr_msg_parse_props(ac-1, &types[1], &av[1]);
+    props = mpr_msg_parse_props_into(&props_buf, ac-1, &types[1], &av[1]);
     trace_dev(dev, "received %s '%s' + %d properties.\n", path, sig->name, props->num_atoms);
 
     if (mpr_sig_set_from_msg(sig, props)) {
+        mpr_dev_record_change((mpr_obj)sig);
         if (dev->subscribers) {
             int dir = (MPR_DIR_IN == sig->dir) ? MPR_SIG_IN : MPR_SIG_OUT;
             trace_dev(dev, "informing subscribers (SIGNAL)\n");
@@ -1201,7 +1253,8 @@ static int handler_sig_removed(const char *path, const char *types, lo_arg **av,
 
     dev = mpr_graph_get_dev_by_name(net->graph, devname);
     if (dev && !dev->is_local)
-        mpr_graph_remove_sig(net->graph, mpr_dev_get_sig_by_name(dev, signamep), MPR_OBJ_REM);
+        mpr_graph_remove_sig(net->graph, mpr_dev_get_sig_by_name(dev, signamep), MPR_OBJ_REM,
+                             0);
     return 0;
 }
 
@@ -1498,6 +1551,7 @@ static int handler_map(const char *path, const char *types, lo_arg **av, int ac,
     mpr_local_dev dev = net->devs ? net->devs[0] : 0;
     mpr_sig sig = 0;
     mpr_local_map map;
+    mpr_msg_t props_buf;
     mpr_msg props;
     int i;
 
@@ -1516,13 +1570,14 @@ static int handler_map(const char *path, const char *types, lo_arg **av, int ac,
     }
     mpr_rtr_add_map(net->rtr, map);
 
-    props = mpr_msg_parse_props(ac, types, av);
+    props = mpr_msg_parse_props_into(&props_buf, ac, types, av);
     mpr_map_set_from_msg((mpr_map)map, props, 1);
     mpr_msg_free(props);
 
     if (map->is_local_only && map->expr) {
         trace_dev(dev, "map references only local signals... activating.\n");
         map->status = MPR_STATUS_ACTIVE;
+        mpr_dev_record_change((mpr_obj)map);
 
         /* Inform subscribers */
         if (dev->subscribers) {
@@ -1582,7 +1637,8 @@ static int handler_map_to(const char *path, const char *types, lo_arg **av,
 
     if (map->status < MPR_STATUS_ACTIVE) {
         /* Set map properties. */
-        mpr_msg props = mpr_msg_parse_props(ac, types, av);
+        mpr_msg_t props_buf;
+        mpr_msg props = mpr_msg_parse_props_into(&props_buf, ac, types, av);
         mpr_map_set_from_msg((mpr_map)map, props, 1);
         mpr_msg_free(props);
     }
@@ -1619,8 +1675,9 @@ static int handler_mapped(const char *path, const char *types, lo_arg **av,
     mpr_graph graph = net->graph;
     mpr_local_dev dev = net->devs ? net->devs[0] : 0;
     mpr_map map;
+    mpr_msg_t props_buf;
     mpr_msg props;
-    int i, rc = 0, updated;
+    int i, rc = 0, updated, store = 0;
 
 #ifdef DEBUG
     if (dev)
@@ -1630,32 +1687,36 @@ static int handler_mapped(const char *path, const char *types, lo_arg **av,
     lo_message_pp(msg);
 #endif
 
+    if (graph->autosub & MPR_MAP)
+        store = 1;
+    else {
+        i = 0;
+        while (MPR_STR == types[i] && '@' != (&av[i]->s)[0]) {
+            if ('-' != (&av[i]->s)[0] && mpr_graph_subscribed_by_sig(graph, &av[i]->s)) {
+                store = 1;
+                break;
+            }
+            ++i;
+        }
+    }
+    /* maps we already have a record of are always updated, others are only added if we are
+     * subscribed to one of their devices */
     map = find_map(net, types, ac, av, 0, 0, UPDATE);
     RETURN_ARG_UNLESS(MPR_MAP_ERROR != map, 0);
     if (!map) {
-        int store = 0, i = 0;
-        if (graph->autosub & MPR_MAP)
-            store = 1;
-        else {
-            while (MPR_STR == types[i] && '@' != (&av[i]->s)[0]) {
-                if ('-' != (&av[i]->s)[0] && mpr_graph_subscribed_by_sig(graph, &av[i]->s)) {
-                    store = 1;
-                    break;
-                }
-                ++i;
-            }
-        }
-        if (store) {
-            map = find_map(net, types, ac, av, 0, 0, ADD);
-            rc = 1;
+        if (!store) {
+            trace_graph("ignoring /mapped, not subscribed.\n");
+            return 0;
         }
+        map = find_map(net, types, ac, av, 0, 0, ADD);
+        rc = 1;
         RETURN_ARG_UNLESS(map && MPR_MAP_ERROR != map, 0);
     }
     else if (map->is_local && ((mpr_local_map)map)->is_local_only) {
         /* no need to update since all properties are local */
         return 0;
     }
-    props = mpr_msg_parse_props(ac, types, av);
+    props = mpr_msg_parse_props_into(&props_buf, ac, types, av);
 
     /* TODO: if this endpoint is map admin, do not allow overwriting props */
     updated = mpr_map_set_from_msg(map, props, 0);
@@ -1703,6 +1764,8 @@ static int handler_mapped(const char *path, const char *types, lo_arg **av,
         }
     }
     if (rc || updated) {
+        if (dev)
+            mpr_dev_record_change((mpr_obj)map);
         if (mpr_obj_get_prop_as_int32(&map->obj, MPR_PROP_IS_LOCAL, 0)
             && dev && dev->subscribers) {
             int dir = (MPR_DIR_OUT == map->dst->dir) ? MPR_MAP_OUT : MPR_MAP_IN;
@@ -1723,6 +1786,7 @@ static int handler_map_mod(const char *path, const char *types, lo_arg **av,
     mpr_net net;
     mpr_local_dev dev;
     mpr_local_map map;
+    mpr_msg_t props_buf;
     mpr_msg props;
     mpr_msg_atom a;
     mpr_loc loc = MPR_LOC_UNDEFINED;
@@ -1740,7 +1804,7 @@ static int handler_map_mod(const char *path, const char *types, lo_arg **av,
     RETURN_ARG_UNLESS(map && MPR_MAP_ERROR != (mpr_map)map, 0);
     RETURN_ARG_UNLESS(map->status >= MPR_STATUS_ACTIVE, 0);
 
-    props = mpr_msg_parse_props(ac, types, av);
+    props = mpr_msg_parse_props_into(&props_buf, ac, types, av);
     TRACE_DEV_RETURN_UNLESS(props, 0, "ignoring /map/modify, no properties.\n");
     a = mpr_msg_get_prop(props, MPR_PROP_PROCESS_LOC);
     if (a) {
@@ -1772,6 +1836,7 @@ static int handler_map_mod(const char *path, const char *types, lo_arg **av,
 
     updated = mpr_map_set_from_msg((mpr_map)map, props, 1);
     if (updated) {
+        mpr_dev_record_change((mpr_obj)map);
         if (!map->is_local_only) {
             /* Inform remote peer(s) of relevant changes */
             if (!map->dst->rsig) {
@@ -142,8 +142,16 @@ mpr_prop mpr_obj_set_prop(mpr_obj o, mpr_prop p, const char *s, int len,
     if (!publish)
         flags |= LOCAL_ACCESS_ONLY;
     updated = mpr_tbl_set(local ? o->props.synced : o->props.staged, p, s, len, type, val, flags);
-    if (updated)
-        mpr_obj_increment_version(o);
+    if (updated) {
+        if (local)
+            mpr_dev_record_change(o);
+        else
+            mpr_obj_increment_version(o);
+        if (o->graph) {
+            ++o->graph->version;
+            mpr_graph_reindex_obj(o->graph, o);
+        }
+    }
     return updated;
 }
 
@@ -160,8 +168,16 @@ int mpr_obj_remove_prop(mpr_obj o, mpr_prop p, const char *s)
         updated = mpr_tbl_remove(o->props.synced, p, s, LOCAL_MODIFY);
     else if (MPR_PROP_EXTRA == p)
         updated = mpr_tbl_set(o->props.staged, p | PROP_REMOVE, s, 0, 0, 0, REMOTE_MODIFY);
-    if (updated)
-        mpr_obj_increment_version(o);
+    if (updated) {
+        if (local)
+            mpr_dev_record_change(o);
+        else
+            mpr_obj_increment_version(o);
+        if (o->graph) {
+            ++o->graph->version;
+            mpr_graph_reindex_obj(o->graph, o);
+        }
+    }
     return 0;
 }
 
@@ -284,6 +300,9 @@ void mpr_obj_print(mpr_obj o, int staged)
                 case MPR_PROP_PROTOCOL:
                     printf("%s", mpr_protocol_as_str(*(int*)val));
                     break;
+                case MPR_PROP_COALESCE:
+                    printf("%s", mpr_coalesce_as_str(*(int*)val));
+                    break;
                 default:
                     mpr_prop_print(len, type, val);
             }
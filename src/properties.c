@@ -26,7 +26,9 @@ typedef struct {
 const static_prop_t static_props[] = {
     { 0,                0, 0,         0 },         /* MPR_PROP_UNKNOWN */
     { "@calib",         1, MPR_BOOL,  MPR_BOOL },  /* MPR_PROP_CALIB */
+    { "@coalesce",      1, MPR_INT32, MPR_STR },   /* MPR_PROP_COALESCE */
     { "@data",          1, MPR_PTR,   0  },        /* MPR_PROP_DATA */
+    { "@deadband",      1, MPR_FLT,   MPR_FLT },   /* MPR_PROP_DEADBAND */
     { "@device",        1, MPR_DEV,   MPR_STR },   /* MPR_PROP_DEVICE */
     { "@direction",     1, MPR_INT32, MPR_STR },   /* MPR_PROP_DIR */
     { "@expr",          1, MPR_STR,   MPR_STR },   /* MPR_PROP_EXPR */
@@ -48,6 +50,7 @@ const static_prop_t static_props[] = {
     { "@num_maps_out",  1, MPR_INT32, MPR_INT32 }, /* MPR_PROP_NUM_MAPS_OUT */
     { "@num_sigs_in",   1, MPR_INT32, MPR_INT32 }, /* MPR_PROP_NUM_SIGS_IN */
     { "@num_sigs_out",  1, MPR_INT32, MPR_INT32 }, /* MPR_PROP_NUM_SIGS_OUT */
+    { "@num_suppressed",1, MPR_INT32, MPR_INT32 }, /* MPR_PROP_NUM_SUPPRESSED */
     { "@ordinal",       1, MPR_INT32, MPR_INT32 }, /* MPR_PROP_ORDINAL */
     { "@period",        1, MPR_FLT,   MPR_FLT },   /* MPR_PROP_PERIOD */
     { "@port",          1, MPR_INT32, MPR_INT32 }, /* MPR_PROP_PORT */
@@ -68,6 +71,42 @@ const static_prop_t static_props[] = {
                                            * represent a specific property name) */
 };
 
+/* Other names accepted by mpr_prop_from_str() */
+static const struct {
+    const char *key;
+    mpr_prop prop;
+} prop_aliases[] = {
+    { "expression", MPR_PROP_EXPR },
+    { "maximum",    MPR_PROP_MAX },
+    { "minimum",    MPR_PROP_MIN },
+};
+
+/* Perfect hash of the keys of static_props (without the '@') and prop_aliases. The slot of each
+ * key holds its index in static_props, or 0x80 plus its index in prop_aliases. If properties are
+ * added, search for a PROP_HASH_SEED that gives every key its own slot and rebuild the table;
+ * testparams checks that every key is found. */
+#define PROP_HASH_SEED 9634
+#define PROP_HASH_SIZE 128
+static const uint8_t prop_hash_idx[PROP_HASH_SIZE] = {
+    0x00, 0x22, 0x2A, 0x00, 0x00, 0x00, 0x00, 0x00, 0x24, 0x00, 0x1B, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x15, 0x00, 0x00, 0x00, 0x0C, 0x00, 0x19, 0x23, 0x18, 0x00, 0x26, 0x00, 0x00, 0x03, 0x1A, 0x00,
+    0x00, 0x00, 0x05, 0x01, 0x00, 0x00, 0x07, 0x00, 0x1C, 0x0B, 0x00, 0x00, 0x00, 0x02, 0x00, 0x0E,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x17, 0x00, 0x00, 0x00, 0x00, 0x00, 0x06, 0x00, 0x81,
+    0x00, 0x00, 0x00, 0x28, 0x16, 0x82, 0x00, 0x00, 0x29, 0x00, 0x12, 0x00, 0x25, 0x00, 0x00, 0x08,
+    0x00, 0x00, 0x00, 0x0F, 0x00, 0x0D, 0x1D, 0x00, 0x00, 0x00, 0x00, 0x09, 0x00, 0x00, 0x00, 0x04,
+    0x00, 0x00, 0x80, 0x00, 0x00, 0x10, 0x00, 0x13, 0x00, 0x14, 0x00, 0x21, 0x00, 0x0A, 0x27, 0x00,
+    0x1E, 0x00, 0x00, 0x11, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x1F, 0x20, 0x00, 0x00, 0x00,
+};
+
+MPR_INLINE static unsigned int hash_prop_key(const char *str)
+{
+    /* FNV-1a, starting from the seed instead of the usual offset basis */
+    uint32_t h = PROP_HASH_SEED;
+    while (*str)
+        h = (h ^ (uint8_t)*str++) * 16777619;
+    return (h >> 8) & (PROP_HASH_SIZE - 1);
+}
+
 const char* mpr_loc_strings[] =
 {
     NULL,           /* MPR_LOC_UNDEFINED */
@@ -88,6 +127,15 @@ const char *mpr_steal_strings[] =
     "none",         /* MPR_STEAL_NONE */
     "oldest",       /* MPR_STEAL_OLDEST */
     "newest",       /* MPR_STEAL_NEWEST */
+    "least_recent", /* MPR_STEAL_LEAST_RECENT */
+};
+
+const char *mpr_coalesce_strings[] =
+{
+    "none",         /* MPR_COALESCE_NONE */
+    "latest",       /* MPR_COALESCE_LATEST */
+    "mean",         /* MPR_COALESCE_MEAN */
+    "max",          /* MPR_COALESCE_MAX */
 };
 
 int mpr_parse_names(const char *string, char **devnameptr, char **signameptr)
@@ -114,24 +162,35 @@ int mpr_parse_names(const char *string, char **devnameptr, char **signameptr)
     return (signame - devname - 1);
 }
 
-mpr_msg mpr_msg_parse_props(int argc, const mpr_type *types, lo_arg **argv)
+static int count_props(int argc, const mpr_type *types, lo_arg **argv)
 {
-    int i, slot_idx, num_props=0;
-    mpr_msg msg;
-    mpr_msg_atom a;
+    int i, num_props = 0;
     const char *key;
-
-    /* get the number of props */
     for (i = 0; i < argc; i++) {
         if (types[i] != MPR_STR)
             continue;
-        if (argv[i]->s == '@' || !strncmp(&argv[i]->s, "-@", 2) || !strncmp(&argv[i]->s, "+@", 2))
+        key = &argv[i]->s;
+        if ('@' == key[0] || (('-' == key[0] || '+' == key[0]) && '@' == key[1]))
             ++num_props;
     }
-    RETURN_ARG_UNLESS(num_props, 0);
+    return num_props;
+}
+
+static mpr_msg parse_props(mpr_msg msg, int num_props, int argc, const mpr_type *types,
+                           lo_arg **argv)
+{
+    int i, slot_idx;
+    mpr_msg_atom a;
+    const char *key;
 
-    msg = (mpr_msg) calloc(1, sizeof(struct _mpr_msg));
-    msg->atoms = ((mpr_msg_atom_t*) calloc(1, sizeof(struct _mpr_msg_atom) * num_props));
+    /* the atoms point to the message arguments, so only their array may need allocating */
+    msg->num_atoms = 0;
+    if (num_props <= NUM_EXTRA_PROPS) {
+        msg->atoms = msg->buf;
+        memset(msg->atoms, 0, sizeof(mpr_msg_atom_t) * num_props);
+    }
+    else
+        msg->atoms = (mpr_msg_atom_t*) calloc(1, sizeof(mpr_msg_atom_t) * num_props);
     a = &msg->atoms[0];
 
     for (i = 0; i < argc; i++) {
@@ -153,11 +212,11 @@ mpr_msg mpr_msg_parse_props(int argc, const mpr_type *types, lo_arg **argv)
         a = &msg->atoms[msg->num_atoms];
 
         key = &argv[i]->s;
-        if (strncmp(key, "+@", 2)==0) {
+        if ('+' == key[0] && '@' == key[1]) {
             a->prop = PROP_ADD;
             ++key;
         }
-        else if (strncmp(key, "-@", 2)==0) {
+        else if ('-' == key[0] && '@' == key[1]) {
             a->prop = PROP_REMOVE;
             ++key;
         }
@@ -166,11 +225,11 @@ mpr_msg mpr_msg_parse_props(int argc, const mpr_type *types, lo_arg **argv)
         a->key = key;
 
         /* try to find matching index for static props */
-        if (strncmp(a->key, "@dst@", 5)==0) {
+        if ('d' == key[1] && strncmp(a->key, "@dst@", 5)==0) {
             a->prop |= DST_SLOT_PROP;
             a->key += 5;
         }
-        else if (strncmp(a->key, "@src", 4)==0) {
+        else if ('s' == key[1] && strncmp(a->key, "@src", 4)==0) {
             if (a->key[4] == '@') {
                 a->prop |= SRC_SLOT_PROP(0);
                 a->key += 5;
@@ -308,11 +367,32 @@ mpr_msg mpr_msg_parse_props(int argc, const mpr_type *types, lo_arg **argv)
     return msg;
 }
 
+mpr_msg mpr_msg_parse_props(int argc, const mpr_type *types, lo_arg **argv)
+{
+    mpr_msg msg;
+    int num_props = count_props(argc, types, argv);
+    RETURN_ARG_UNLESS(num_props, 0);
+    msg = (mpr_msg) malloc(sizeof(mpr_msg_t));
+    RETURN_ARG_UNLESS(msg, 0);
+    msg->allocated = 1;
+    return parse_props(msg, num_props, argc, types, argv);
+}
+
+mpr_msg mpr_msg_parse_props_into(mpr_msg_t *msg, int argc, const mpr_type *types, lo_arg **argv)
+{
+    int num_props = count_props(argc, types, argv);
+    RETURN_ARG_UNLESS(num_props, 0);
+    msg->allocated = 0;
+    return parse_props(msg, num_props, argc, types, argv);
+}
+
 void mpr_msg_free(mpr_msg msg)
 {
     RETURN_UNLESS(msg);
-    FUNC_IF(free, msg->atoms);
-    free(msg);
+    if (msg->atoms != msg->buf)
+        free(msg->atoms);
+    if (msg->allocated)
+        free(msg);
 }
 
 mpr_msg_atom mpr_msg_get_prop(mpr_msg msg, mpr_prop prop)
@@ -327,6 +407,19 @@ mpr_msg_atom mpr_msg_get_prop(mpr_msg msg, mpr_prop prop)
     return 0;
 }
 
+mpr_msg_atom mpr_msg_get_prop_by_key(mpr_msg msg, const char *key)
+{
+    int i;
+    for (i = 0; i < msg->num_atoms; i++) {
+        if (   MPR_PROP_EXTRA == MASK_PROP_BITFLAGS(msg->atoms[i].prop)
+            && msg->atoms[i].key && 0 == strcmp(msg->atoms[i].key, key)) {
+            RETURN_ARG_UNLESS(msg->atoms[i].len && msg->atoms[i].types, 0);
+            return &msg->atoms[i];
+        }
+    }
+    return 0;
+}
+
 #define LO_MESSAGE_ADD_VEC(MSG, TYPE, CAST, VAL)    \
 for (i = 0; i < len; i++)                           \
     lo_message_add_##TYPE(MSG, ((CAST*)VAL)[i]);    \
@@ -374,26 +467,15 @@ const char *mpr_prop_as_str(mpr_prop p, int skip_slash)
 
 mpr_prop mpr_prop_from_str(const char *string)
 {
-    /* property keys are stored alphabetically so we can use a binary search */
-    int beg = PROP_TO_INDEX(MPR_PROP_UNKNOWN) + 1;
-    int end = PROP_TO_INDEX(MPR_PROP_EXTRA) - 1;
-    int mid = (beg + end) * 0.5, cmp;
-    while (beg <= end) {
-        cmp = strcmp(string, static_props[mid].key + 1);
-        if (cmp > 0)
-            beg = mid + 1;
-        else if (cmp == 0)
-            return INDEX_TO_PROP(mid);
-        else
-            end = mid - 1;
-        mid = (beg + end) * 0.5;
+    /* only the key in the hashed slot can match */
+    int idx = prop_hash_idx[hash_prop_key(string)];
+    if (idx & 0x80) {
+        idx &= 0x7F;
+        if (strcmp(string, prop_aliases[idx].key)==0)
+            return prop_aliases[idx].prop;
     }
-    if (strcmp(string, "expression")==0)
-        return MPR_PROP_EXPR;
-    if (strcmp(string, "maximum")==0)
-        return MPR_PROP_MAX;
-    if (strcmp(string, "minimum")==0)
-        return MPR_PROP_MIN;
+    else if (idx && strcmp(string, static_props[idx].key + 1)==0)
+        return INDEX_TO_PROP(idx);
     return MPR_PROP_EXTRA;
 }
 
@@ -435,11 +517,29 @@ mpr_proto mpr_protocol_from_str(const char *str)
 
 const char *mpr_steal_as_str(mpr_steal_type stl)
 {
-    if (stl < MPR_STEAL_NONE || stl > MPR_STEAL_NEWEST)
+    if (stl < MPR_STEAL_NONE || stl > MPR_STEAL_LEAST_RECENT)
         return "unknown";
     return mpr_steal_strings[stl];
 }
 
+const char *mpr_coalesce_as_str(mpr_coalesce_type c)
+{
+    if (c < MPR_COALESCE_NONE || c > MPR_COALESCE_MAX)
+        return "unknown";
+    return mpr_coalesce_strings[c];
+}
+
+mpr_coalesce_type mpr_coalesce_from_str(const char *str)
+{
+    int i;
+    RETURN_ARG_UNLESS(str, MPR_COALESCE_NONE);
+    for (i = MPR_COALESCE_NONE; i <= MPR_COALESCE_MAX; i++) {
+        if (strcmp(str, mpr_coalesce_strings[i])==0)
+            return i;
+    }
+    return MPR_COALESCE_NONE;
+}
+
 /* Helper for setting property value from different data types */
 int set_coerced_val(int src_len, mpr_type src_type, const void *src_val,
                     int dst_len, mpr_type dst_type, void *dst_val)
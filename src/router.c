@@ -19,20 +19,47 @@ static int _is_map_in_scope(mpr_local_map map, mpr_id id)
     return 0;
 }
 
-static mpr_rtr_sig _find_rtr_sig(mpr_rtr rtr, mpr_local_sig sig)
+MPR_INLINE static mpr_rtr_sig _find_rtr_sig(mpr_rtr rtr, mpr_local_sig sig)
 {
-    mpr_rtr_sig rs = rtr->sigs;
-    while (rs && rs->sig != sig)
-        rs = rs->next;
-    return rs;
+    return sig->rsig;
+}
+
+/* Slot ids are assigned sequentially by the destination device so we can index incoming slots
+ * directly. Ids received from remote devices are only indexed if they are reasonably small. */
+#define MAX_SLOT_ID_INDEX 1024
+
+static void _index_slot(mpr_rtr_sig rs, mpr_local_slot slot)
+{
+    int i, size = rs->num_slots_by_id;
+    RETURN_UNLESS(slot->id >= 0 && slot->id < MAX_SLOT_ID_INDEX);
+    if (slot->id >= size) {
+        while (size <= slot->id)
+            size = size ? size * 2 : 4;
+        rs->slots_by_id = realloc(rs->slots_by_id, sizeof(mpr_local_slot) * size);
+        for (i = rs->num_slots_by_id; i < size; i++)
+            rs->slots_by_id[i] = 0;
+        rs->num_slots_by_id = size;
+    }
+    rs->slots_by_id[slot->id] = slot;
+}
+
+static void _unindex_map_slots(mpr_rtr_sig rs, mpr_local_map map)
+{
+    int i;
+    for (i = 0; i < rs->num_slots_by_id; i++) {
+        if (rs->slots_by_id[i] && rs->slots_by_id[i]->map == map)
+            rs->slots_by_id[i] = 0;
+    }
 }
 
 void mpr_rtr_remove_inst(mpr_rtr rtr, mpr_local_sig sig, int inst_idx) {
     int i;
     mpr_rtr_sig rs = _find_rtr_sig(rtr, sig);
     RETURN_UNLESS(rs);
-    for (i = 0; i < rs->num_slots; i++)
-        mpr_slot_remove_inst(rs->slots[i], inst_idx);
+    for (i = 0; i < rs->num_slots; i++) {
+        if (rs->slots[i])
+            mpr_map_clear_inst(rs->slots[i]->map, inst_idx);
+    }
 }
 
 /* TODO: check for mismatched instance counts when using multiple sources */
@@ -79,13 +106,35 @@ static void _update_map_count(mpr_rtr rtr)
     dev->num_maps_out = dev_maps_out;
 }
 
-void mpr_rtr_process_sig(mpr_rtr rtr, mpr_local_sig sig, int idmap_idx, const void *val, mpr_time t)
+void mpr_rtr_size_expr_stack(mpr_rtr rtr)
+{
+    mpr_rtr_sig rs = rtr->sigs;
+    int i, depth = 0, num_samps = 0;
+    RETURN_UNLESS(rtr->dev);
+    while (rs) {
+        for (i = 0; i < rs->num_slots; i++) {
+            int map_depth, map_num_samps;
+            if (!rs->slots[i] || !rs->slots[i]->map->expr)
+                continue;
+            mpr_expr_get_stack_size(rs->slots[i]->map->expr, &map_depth, &map_num_samps);
+            if (map_depth > depth)
+                depth = map_depth;
+            if (map_num_samps > num_samps)
+                num_samps = map_num_samps;
+        }
+        rs = rs->next;
+    }
+    mpr_expr_stack_set_size(rtr->dev->expr_stack, depth, num_samps);
+}
+
+void mpr_rtr_process_sig(mpr_rtr rtr, mpr_local_sig sig, int idmap_idx, const void *val,
+                         const mpr_type *types, mpr_time t)
 {
     mpr_id_map idmap;
     lo_message msg;
     mpr_rtr_sig rs;
     mpr_local_map map;
-    int i, j, inst_idx;
+    int i, j, inst_idx, sig_inst_idx;
     uint8_t bundle_idx, *lock;
 
     /* abort if signal is already being processed - might be a local loop */
@@ -99,7 +148,7 @@ void mpr_rtr_process_sig(mpr_rtr rtr, mpr_local_sig sig, int idmap_idx, const vo
     rs = _find_rtr_sig(rtr, sig);
     RETURN_UNLESS(rs);
 
-    inst_idx = sig->idmaps[idmap_idx].inst->idx;
+    sig_inst_idx = inst_idx = sig->idmaps[idmap_idx].inst->idx;
     bundle_idx = rtr->dev->bundle_idx % NUM_BUNDLES;
     /* TODO: remove duplicate flag set */
     rtr->dev->sending = 1; /* mark as updated */
@@ -120,6 +169,10 @@ void mpr_rtr_process_sig(mpr_rtr rtr, mpr_local_sig sig, int idmap_idx, const vo
             if (map->status < MPR_STATUS_ACTIVE)
                 continue;
 
+            /* send any coalesced update before the release */
+            if (slot->pending_inst)
+                mpr_map_send_pending(map, slot, idmap_idx);
+
             dst_slot = map->dst;
             in_scope = _is_map_in_scope(map, idmap->GID);
 
@@ -149,6 +202,7 @@ void mpr_rtr_process_sig(mpr_rtr rtr, mpr_local_sig sig, int idmap_idx, const vo
 
             /* reset associated output memory */
             mpr_value_reset_inst(&dst_slot->val, inst_idx);
+            mpr_map_set_dirty(map, inst_idx, 0);
 
             /* send release to downstream */
             if (slot->dir == MPR_DIR_OUT) {
@@ -189,16 +243,26 @@ void mpr_rtr_process_sig(mpr_rtr rtr, mpr_local_sig sig, int idmap_idx, const vo
         all = (!sig->use_inst && map->num_src > 1 && map->num_inst > 1);
 
         if (MPR_LOC_DST == map->process_loc) {
-            /* bypass map processing and bundle value without type coercion */
-            char *types = alloca(sig->len * sizeof(char));
-            memset(types, sig->type, sig->len);
-            msg = mpr_map_build_msg(map, slot, val, types, sig->use_inst ? idmap : 0);
+            char *full_types;
+            if (slot->pending_inst) {
+                /* map is coalesced or rate-limited: overwrite any pending update,
+                 * the latest value will be sent when the map is processed */
+                set_bitflag(slot->pending_inst, sig_inst_idx);
+                map->updated = 1;
+                continue;
+            }
+            /* bypass map processing and bundle value without type coercion. The whole vector is
+             * sent since the destination slot mirrors the value of this signal. */
+            full_types = alloca(sig->len * sizeof(char));
+            memset(full_types, sig->type, sig->len);
+            msg = mpr_map_build_msg(map, slot, val, full_types, sig->use_inst ? idmap : 0);
             mpr_link_add_msg(map->dst->link, map->dst->sig, msg, t, map->protocol, bundle_idx);
             continue;
         }
 
         /* copy input value */
         mpr_value_set_samp(&slot->val, inst_idx, (void*)val, t);
+        mpr_map_set_dirty(map, inst_idx, types);
 
         if (!slot->causes_update)
             continue;
@@ -226,6 +290,73 @@ void mpr_rtr_process_sig(mpr_rtr rtr, mpr_local_sig sig, int idmap_idx, const vo
     *lock = 0;
 }
 
+void mpr_rtr_process_sig_insts(mpr_rtr rtr, mpr_local_sig sig, int num, const int *idmap_idxs,
+                               mpr_time t)
+{
+    lo_message msg;
+    mpr_rtr_sig rs;
+    mpr_local_map map;
+    mpr_local_slot slot;
+    struct _mpr_sig_idmap *smap;
+    char *full_types = 0;
+    int i, j, inst_idx;
+    uint8_t bundle_idx;
+
+    /* abort if signal is already being processed - might be a local loop */
+    if (sig->locked) {
+        trace_dev(rtr->dev, "Mapping loop detected on signal %s! (1)\n", sig->name);
+        return;
+    }
+    rs = _find_rtr_sig(rtr, sig);
+    RETURN_UNLESS(rs);
+
+    bundle_idx = rtr->dev->bundle_idx % NUM_BUNDLES;
+    rtr->dev->sending = 1;
+    sig->locked = 1;
+
+    for (i = 0; i < rs->num_slots; i++) {
+        if (!(slot = rs->slots[i]) || slot->dir == MPR_DIR_IN)
+            continue;
+        map = slot->map;
+        if (map->status < MPR_STATUS_ACTIVE)
+            continue;
+
+        if (MPR_LOC_DST == map->process_loc && !slot->pending_inst && !full_types) {
+            full_types = alloca(sig->len * sizeof(char));
+            memset(full_types, sig->type, sig->len);
+        }
+
+        /* messages for all instances are added to the same bundle of the destination link */
+        for (j = 0; j < num; j++) {
+            smap = &sig->idmaps[idmap_idxs[j]];
+            if (!smap->inst || (map->use_inst && !_is_map_in_scope(map, smap->map->GID)))
+                continue;
+            inst_idx = smap->inst->idx;
+
+            if (MPR_LOC_DST == map->process_loc) {
+                if (slot->pending_inst) {
+                    set_bitflag(slot->pending_inst, inst_idx);
+                    map->updated = 1;
+                    continue;
+                }
+                msg = mpr_map_build_msg(map, slot, smap->inst->val, full_types, smap->map);
+                mpr_link_add_msg(map->dst->link, map->dst->sig, msg, t, map->protocol,
+                                 bundle_idx);
+                continue;
+            }
+
+            /* copy input value */
+            mpr_value_set_samp(&slot->val, inst_idx, smap->inst->val, t);
+            mpr_map_set_dirty(map, inst_idx, 0);
+            if (slot->causes_update) {
+                set_bitflag(map->updated_inst, inst_idx);
+                map->updated = 1;
+            }
+        }
+    }
+    sig->locked = 0;
+}
+
 static mpr_rtr_sig _add_rtr_sig(mpr_rtr rtr, mpr_local_sig sig)
 {
     /* find signal in rtr_sig list */
@@ -240,6 +371,7 @@ static mpr_rtr_sig _add_rtr_sig(mpr_rtr rtr, mpr_local_sig sig)
         rs->slots[0] = 0;
         rs->next = rtr->sigs;
         rtr->sigs = rs;
+        sig->rsig = rs;
     }
     return rs;
 }
@@ -294,11 +426,12 @@ static void _add_local_slot(mpr_rtr rtr, mpr_local_slot slot, int is_src, int *m
 {
     slot->dir = (is_src ^ (slot->sig->is_local ? 1 : 0)) ? MPR_DIR_IN : MPR_DIR_OUT;
     if (slot->sig->is_local) {
+        int num_inst = mpr_sig_get_num_inst_idx(slot->sig);
         slot->rsig = _add_rtr_sig(rtr, (mpr_local_sig)slot->sig);
         _store_slot(slot->rsig, slot);
 
-        if (slot->sig->num_inst > *max_inst)
-            *max_inst = slot->sig->num_inst;
+        if (num_inst > *max_inst)
+            *max_inst = num_inst;
         if (slot->num_inst > *max_inst)
             *max_inst = slot->num_inst;
         if (slot->sig->use_inst)
@@ -336,8 +469,10 @@ void mpr_rtr_add_map(mpr_rtr rtr, mpr_local_map map)
     map->protocol = use_inst ? MPR_PROTO_TCP : MPR_PROTO_UDP;
 
     /* assign a unique id to this map if we are the destination */
-    if (local_dst)
+    if (local_dst) {
         map->obj.id = _get_unused_map_id(rtr->dev, rtr);
+        mpr_graph_reindex_obj(map->obj.graph, (mpr_obj)map);
+    }
 
     /* assign indices to source slots */
     if (local_dst) {
@@ -439,7 +574,9 @@ void mpr_rtr_remove_sig(mpr_rtr rtr, mpr_rtr_sig rs)
         while (*rstemp) {
             if (*rstemp == rs) {
                 *rstemp = rs->next;
+                rs->sig->rsig = 0;
                 free(rs->slots);
+                FUNC_IF(free, rs->slots_by_id);
                 free(rs);
                 break;
             }
@@ -482,7 +619,7 @@ int mpr_rtr_remove_map(mpr_rtr rtr, mpr_local_map map)
                 continue;
             if (maps[i].status & RELEASED_LOCALLY) {
                 mpr_dev_GID_decref(rtr->dev, sig->group, maps[i].map);
-                maps[i].map = 0;
+                mpr_sig_clear_idmap(sig, i);
             }
             else {
                 maps[i].status |= RELEASED_REMOTELY;
@@ -494,8 +631,8 @@ int mpr_rtr_remove_map(mpr_rtr rtr, mpr_local_map map)
                 }
                 else {
                     mpr_dev_LID_decref(rtr->dev, sig->group, maps[i].map);
-                    maps[i].map = 0;
-                    maps[i].inst->active = 0;
+                    mpr_sig_clear_idmap(sig, i);
+                    mpr_sig_deactivate_inst(sig, maps[i].inst);
                     maps[i].inst = 0;
                 }
             }
@@ -507,6 +644,7 @@ int mpr_rtr_remove_map(mpr_rtr rtr, mpr_local_map map)
                 break;
             }
         }
+        _unindex_map_slots(rs, map);
     }
     else if (map->dst->link) {
         mpr_link_remove_map(map->dst->link, map);
@@ -520,6 +658,7 @@ int mpr_rtr_remove_map(mpr_rtr rtr, mpr_local_map map)
                 if (rs->slots[j] == map->src[i])
                     rs->slots[j] = 0;
             }
+            _unindex_map_slots(rs, map);
         }
         else if (map->src[i]->link) {
             mpr_link_remove_map(map->src[i]->link, map);
@@ -546,8 +685,15 @@ int mpr_rtr_remove_map(mpr_rtr rtr, mpr_local_map map)
     }
 
     FUNC_IF(free, map->updated_inst);
+    FUNC_IF(free, map->held_vals);
+    FUNC_IF(free, map->held_counts);
+    FUNC_IF(free, map->held_idmaps);
+    FUNC_IF(free, map->held_inst);
+    FUNC_IF(free, map->sent_vals);
+    FUNC_IF(free, map->dirty_elems);
     FUNC_IF(mpr_expr_free, map->expr);
     _update_map_count(rtr);
+    mpr_rtr_size_expr_stack(rtr);
     return 0;
 }
 
@@ -573,22 +719,32 @@ int mpr_rtr_loop_check(mpr_rtr rtr, mpr_local_sig sig, int num_remotes, const ch
     return 0;
 }
 
-/* TODO: speed this up with sorted slots and binary search */
 mpr_local_slot mpr_rtr_get_slot(mpr_rtr rtr, mpr_local_sig sig, int slot_id)
 {
     int i, j;
     mpr_local_map map;
+    mpr_local_slot slot;
     /* only interested in incoming slots */
     mpr_rtr_sig rs = _find_rtr_sig(rtr, sig);
     RETURN_ARG_UNLESS(rs, NULL);
+
+    /* check the slot index first, slot ids may have been reassigned since it was stored */
+    if (slot_id >= 0 && slot_id < rs->num_slots_by_id) {
+        slot = rs->slots_by_id[slot_id];
+        if (slot && slot->id == slot_id)
+            return slot;
+    }
+
     for (i = 0; i < rs->num_slots; i++) {
         if (!rs->slots[i] || sig->dir != rs->slots[i]->dir)
             continue;
         map = rs->slots[i]->map;
         /* check incoming slots for this map */
         for (j = 0; j < map->num_src; j++) {
-            if ((int)map->src[j]->id == slot_id)
+            if ((int)map->src[j]->id == slot_id) {
+                _index_slot(rs, map->src[j]);
                 return map->src[j];
+            }
         }
     }
     return NULL;
@@ -8,7 +8,7 @@
 #include "types_internal.h"
 #include <mapper/mapper.h>
 
-#define MAX_INSTANCES 128
+#define MAX_INSTANCES 16384
 #define BUFFSIZE 512
 
 /* TODO: MPR_DEFAULT_INST is actually a valid id - we should use
@@ -18,20 +18,6 @@
 /* Function prototypes */
 static int _add_idmap(mpr_local_sig lsig, mpr_sig_inst si, mpr_id_map map);
 
-static int _compare_inst_ids(const void *l, const void *r)
-{
-    return memcmp(&(*(mpr_sig_inst*)l)->id, &(*(mpr_sig_inst*)r)->id, sizeof(mpr_id));
-}
-
-static mpr_sig_inst _find_inst_by_id(mpr_local_sig lsig, mpr_id id)
-{
-    mpr_sig_inst_t si, *sip, **sipp;
-    RETURN_ARG_UNLESS(lsig->num_inst, 0);
-    sip = &si;
-    si.id = id;
-    sipp = bsearch(&sip, lsig->inst, lsig->num_inst, sizeof(mpr_sig_inst), _compare_inst_ids);
-    return (sipp && *sipp) ? *sipp : 0;
-}
 
 /* Add a signal to a parent object. */
 mpr_sig mpr_sig_new(mpr_dev dev, mpr_dir dir, const char *name, int len,
@@ -53,22 +39,25 @@ mpr_sig mpr_sig_new(mpr_dev dev, mpr_dir dir, const char *name, int len,
     if ((lsig = (mpr_local_sig)mpr_dev_get_sig_by_name(dev, name)))
         return (mpr_sig)lsig;
 
-    lsig = (mpr_local_sig)mpr_list_add_item((void**)&g->sigs, sizeof(mpr_local_sig_t));
+    lsig = (mpr_local_sig)mpr_list_add_item((void**)&g->sigs, sizeof(mpr_local_sig_t), &g->pools);
     lsig->dev = (mpr_local_dev)dev;
     lsig->obj.id = mpr_dev_get_unused_sig_id((mpr_local_dev)dev);
     lsig->obj.graph = g;
+    ++g->version;
     lsig->period = -1;
     lsig->handler = (void*)h;
     lsig->event_flags = events;
     lsig->is_local = 1;
     mpr_sig_init((mpr_sig)lsig, dir, name, len, type, unit, min, max, num_inst);
+    mpr_dev_add_sig_ref(dev, (mpr_sig)lsig);
+    mpr_graph_reindex_obj(g, (mpr_obj)lsig);
 
     if (dir == MPR_DIR_IN)
         ++dev->num_inputs;
     else
         ++dev->num_outputs;
 
-    mpr_obj_increment_version((mpr_obj)dev);
+    mpr_dev_record_change((mpr_obj)lsig);
 
     mpr_dev_add_sig_methods((mpr_local_dev)dev, lsig);
     if (((mpr_local_dev)dev)->registered) {
@@ -106,6 +95,8 @@ void mpr_sig_init(mpr_sig sig, mpr_dir dir, const char *name, int len, mpr_type
         for (i = 0; i < len; i++)
             set_bitflag(lsig->vec_known, i);
         lsig->updated_inst = 0;
+        for (i = 0; i < NUM_INST_ORDERS; i++)
+            lsig->inst_oldest[i] = lsig->inst_newest[i] = -1;
         if (num_inst) {
             mpr_sig_reserve_inst((mpr_sig)lsig, *num_inst, 0, 0);
             lsig->use_inst = 1;
@@ -120,10 +111,10 @@ void mpr_sig_init(mpr_sig sig, mpr_dir dir, const char *name, int len, mpr_type
         lsig->idmaps = calloc(1, sizeof(struct _mpr_sig_idmap));
     }
     else
-        sig->obj.props.staged = mpr_tbl_new();
+        sig->obj.props.staged = mpr_tbl_new(&sig->obj.graph->keys);
 
     sig->obj.type = MPR_SIG;
-    sig->obj.props.synced = mpr_tbl_new();
+    sig->obj.props.synced = mpr_tbl_new(&sig->obj.graph->keys);
 
     tbl = sig->obj.props.synced;
     loc_mod = sig->is_local ? MODIFIABLE : NON_MODIFIABLE;
@@ -189,6 +180,9 @@ void mpr_sig_free(mpr_sig sig)
     RETURN_UNLESS(sig && sig->is_local);
     ldev = (mpr_local_dev)sig->dev;
 
+    /* discard updates queued from other threads */
+    mpr_dev_unqueue_sig(ldev, lsig);
+
     /* release active instances */
     for (i = 0; i < lsig->idmap_len; i++) {
         if (lsig->idmaps[i].inst)
@@ -199,9 +193,7 @@ void mpr_sig_free(mpr_sig sig)
     mpr_dev_remove_sig_methods(ldev, lsig);
     net = &sig->obj.graph->net;
     rtr = net->rtr;
-    rs = rtr->sigs;
-    while (rs && rs->sig != lsig)
-        rs = rs->next;
+    rs = lsig->rsig;
     if (rs) {
         mpr_local_map map;
         /* need to unmap */
@@ -220,9 +212,7 @@ void mpr_sig_free(mpr_sig sig)
         mpr_net_use_subscribers(net, ldev, dir);
         mpr_sig_send_removed(lsig);
     }
-    free(lsig->updated_inst);
-    mpr_graph_remove_sig(sig->obj.graph, sig, MPR_OBJ_REM);
-    mpr_obj_increment_version((mpr_obj)ldev);
+    mpr_graph_remove_sig(sig->obj.graph, sig, MPR_OBJ_REM, 0);
 }
 
 void mpr_sig_free_internal(mpr_sig sig)
@@ -237,12 +227,15 @@ void mpr_sig_free_internal(mpr_sig sig)
                 mpr_sig_release_inst_internal(lsig, i);
         }
         free(lsig->idmaps);
-        for (i = 0; i < lsig->num_inst; i++) {
-            FUNC_IF(free, lsig->inst[i]->val);
-            FUNC_IF(free, lsig->inst[i]->has_val_flags);
-            free(lsig->inst[i]);
-        }
-        free(lsig->inst);
+        FUNC_IF(free, lsig->updated_inst);
+        for (i = 0; i < lsig->num_inst_chunks; i++)
+            free(lsig->inst_chunks[i]);
+        FUNC_IF(free, lsig->inst_chunks);
+        FUNC_IF(free, lsig->vacant_inst);
+        FUNC_IF(free, lsig->free_inst);
+        FUNC_IF(free, lsig->inst_order);
+        FUNC_IF(free, lsig->inst_hash);
+        FUNC_IF(free, lsig->idmap_hash);
         FUNC_IF(free, lsig->vec_known);
     }
 
@@ -281,42 +274,294 @@ static void _init_inst(mpr_sig_inst si)
     mpr_time_set(&si->time, si->created);
 }
 
-static mpr_sig_inst _reserved_inst(mpr_local_sig lsig, mpr_id *id)
+/* Instance ids and id map GIDs are hashed into open-addressed tables of indices using linear
+ * probing.  Table sizes are powers of two and at least twice the number of entries. */
+typedef mpr_id (*_idx_key_fn)(mpr_local_sig lsig, int idx);
+
+static mpr_id _inst_key(mpr_local_sig lsig, int idx)
 {
-    int i;
-    for (i = 0; i < lsig->num_inst; i++) {
-        if (!lsig->inst[i]->active) {
-            if (id)
-                lsig->inst[i]->id = *id;
-            qsort(lsig->inst, lsig->num_inst, sizeof(mpr_sig_inst), _compare_inst_ids);
-            return lsig->inst[i];
+    return mpr_sig_get_inst_by_idx(lsig, idx)->id;
+}
+
+static mpr_id _idmap_key(mpr_local_sig lsig, int idx)
+{
+    return lsig->idmaps[idx].map->GID;
+}
+
+static void _idx_tbl_add(int *tbl, int size, mpr_id key, int idx)
+{
+    int i = mpr_hash_id(key, size);
+    while (tbl[i] >= 0)
+        i = (i + 1) & (size - 1);
+    tbl[i] = idx;
+}
+
+static void _idx_tbl_remove(mpr_local_sig lsig, int *tbl, int size, mpr_id key, int idx,
+                            _idx_key_fn key_fn)
+{
+    int i, j, k, mask = size - 1;
+    i = mpr_hash_id(key, size);
+    while (tbl[i] != idx) {
+        RETURN_UNLESS(tbl[i] >= 0);
+        i = (i + 1) & mask;
+    }
+    /* shift back following entries that would otherwise become unreachable */
+    for (j = (i + 1) & mask; tbl[j] >= 0; j = (j + 1) & mask) {
+        k = mpr_hash_id(key_fn(lsig, tbl[j]), size);
+        if (i <= j ? (k <= i || k > j) : (k <= i && k > j)) {
+            tbl[i] = tbl[j];
+            i = j;
         }
     }
+    tbl[i] = -1;
+}
+
+static void _hash_inst(mpr_local_sig lsig, mpr_sig_inst si)
+{
+    _idx_tbl_add(lsig->inst_hash, lsig->inst_hash_size, si->id, si->idx);
+}
+
+static void _unhash_inst(mpr_local_sig lsig, mpr_sig_inst si)
+{
+    _idx_tbl_remove(lsig, lsig->inst_hash, lsig->inst_hash_size, si->id, si->idx, _inst_key);
+}
+
+static void _rehash_insts(mpr_local_sig lsig)
+{
+    int i;
+    lsig->inst_hash = realloc(lsig->inst_hash, sizeof(int) * lsig->inst_hash_size);
+    memset(lsig->inst_hash, 0xFF, sizeof(int) * lsig->inst_hash_size);
+    for (i = 0; i < lsig->num_inst; i++)
+        _hash_inst(lsig, mpr_sig_get_inst_by_idx(lsig, lsig->inst_order[i]));
+}
+
+static mpr_sig_inst _find_inst_by_id(mpr_local_sig lsig, mpr_id id)
+{
+    int i, idx;
+    RETURN_ARG_UNLESS(lsig->num_inst, 0);
+    i = mpr_hash_id(id, lsig->inst_hash_size);
+    while ((idx = lsig->inst_hash[i]) >= 0) {
+        if (mpr_sig_get_inst_by_idx(lsig, idx)->id == id)
+            return mpr_sig_get_inst_by_idx(lsig, idx);
+        i = (i + 1) & (lsig->inst_hash_size - 1);
+    }
     return 0;
 }
 
-int _oldest_inst(mpr_local_sig lsig)
+static void _rehash_idmaps(mpr_local_sig lsig)
 {
-    int i, oldest;
-    mpr_sig_inst si;
+    int i;
+    lsig->idmap_hash_size = lsig->idmap_len * 2;
+    lsig->idmap_hash = realloc(lsig->idmap_hash, sizeof(int) * lsig->idmap_hash_size);
+    memset(lsig->idmap_hash, 0xFF, sizeof(int) * lsig->idmap_hash_size);
     for (i = 0; i < lsig->idmap_len; i++) {
-        if (lsig->idmaps[i].inst)
+        if (lsig->idmaps[i].map)
+            _idx_tbl_add(lsig->idmap_hash, lsig->idmap_hash_size, lsig->idmaps[i].map->GID, i);
+    }
+}
+
+static int _find_idmap_by_GID(mpr_local_sig lsig, mpr_id GID)
+{
+    int i, idx;
+    RETURN_ARG_UNLESS(lsig->idmap_hash_size, -1);
+    i = mpr_hash_id(GID, lsig->idmap_hash_size);
+    while ((idx = lsig->idmap_hash[i]) >= 0) {
+        if (lsig->idmaps[idx].map->GID == GID)
+            return idx;
+        i = (i + 1) & (lsig->idmap_hash_size - 1);
+    }
+    return -1;
+}
+
+void mpr_sig_clear_idmap(mpr_local_sig lsig, int idmap_idx)
+{
+    mpr_sig_idmap_t *smap = &lsig->idmaps[idmap_idx];
+    RETURN_UNLESS(smap->map);
+    _idx_tbl_remove(lsig, lsig->idmap_hash, lsig->idmap_hash_size, smap->map->GID, idmap_idx,
+                    _idmap_key);
+    smap->map = 0;
+    if (idmap_idx < lsig->idmap_free_hint)
+        lsig->idmap_free_hint = idmap_idx;
+}
+
+/* Instance indices are also kept in an array sorted by id, so that indexed accessors and
+ * reservations follow id order. */
+static int _inst_order_pos(mpr_local_sig lsig, mpr_id id, int num)
+{
+    int lo = 0, hi = num, mid;
+    while (lo < hi) {
+        mid = (lo + hi) / 2;
+        if (mpr_sig_get_inst_by_idx(lsig, lsig->inst_order[mid])->id < id)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+    return lo;
+}
+
+static void _order_inst(mpr_local_sig lsig, mpr_sig_inst si, int num)
+{
+    int pos = _inst_order_pos(lsig, si->id, num);
+    memmove(lsig->inst_order + pos + 1, lsig->inst_order + pos, sizeof(int) * (num - pos));
+    lsig->inst_order[pos] = si->idx;
+}
+
+static void _unorder_inst(mpr_local_sig lsig, mpr_sig_inst si, int num)
+{
+    int pos = _inst_order_pos(lsig, si->id, num);
+    RETURN_UNLESS(pos < num && lsig->inst_order[pos] == si->idx);
+    memmove(lsig->inst_order + pos, lsig->inst_order + pos + 1, sizeof(int) * (num - pos - 1));
+}
+
+/* Inactive instances are kept in a binary min-heap by id so that the reserved instance with the
+ * lowest id can be claimed without scanning. */
+static void _place_free_inst(mpr_local_sig lsig, int pos, int idx)
+{
+    lsig->free_inst[pos] = idx;
+    mpr_sig_get_inst_by_idx(lsig, idx)->free_pos = pos;
+}
+
+static void _sift_free_inst(mpr_local_sig lsig, int pos)
+{
+    int *heap = lsig->free_inst, idx = heap[pos], parent, child;
+    mpr_id id = mpr_sig_get_inst_by_idx(lsig, idx)->id;
+    while (pos > 0) {
+        parent = (pos - 1) / 2;
+        if (mpr_sig_get_inst_by_idx(lsig, heap[parent])->id <= id)
             break;
+        _place_free_inst(lsig, pos, heap[parent]);
+        pos = parent;
     }
-    if (i == lsig->idmap_len) {
-        /* no active instances to steal! */
-        return -1;
+    while ((child = pos * 2 + 1) < lsig->num_free_inst) {
+        if (child + 1 < lsig->num_free_inst
+            && (  mpr_sig_get_inst_by_idx(lsig, heap[child + 1])->id
+                < mpr_sig_get_inst_by_idx(lsig, heap[child])->id))
+            ++child;
+        if (mpr_sig_get_inst_by_idx(lsig, heap[child])->id >= id)
+            break;
+        _place_free_inst(lsig, pos, heap[child]);
+        pos = child;
     }
-    oldest = i;
-    for (i = oldest+1; i < lsig->idmap_len; i++) {
-        if (!(si = lsig->idmaps[i].inst))
-            continue;
-        if ((si->created.sec < lsig->idmaps[oldest].inst->created.sec) ||
-            (si->created.sec == lsig->idmaps[oldest].inst->created.sec &&
-             si->created.frac < lsig->idmaps[oldest].inst->created.frac))
-            oldest = i;
+    _place_free_inst(lsig, pos, idx);
+}
+
+static void _push_free_inst(mpr_local_sig lsig, mpr_sig_inst si)
+{
+    _place_free_inst(lsig, lsig->num_free_inst++, si->idx);
+    _sift_free_inst(lsig, si->free_pos);
+}
+
+static void _remove_free_inst(mpr_local_sig lsig, mpr_sig_inst si)
+{
+    int pos = si->free_pos;
+    RETURN_UNLESS(pos >= 0);
+    si->free_pos = -1;
+    /* move the last heap entry into the vacated position */
+    if (pos < --lsig->num_free_inst) {
+        _place_free_inst(lsig, pos, lsig->free_inst[lsig->num_free_inst]);
+        _sift_free_inst(lsig, pos);
     }
-    return oldest;
+}
+
+static void _set_inst_id(mpr_local_sig lsig, mpr_sig_inst si, mpr_id id)
+{
+    RETURN_UNLESS(si->id != id);
+    _unhash_inst(lsig, si);
+    _unorder_inst(lsig, si, lsig->num_inst);
+    if (si->id < lsig->inst_id_hint)
+        lsig->inst_id_hint = si->id;
+    si->id = id;
+    _hash_inst(lsig, si);
+    _order_inst(lsig, si, lsig->num_inst - 1);
+    if (si->free_pos >= 0)
+        _sift_free_inst(lsig, si->free_pos);
+}
+
+/* Active instances are also threaded onto doubly linked lists of instance indices, ordered by
+ * activation and by most recent update, so that an instance to steal can be found directly. */
+static void _link_inst(mpr_local_sig lsig, mpr_sig_inst si, int order)
+{
+    si->next[order] = -1;
+    si->prev[order] = lsig->inst_newest[order];
+    if (si->prev[order] >= 0)
+        mpr_sig_get_inst_by_idx(lsig, si->prev[order])->next[order] = si->idx;
+    else
+        lsig->inst_oldest[order] = si->idx;
+    lsig->inst_newest[order] = si->idx;
+}
+
+static void _unlink_inst(mpr_local_sig lsig, mpr_sig_inst si, int order)
+{
+    if (si->prev[order] >= 0)
+        mpr_sig_get_inst_by_idx(lsig, si->prev[order])->next[order] = si->next[order];
+    else
+        lsig->inst_oldest[order] = si->next[order];
+    if (si->next[order] >= 0)
+        mpr_sig_get_inst_by_idx(lsig, si->next[order])->prev[order] = si->prev[order];
+    else
+        lsig->inst_newest[order] = si->prev[order];
+}
+
+static void _activate_inst(mpr_local_sig lsig, mpr_sig_inst si)
+{
+    int i;
+    for (i = 0; i < NUM_INST_ORDERS; i++) {
+        if (si->active)
+            _unlink_inst(lsig, si, i);
+        _link_inst(lsig, si, i);
+    }
+    _remove_free_inst(lsig, si);
+    si->active = 1;
+    _init_inst(si);
+}
+
+void mpr_sig_deactivate_inst(mpr_local_sig lsig, mpr_sig_inst si)
+{
+    int i;
+    RETURN_UNLESS(si->active);
+    for (i = 0; i < NUM_INST_ORDERS; i++)
+        _unlink_inst(lsig, si, i);
+    si->active = 0;
+    _push_free_inst(lsig, si);
+}
+
+void mpr_sig_touch_inst(mpr_local_sig lsig, mpr_sig_inst si)
+{
+    RETURN_UNLESS(si->active && lsig->inst_newest[INST_BY_UPDATE] != si->idx);
+    _unlink_inst(lsig, si, INST_BY_UPDATE);
+    _link_inst(lsig, si, INST_BY_UPDATE);
+}
+
+static mpr_sig_inst _reserved_inst(mpr_local_sig lsig, mpr_id *id)
+{
+    mpr_sig_inst si;
+    RETURN_ARG_UNLESS(lsig->num_free_inst, 0);
+    si = mpr_sig_get_inst_by_idx(lsig, lsig->free_inst[0]);
+    if (id)
+        _set_inst_id(lsig, si, *id);
+    return si;
+}
+
+/* Return the id map index of the first instance with an id map, walking the given ordering from
+ * its oldest or newest end. */
+static int _first_inst_idmap(mpr_local_sig lsig, int order, int from_newest)
+{
+    int i = from_newest ? lsig->inst_newest[order] : lsig->inst_oldest[order];
+    mpr_sig_inst si;
+    while (i >= 0) {
+        si = mpr_sig_get_inst_by_idx(lsig, i);
+        if (si->idmap_idx >= 0 && si->idmap_idx < lsig->idmap_len
+            && lsig->idmaps[si->idmap_idx].inst == si)
+            return si->idmap_idx;
+        i = from_newest ? si->prev[order] : si->next[order];
+    }
+    /* no active instances to steal! */
+    return -1;
+}
+
+static int _oldest_inst(mpr_local_sig lsig)
+{
+    return _first_inst_idmap(lsig, INST_BY_ACTIVATION, 0);
 }
 
 mpr_id mpr_sig_get_oldest_inst_id(mpr_sig sig)
@@ -327,28 +572,24 @@ mpr_id mpr_sig_get_oldest_inst_id(mpr_sig sig)
     return (idx >= 0) ? ((mpr_local_sig)sig)->idmaps[idx].map->LID : 0;
 }
 
-int _newest_inst(mpr_local_sig lsig)
+static int _newest_inst(mpr_local_sig lsig)
 {
-    int i, newest;
-    mpr_sig_inst si;
-    for (i = 0; i < lsig->idmap_len; i++) {
-        if (lsig->idmaps[i].inst)
-            break;
-    }
-    if (i == lsig->idmap_len) {
-        /* no active instances to steal! */
-        return -1;
-    }
-    newest = i;
-    for (i = newest + 1; i < lsig->idmap_len; i++) {
-        if (!(si = lsig->idmaps[i].inst))
-            continue;
-        if ((si->created.sec > lsig->idmaps[newest].inst->created.sec) ||
-            (si->created.sec == lsig->idmaps[newest].inst->created.sec &&
-             si->created.frac > lsig->idmaps[newest].inst->created.frac))
-            newest = i;
+    return _first_inst_idmap(lsig, INST_BY_ACTIVATION, 1);
+}
+
+/* Return the id map index of the instance to steal according to the signal's stealing mode. */
+static int _steal_inst(mpr_local_sig lsig)
+{
+    switch (lsig->steal_mode) {
+        case MPR_STEAL_OLDEST:
+            return _oldest_inst(lsig);
+        case MPR_STEAL_NEWEST:
+            return _newest_inst(lsig);
+        case MPR_STEAL_LEAST_RECENT:
+            return _first_inst_idmap(lsig, INST_BY_UPDATE, 0);
+        default:
+            return -1;
     }
-    return newest;
 }
 
 mpr_id mpr_sig_get_newest_inst_id(mpr_sig sig)
@@ -370,9 +611,18 @@ int mpr_sig_get_idmap_with_LID(mpr_local_sig lsig, mpr_id LID, int flags, mpr_ti
         LID = MPR_DEFAULT_INST;
     maps = lsig->idmaps;
     h = (mpr_sig_handler*)lsig->handler;
-    for (i = 0; i < lsig->idmap_len; i++) {
-        if (maps[i].inst && maps[i].map->LID == LID)
+
+    /* Instances are always activated with the same id as the local id of their id map, so
+     * the instance hash can be used to find the id map. */
+    si = _find_inst_by_id(lsig, LID);
+    if (si && si->active) {
+        i = si->idmap_idx;
+        if (i >= 0 && i < lsig->idmap_len && maps[i].inst == si && maps[i].map->LID == LID)
             return (maps[i].status & ~flags) ? -1 : i;
+        for (i = 0; i < lsig->idmap_len; i++) {
+            if (maps[i].inst && maps[i].map->LID == LID)
+                return (maps[i].status & ~flags) ? -1 : i;
+        }
     }
     RETURN_ARG_UNLESS(activate, -1);
 
@@ -390,8 +640,7 @@ int mpr_sig_get_idmap_with_LID(mpr_local_sig lsig, mpr_id LID, int flags, mpr_ti
             mpr_dev_LID_incref((mpr_local_dev)lsig->dev, map);
 
         /* store pointer to device map in a new signal map */
-        si->active = 1;
-        _init_inst(si);
+        _activate_inst(lsig, si);
         i = _add_idmap(lsig, si, map);
         if (h && (lsig->event_flags & MPR_SIG_INST_NEW))
             h((mpr_sig)lsig, MPR_SIG_INST_NEW, LID, 0, lsig->type, NULL, t);
@@ -403,17 +652,7 @@ int mpr_sig_get_idmap_with_LID(mpr_local_sig lsig, mpr_id LID, int flags, mpr_ti
         /* call instance event handler */
         h((mpr_sig)lsig, MPR_SIG_INST_OFLW, 0, 0, lsig->type, NULL, t);
     }
-    else if (lsig->steal_mode == MPR_STEAL_OLDEST) {
-        i = _oldest_inst(lsig);
-        if (i < 0)
-            return -1;
-        h((mpr_sig)lsig, MPR_SIG_REL_UPSTRM & lsig->event_flags ? MPR_SIG_REL_UPSTRM : MPR_SIG_UPDATE,
-          lsig->idmaps[i].map->LID, 0, lsig->type, 0, t);
-    }
-    else if (lsig->steal_mode == MPR_STEAL_NEWEST) {
-        i = _newest_inst(lsig);
-        if (i < 0)
-            return -1;
+    else if ((i = _steal_inst(lsig)) >= 0) {
         h((mpr_sig)lsig, MPR_SIG_REL_UPSTRM & lsig->event_flags ? MPR_SIG_REL_UPSTRM : MPR_SIG_UPDATE,
           lsig->idmaps[i].map->LID, 0, lsig->type, 0, t);
     }
@@ -428,8 +667,7 @@ int mpr_sig_get_idmap_with_LID(mpr_local_sig lsig, mpr_id LID, int flags, mpr_ti
         }
         else
             mpr_dev_LID_incref((mpr_local_dev)lsig->dev, map);
-        si->active = 1;
-        _init_inst(si);
+        _activate_inst(lsig, si);
         i = _add_idmap(lsig, si, map);
         if (h && (lsig->event_flags & MPR_SIG_INST_NEW))
             h((mpr_sig)lsig, MPR_SIG_INST_NEW, LID, 0, lsig->type, NULL, t);
@@ -447,10 +685,9 @@ int mpr_sig_get_idmap_with_GID(mpr_local_sig lsig, mpr_id GID, int flags, mpr_ti
     int i;
     maps = lsig->idmaps;
     h = (mpr_sig_handler*)lsig->handler;
-    for (i = 0; i < lsig->idmap_len; i++) {
-        if (maps[i].map && maps[i].map->GID == GID)
-            return (maps[i].status & ~flags) ? -1 : i;
-    }
+    i = _find_idmap_by_GID(lsig, GID);
+    if (i >= 0)
+        return (maps[i].status & ~flags) ? -1 : i;
     RETURN_ARG_UNLESS(activate, -1);
 
     /* check if the device already has a map for this global id */
@@ -465,8 +702,7 @@ int mpr_sig_get_idmap_with_GID(mpr_local_sig lsig, mpr_id GID, int flags, mpr_ti
         if ((si = _reserved_inst(lsig, NULL))) {
             map = mpr_dev_add_idmap((mpr_local_dev)lsig->dev, lsig->group, si->id, GID);
             map->GID_refcount = 1;
-            si->active = 1;
-            _init_inst(si);
+            _activate_inst(lsig, si);
             i = _add_idmap(lsig, si, map);
             if (h && (lsig->event_flags & MPR_SIG_INST_NEW))
                 h((mpr_sig)lsig, MPR_SIG_INST_NEW, si->id, 0, lsig->type, NULL, t);
@@ -475,8 +711,7 @@ int mpr_sig_get_idmap_with_GID(mpr_local_sig lsig, mpr_id GID, int flags, mpr_ti
     }
     else if ((si = _find_inst_by_id(lsig, map->LID)) || (si = _reserved_inst(lsig, &map->LID))) {
         if (!si->active) {
-            si->active = 1;
-            _init_inst(si);
+            _activate_inst(lsig, si);
             i = _add_idmap(lsig, si, map);
             mpr_dev_LID_incref((mpr_local_dev)lsig->dev, map);
             mpr_dev_GID_incref((mpr_local_dev)lsig->dev, map);
@@ -499,17 +734,7 @@ int mpr_sig_get_idmap_with_GID(mpr_local_sig lsig, mpr_id GID, int flags, mpr_ti
         /* call instance event handler */
         h((mpr_sig)lsig, MPR_SIG_INST_OFLW, 0, 0, lsig->type, NULL, t);
     }
-    else if (lsig->steal_mode == MPR_STEAL_OLDEST) {
-        i = _oldest_inst(lsig);
-        if (i < 0)
-            return -1;
-        h((mpr_sig)lsig, MPR_SIG_REL_UPSTRM & lsig->event_flags ? MPR_SIG_REL_UPSTRM : MPR_SIG_UPDATE,
-          lsig->idmaps[i].map->LID, 0, lsig->type, 0, t);
-    }
-    else if (lsig->steal_mode == MPR_STEAL_NEWEST) {
-        i = _newest_inst(lsig);
-        if (i < 0)
-            return -1;
+    else if ((i = _steal_inst(lsig)) >= 0) {
         h((mpr_sig)lsig, MPR_SIG_REL_UPSTRM & lsig->event_flags ? MPR_SIG_REL_UPSTRM : MPR_SIG_UPDATE,
           lsig->idmaps[i].map->LID, 0, lsig->type, 0, t);
     }
@@ -521,8 +746,7 @@ int mpr_sig_get_idmap_with_GID(mpr_local_sig lsig, mpr_id GID, int flags, mpr_ti
         if ((si = _reserved_inst(lsig, NULL))) {
             map = mpr_dev_add_idmap((mpr_local_dev)lsig->dev, lsig->group, si->id, GID);
             map->GID_refcount = 1;
-            si->active = 1;
-            _init_inst(si);
+            _activate_inst(lsig, si);
             i = _add_idmap(lsig, si, map);
             if (h && (lsig->event_flags & MPR_SIG_INST_NEW))
                 h((mpr_sig)lsig, MPR_SIG_INST_NEW, si->id, 0, lsig->type, NULL, t);
@@ -533,8 +757,7 @@ int mpr_sig_get_idmap_with_GID(mpr_local_sig lsig, mpr_id GID, int flags, mpr_ti
         si = _find_inst_by_id(lsig, map->LID);
         TRACE_RETURN_UNLESS(si && !si->active, -1, "Signal %s has no instance %"
                             PR_MPR_ID" available.", lsig->name, map->LID);
-        si->active = 1;
-        _init_inst(si);
+        _activate_inst(lsig, si);
         i = _add_idmap(lsig, si, map);
         mpr_dev_LID_incref((mpr_local_dev)lsig->dev, map);
         mpr_dev_GID_incref((mpr_local_dev)lsig->dev, map);
@@ -545,9 +768,44 @@ int mpr_sig_get_idmap_with_GID(mpr_local_sig lsig, mpr_id GID, int flags, mpr_ti
     return -1;
 }
 
+/* Add a chunk holding as many instances as all previous chunks plus one, with the values and
+ * value flags of its instances stored after them. */
+static int _add_inst_chunk(mpr_local_sig lsig)
+{
+    int i, k = lsig->num_inst_chunks, size = 1 << k, first = size - 1;
+    int vec_bytes = mpr_sig_get_vector_bytes((mpr_sig)lsig), flag_bytes = lsig->len / 8 + 1;
+    mpr_sig_inst chunk;
+    char *vals, *flags;
+
+    chunk = calloc(1, (sizeof(mpr_sig_inst_t) + vec_bytes + flag_bytes) * size);
+    RETURN_ARG_UNLESS(chunk, 0);
+    vals = (char*)(chunk + size);
+    flags = vals + vec_bytes * size;
+    for (i = 0; i < size; i++) {
+        chunk[i].idx = first + i;
+        chunk[i].val = vals + vec_bytes * i;
+        chunk[i].has_val_flags = flags + flag_bytes * i;
+    }
+    lsig->inst_chunks = realloc(lsig->inst_chunks, sizeof(mpr_sig_inst) * (k + 1));
+    lsig->inst_chunks[k] = chunk;
+    ++lsig->num_inst_chunks;
+
+    /* index arrays cover every instance that fits in the chunks, the hash table needs a size
+     * that is a power of two */
+    size = first + size;
+    lsig->free_inst = realloc(lsig->free_inst, sizeof(int) * size);
+    lsig->inst_order = realloc(lsig->inst_order, sizeof(int) * size);
+    lsig->vacant_inst = realloc(lsig->vacant_inst, sizeof(int) * size);
+    lsig->inst_hash_size = (size + 1) * 2;
+    _rehash_insts(lsig);
+    return 1;
+}
+
 static int _reserve_inst(mpr_local_sig lsig, mpr_id *id, void *data)
 {
-    int i, cont;
+    int idx;
+    void *val;
+    char *has_val_flags;
     mpr_sig_inst si;
     RETURN_ARG_UNLESS(lsig->num_inst < MAX_INSTANCES, -1);
 
@@ -555,78 +813,81 @@ static int _reserve_inst(mpr_local_sig lsig, mpr_id *id, void *data)
     if (id && _find_inst_by_id(lsig, *id))
         return -1;
 
-    /* reallocate array of instances */
-    lsig->inst = realloc(lsig->inst, sizeof(mpr_sig_inst) * (lsig->num_inst + 1));
-    lsig->inst[lsig->num_inst] = (mpr_sig_inst) calloc(1, sizeof(struct _mpr_sig_inst));
-    si = lsig->inst[lsig->num_inst];
-    si->val = calloc(1, mpr_sig_get_vector_bytes((mpr_sig)lsig));
-    si->has_val_flags = calloc(1, lsig->len / 8 + 1);
-    si->has_val = 0;
+    /* reuse the index of a removed instance before adding new ones */
+    if (lsig->num_vacant_inst)
+        idx = lsig->vacant_inst[--lsig->num_vacant_inst];
+    else {
+        if (lsig->num_inst_idx == (1 << lsig->num_inst_chunks) - 1)
+            RETURN_ARG_UNLESS(_add_inst_chunk(lsig), -1);
+        idx = lsig->num_inst_idx++;
+    }
+    si = mpr_sig_get_inst_by_idx(lsig, idx);
+    val = si->val;
+    has_val_flags = si->has_val_flags;
+    memset(si, 0, sizeof(mpr_sig_inst_t));
+    si->idx = idx;
+    si->val = val;
+    si->has_val_flags = has_val_flags;
+    memset(si->val, 0, mpr_sig_get_vector_bytes((mpr_sig)lsig));
+    memset(si->has_val_flags, 0, lsig->len / 8 + 1);
+    ++lsig->num_inst;
 
     if (id)
         si->id = *id;
     else {
         /* find lowest unused id */
-        mpr_id lowest_id = 0;
-        cont = 1;
-        while (cont) {
-            cont = 0;
-            for (i = 0; i < lsig->num_inst; i++) {
-                if (lsig->inst[i]->id == lowest_id) {
-                    cont = 1;
-                    break;
-                }
-            }
-            lowest_id += cont;
-        }
-        si->id = lowest_id;
+        while (_find_inst_by_id(lsig, lsig->inst_id_hint))
+            ++lsig->inst_id_hint;
+        si->id = lsig->inst_id_hint++;
     }
-    si->idx = lsig->num_inst;
     _init_inst(si);
     si->data = data;
+    si->idmap_idx = -1;
 
-    ++lsig->num_inst;
-    qsort(lsig->inst, lsig->num_inst, sizeof(mpr_sig_inst), _compare_inst_ids);
-    return lsig->num_inst - 1;;
+    _hash_inst(lsig, si);
+    _order_inst(lsig, si, lsig->num_inst - 1);
+    _push_free_inst(lsig, si);
+    return idx;
 }
 
 int mpr_sig_reserve_inst(mpr_sig sig, int num, mpr_id *ids, void **data)
 {
-    int i = 0, count = 0, highest = -1, result, old_num = sig->num_inst;
+    int i = 0, count = 0, added = 0, old_num;
+    mpr_sig_inst si;
     mpr_local_sig lsig = (mpr_local_sig)sig;
     RETURN_ARG_UNLESS(sig && sig->is_local && num, 0);
+    old_num = lsig->num_inst_idx;
 
-    if (lsig->num_inst == 1 && !lsig->inst[0]->id && !lsig->inst[0]->data) {
+    si = lsig->num_inst == 1 ? mpr_sig_get_inst_by_idx(lsig, lsig->inst_order[0]) : 0;
+    if (si && !si->id && !si->data) {
         /* we will overwite the default instance first */
         if (ids)
-            lsig->inst[0]->id = ids[0];
+            _set_inst_id(lsig, si, ids[0]);
         if (data)
-            lsig->inst[0]->data = data[0];
+            si->data = data[0];
         ++i;
         ++count;
     }
     for (; i < num; i++) {
-        result = _reserve_inst(lsig, ids ? &ids[i] : 0, data ? data[i] : 0);
-        if (result == -1)
-            continue;
-        highest = result;
-        ++count;
+        if (_reserve_inst(lsig, ids ? &ids[i] : 0, data ? data[i] : 0) >= 0)
+            ++added;
     }
+    count += added;
     sig->use_inst = 1;
-    if (highest != -1)
-        mpr_rtr_num_inst_changed(lsig->obj.graph->net.rtr, lsig, highest + 1);
+    if (added)
+        mpr_rtr_num_inst_changed(lsig->obj.graph->net.rtr, lsig, lsig->num_inst_idx);
 
-    if (old_num > 0 && (lsig->num_inst / 8) == (old_num / 8))
+    if (old_num > 0 && (lsig->num_inst_idx / 8) == (old_num / 8))
         return count;
 
     /* reallocate instance update bitflags */
     if (!lsig->updated_inst)
-        lsig->updated_inst = calloc(1, lsig->num_inst / 8 + 1);
-    else if ((old_num / 8) == (lsig->num_inst / 8))
+        lsig->updated_inst = calloc(1, lsig->num_inst_idx / 8 + 1);
+    else if ((old_num / 8) == (lsig->num_inst_idx / 8))
         return count;
 
-    lsig->updated_inst = realloc(lsig->updated_inst, lsig->num_inst / 8 + 1);
-    memset(lsig->updated_inst + old_num / 8 + 1, 0, (lsig->num_inst / 8) - (old_num / 8));
+    lsig->updated_inst = realloc(lsig->updated_inst, lsig->num_inst_idx / 8 + 1);
+    memset(lsig->updated_inst + old_num / 8 + 1, 0, (lsig->num_inst_idx / 8) - (old_num / 8));
     return count;
 }
 
@@ -657,45 +918,49 @@ void mpr_sig_update_timing_stats(mpr_local_sig lsig, float diff)
     }
 }
 
-void mpr_sig_set_value(mpr_sig sig, mpr_id id, int len, mpr_type type, const void *val)
+static int _check_update(mpr_local_sig lsig, int len, mpr_type type)
 {
-    mpr_time time;
-    int idmap_idx;
-    mpr_local_sig lsig = (mpr_local_sig)sig;
-    mpr_sig_inst si;
-    RETURN_UNLESS(sig && sig->is_local);
-    if (!len || !val) {
-        mpr_sig_release_inst(sig, id);
-        return;
-    }
     if (!mpr_type_get_is_num(type)) {
 #ifdef DEBUG
         trace("called update on signal '%s' with non-number type '%c'\n", lsig->name, type);
 #endif
-        return;
+        return 1;
     }
     if (len && (len != lsig->len)) {
 #ifdef DEBUG
         trace("called update on signal '%s' with value length %d (should be %d)\n",
               lsig->name, len, lsig->len);
 #endif
-        return;
+        return 1;
     }
-    if (type != MPR_INT32) {
-        /* check for NaN */
-        int i;
-        if (type == MPR_FLT) {
-            for (i = 0; i < len; i++)
-                RETURN_UNLESS(((float*)val)[i] == ((float*)val)[i]);
+    return 0;
+}
+
+static int _has_nan(int len, mpr_type type, const void *val)
+{
+    int i;
+    if (type == MPR_FLT) {
+        for (i = 0; i < len; i++) {
+            if (((float*)val)[i] != ((float*)val)[i])
+                return 1;
         }
-        else if (type == MPR_DBL) {
-            for (i = 0; i < len; i++)
-                RETURN_UNLESS(((double*)val)[i] == ((double*)val)[i]);
+    }
+    else if (type == MPR_DBL) {
+        for (i = 0; i < len; i++) {
+            if (((double*)val)[i] != ((double*)val)[i])
+                return 1;
         }
     }
-    time = mpr_dev_get_time(sig->dev);
-    idmap_idx = mpr_sig_get_idmap_with_LID(lsig, id, 0, time, 1);
-    RETURN_UNLESS(idmap_idx >= 0);
+    return 0;
+}
+
+/* Store a new value for a signal instance, returning the index of its id map or -1. */
+static int _store_inst_value(mpr_local_sig lsig, mpr_id id, mpr_type type, const void *val,
+                             mpr_time time)
+{
+    mpr_sig_inst si;
+    int idmap_idx = mpr_sig_get_idmap_with_LID(lsig, id, 0, time, 1);
+    RETURN_ARG_UNLESS(idmap_idx >= 0, -1);
     si = lsig->idmaps[idmap_idx].inst;
 
     /* update time */
@@ -706,20 +971,180 @@ void mpr_sig_set_value(mpr_sig sig, mpr_id id, int len, mpr_type type, const voi
     if (type != lsig->type)
         set_coerced_val(lsig->len, type, val, lsig->len, lsig->type, si->val);
     else
-        memcpy(si->val, (void*)val, mpr_sig_get_vector_bytes(sig));
+        memcpy(si->val, (void*)val, mpr_sig_get_vector_bytes((mpr_sig)lsig));
     si->has_val = 1;
 
     /* mark instance as updated */
     set_bitflag(lsig->updated_inst, si->idx);
+    mpr_sig_touch_inst(lsig, si);
     ((mpr_local_dev)lsig->dev)->sending = lsig->updated = 1;
+    return idmap_idx;
+}
+
+static void _set_inst_value(mpr_local_sig lsig, mpr_rtr rtr, mpr_id id, mpr_type type,
+                            const void *val, mpr_time time)
+{
+    int idmap_idx = _store_inst_value(lsig, id, type, val, time);
+    if (idmap_idx >= 0)
+        mpr_rtr_process_sig(rtr, lsig, idmap_idx, lsig->idmaps[idmap_idx].inst->val, 0, time);
+}
+
+void mpr_sig_set_value(mpr_sig sig, mpr_id id, int len, mpr_type type, const void *val)
+{
+    mpr_local_sig lsig = (mpr_local_sig)sig;
+    RETURN_UNLESS(sig && sig->is_local);
+    if (!len || !val) {
+        mpr_sig_release_inst(sig, id);
+        return;
+    }
+    RETURN_UNLESS(!_check_update(lsig, len, type) && !_has_nan(len, type, val));
+    if (mpr_dev_off_poll_thread((mpr_local_dev)sig->dev)) {
+        /* hand the update over to the device's polling thread */
+        mpr_dev_hand_over_update((mpr_local_dev)sig->dev, lsig, id, len, type, val);
+        return;
+    }
+    _set_inst_value(lsig, sig->obj.graph->net.rtr, id, type, val, mpr_dev_get_time(sig->dev));
+}
+
+void mpr_sig_set_value_internal(mpr_local_sig lsig, mpr_id id, int len, mpr_type type,
+                                const void *val, mpr_time time)
+{
+    if (!len || !val) {
+        mpr_sig_release_inst((mpr_sig)lsig, id);
+        return;
+    }
+    RETURN_UNLESS(!_check_update(lsig, len, type) && !_has_nan(len, type, val));
+    _set_inst_value(lsig, lsig->obj.graph->net.rtr, id, type, val, time);
+}
+
+int mpr_sig_queue_value(mpr_sig sig, mpr_id id, int len, mpr_type type, const void *val,
+                        mpr_time time)
+{
+    RETURN_ARG_UNLESS(sig && sig->is_local, 1);
+    if (!len || !val)
+        len = 0;
+    else {
+        RETURN_ARG_UNLESS(mpr_type_get_is_num(type) && len == sig->len, 1);
+    }
+    return mpr_dev_queue_update((mpr_local_dev)sig->dev, (mpr_local_sig)sig, id, len, type, val,
+                                time, 0);
+}
+
+/* Batches up to this size keep their id map indices on the stack. */
+#define MAX_STACK_BATCH 256
 
-    mpr_rtr_process_sig(lsig->obj.graph->net.rtr, lsig, idmap_idx, si->has_val ? si->val : 0, si->time);
+void mpr_sig_set_values(mpr_sig sig, int num_inst, const mpr_id *ids, int len, mpr_type type,
+                        const void *vals)
+{
+    int i, stride, num_stored = 0, *idmap_idxs;
+    mpr_time time;
+    mpr_rtr rtr;
+    mpr_local_sig lsig = (mpr_local_sig)sig;
+    RETURN_UNLESS(sig && sig->is_local && num_inst > 0 && ids && len && vals);
+    RETURN_UNLESS(!_check_update(lsig, len, type));
+
+    stride = mpr_type_get_size(type) * len;
+    if (mpr_dev_off_poll_thread((mpr_local_dev)sig->dev)) {
+        for (i = 0; i < num_inst; i++) {
+            const void *val = (const char*)vals + i * stride;
+            if (!_has_nan(len, type, val))
+                mpr_dev_hand_over_update((mpr_local_dev)sig->dev, lsig, ids[i], len, type, val);
+        }
+        return;
+    }
+
+    /* all instances share one timestamp and router */
+    time = mpr_dev_get_time(sig->dev);
+    rtr = sig->obj.graph->net.rtr;
+    if (!lsig->use_inst) {
+        /* every id refers to the single instance, route each value in turn */
+        for (i = 0; i < num_inst; i++) {
+            const void *val = (const char*)vals + i * stride;
+            if (!_has_nan(len, type, val))
+                _set_inst_value(lsig, rtr, ids[i], type, val, time);
+        }
+        return;
+    }
+
+    /* store every value first, then route the batch in a single pass over the outgoing maps */
+    idmap_idxs = (num_inst <= MAX_STACK_BATCH ? alloca(sizeof(int) * num_inst)
+                  : malloc(sizeof(int) * num_inst));
+    for (i = 0; i < num_inst; i++) {
+        const void *val = (const char*)vals + i * stride;
+        int idmap_idx;
+        if (_has_nan(len, type, val))
+            continue;
+        if ((idmap_idx = _store_inst_value(lsig, ids[i], type, val, time)) >= 0)
+            idmap_idxs[num_stored++] = idmap_idx;
+    }
+    if (num_stored)
+        mpr_rtr_process_sig_insts(rtr, lsig, num_stored, idmap_idxs, time);
+    if (num_inst > MAX_STACK_BATCH)
+        free(idmap_idxs);
+}
+
+void mpr_sig_set_elements(mpr_sig sig, mpr_id id, int num, const int *indices, mpr_type type,
+                          const void *vals)
+{
+    int i, idmap_idx, size, val_size;
+    mpr_time time;
+    mpr_sig_inst si;
+    mpr_type *types;
+    mpr_local_sig lsig = (mpr_local_sig)sig;
+    RETURN_UNLESS(sig && sig->is_local && num > 0 && indices && vals);
+    RETURN_UNLESS(!_check_update(lsig, 0, type) && !_has_nan(num, type, vals));
+    for (i = 0; i < num; i++)
+        RETURN_UNLESS(indices[i] >= 0 && indices[i] < sig->len);
+    if (mpr_dev_off_poll_thread((mpr_local_dev)sig->dev)) {
+#ifdef DEBUG
+        trace("called mpr_sig_set_elements() on signal '%s' outside its polling thread\n",
+              sig->name);
+#endif
+        return;
+    }
+
+    time = mpr_dev_get_time(sig->dev);
+    idmap_idx = mpr_sig_get_idmap_with_LID(lsig, id, 0, time, 1);
+    RETURN_UNLESS(idmap_idx >= 0);
+    si = lsig->idmaps[idmap_idx].inst;
+
+    /* update time */
+    mpr_sig_update_timing_stats(lsig, si->has_val ? mpr_time_get_diff(time, si->time) : 0);
+    memcpy(&si->time, &time, sizeof(mpr_time));
+
+    /* update elements, marking the others as unchanged for the router */
+    size = mpr_type_get_size(sig->type);
+    val_size = mpr_type_get_size(type);
+    types = alloca(sig->len * sizeof(mpr_type));
+    memset(types, MPR_NULL, sig->len);
+    for (i = 0; i < num; i++) {
+        set_coerced_val(1, type, (const char*)vals + i * val_size, 1, sig->type,
+                        (char*)si->val + indices[i] * size);
+        set_bitflag(si->has_val_flags, indices[i]);
+        types[indices[i]] = sig->type;
+    }
+    if (!si->has_val && !compare_bitflags(si->has_val_flags, lsig->vec_known, sig->len))
+        si->has_val = 1;
+    /* nothing is sent until every element of the instance is known */
+    RETURN_UNLESS(si->has_val);
+
+    /* mark instance as updated */
+    set_bitflag(lsig->updated_inst, si->idx);
+    mpr_sig_touch_inst(lsig, si);
+    ((mpr_local_dev)sig->dev)->sending = lsig->updated = 1;
+
+    mpr_rtr_process_sig(sig->obj.graph->net.rtr, lsig, idmap_idx, si->val, types, si->time);
 }
 
 void mpr_sig_release_inst(mpr_sig sig, mpr_id id)
 {
     int idmap_idx;
     RETURN_UNLESS(sig && sig->is_local && sig->use_inst);
+    if (mpr_dev_off_poll_thread((mpr_local_dev)sig->dev)) {
+        mpr_dev_hand_over_update((mpr_local_dev)sig->dev, (mpr_local_sig)sig, id, 0, sig->type,
+                                 NULL);
+        return;
+    }
     idmap_idx = mpr_sig_get_idmap_with_LID((mpr_local_sig)sig, id, RELEASED_REMOTELY, MPR_NOW, 0);
     if (idmap_idx >= 0)
         mpr_sig_release_inst_internal((mpr_local_sig)sig, idmap_idx);
@@ -734,13 +1159,13 @@ void mpr_sig_release_inst_internal(mpr_local_sig lsig, int idmap_idx)
     set_bitflag(lsig->updated_inst, smap->inst->idx);
     ((mpr_local_dev)lsig->dev)->sending = lsig->updated = 1;
 
-    mpr_rtr_process_sig(lsig->obj.graph->net.rtr, lsig, idmap_idx, 0, smap->inst->time);
+    mpr_rtr_process_sig(lsig->obj.graph->net.rtr, lsig, idmap_idx, 0, 0, smap->inst->time);
 
     if (mpr_dev_LID_decref((mpr_local_dev)lsig->dev, lsig->group, smap->map))
-        smap->map = 0;
+        mpr_sig_clear_idmap(lsig, idmap_idx);
     else if ((lsig->dir & MPR_DIR_OUT) || smap->status & RELEASED_REMOTELY) {
         /* TODO: consider multiple upstream source instances? */
-        smap->map = 0;
+        mpr_sig_clear_idmap(lsig, idmap_idx);
     }
     else {
         /* mark map as locally-released but do not remove it */
@@ -748,45 +1173,44 @@ void mpr_sig_release_inst_internal(mpr_local_sig lsig, int idmap_idx)
     }
 
     /* Put instance back in reserve list */
-    smap->inst->active = 0;
+    mpr_sig_deactivate_inst(lsig, smap->inst);
     smap->inst = 0;
 }
 
 void mpr_sig_remove_inst(mpr_sig sig, mpr_id id)
 {
     int i, remove_idx;
+    mpr_sig_inst si;
     mpr_local_sig lsig = (mpr_local_sig)sig;
     RETURN_UNLESS(sig && sig->is_local && sig->use_inst);
-    for (i = 0; i < lsig->num_inst; i++) {
-        if (lsig->inst[i]->id == id)
-            break;
-    }
-    RETURN_UNLESS(i < lsig->num_inst);
+    si = _find_inst_by_id(lsig, id);
+    RETURN_UNLESS(si);
 
-    if (lsig->inst[i]->active) {
+    if (si->active && si->idmap_idx >= 0 && lsig->idmaps[si->idmap_idx].inst == si) {
        /* First release instance */
-       mpr_sig_release_inst_internal(lsig, i);
+       mpr_sig_release_inst_internal(lsig, si->idmap_idx);
     }
 
-    remove_idx = lsig->inst[i]->idx;
-
-    /* Free value and timetag memory held by instance */
-    FUNC_IF(free, lsig->inst[i]->val);
-    FUNC_IF(free, lsig->inst[i]->has_val_flags);
-    free(lsig->inst[i]);
-
-    for (++i; i < lsig->num_inst; i++)
-    lsig->inst[i-1] = lsig->inst[i];
+    remove_idx = si->idx;
+    if (id < lsig->inst_id_hint)
+        lsig->inst_id_hint = id;
+    mpr_sig_deactivate_inst(lsig, si);
+    _remove_free_inst(lsig, si);
+    _unorder_inst(lsig, si, lsig->num_inst);
+    _unhash_inst(lsig, si);
     --lsig->num_inst;
-    lsig->inst = realloc(lsig->inst, sizeof(mpr_sig_inst) * lsig->num_inst);
+    for (i = 0; i < lsig->idmap_len; i++) {
+        if (lsig->idmaps[i].inst == si)
+            lsig->idmaps[i].inst = 0;
+    }
 
-    /* Remove instance memory held by map slots */
-    mpr_rtr_remove_inst(lsig->obj.graph->net.rtr, lsig, remove_idx);
+    /* Other instances keep their indices, the vacant one is reused by the next reservation */
+    lsig->vacant_inst[lsig->num_vacant_inst++] = remove_idx;
+    if (lsig->updated_inst)
+        unset_bitflag(lsig->updated_inst, remove_idx);
 
-    for (i = 0; i < lsig->num_inst; i++) {
-        if (lsig->inst[i]->idx > remove_idx)
-            --lsig->inst[i]->idx;
-    }
+    /* Clear instance state held by map slots */
+    mpr_rtr_remove_inst(lsig->obj.graph->net.rtr, lsig, remove_idx);
 }
 
 const void *mpr_sig_get_value(mpr_sig sig, mpr_id id, mpr_time *time)
@@ -816,13 +1240,14 @@ const void *mpr_sig_get_value(mpr_sig sig, mpr_id id, mpr_time *time)
 int mpr_sig_get_num_inst(mpr_sig sig, mpr_status status)
 {
     int i, j;
+    mpr_local_sig lsig = (mpr_local_sig)sig;
     RETURN_ARG_UNLESS(sig && sig->is_local, 0);
     RETURN_ARG_UNLESS(sig->use_inst, 1);
     if ((status & (MPR_STATUS_ACTIVE | MPR_STATUS_RESERVED)) == (MPR_STATUS_ACTIVE | MPR_STATUS_RESERVED))
         return sig->num_inst;
     status = status & MPR_STATUS_ACTIVE ? 1 : 0;
     for (i = 0, j = 0; i < sig->num_inst; i++) {
-        if (((mpr_local_sig)sig)->inst[i]->active == status)
+        if (mpr_sig_get_inst_by_idx(lsig, lsig->inst_order[i])->active == status)
             ++j;
     }
     return j;
@@ -835,13 +1260,14 @@ mpr_id mpr_sig_get_inst_id(mpr_sig sig, int idx, mpr_status status)
     RETURN_ARG_UNLESS(sig && sig->is_local && sig->use_inst, 0);
     RETURN_ARG_UNLESS(idx >= 0 && idx < sig->num_inst, 0);
     if ((status & (MPR_STATUS_ACTIVE | MPR_STATUS_RESERVED)) == (MPR_STATUS_ACTIVE | MPR_STATUS_RESERVED))
-        return lsig->inst[idx]->id;
+        return mpr_sig_get_inst_by_idx(lsig, lsig->inst_order[idx])->id;
     status = status & MPR_STATUS_ACTIVE ? 1 : 0;
     for (i = 0, j = -1; i < lsig->num_inst; i++) {
-        if (lsig->inst[i]->active != status)
+        mpr_sig_inst si = mpr_sig_get_inst_by_idx(lsig, lsig->inst_order[i]);
+        if (si->active != status)
             continue;
         if (++j == idx)
-            return lsig->inst[i]->id;
+            return si->id;
     }
     return 0;
 }
@@ -933,12 +1359,43 @@ static int cmp_qry_sig_maps(const void *context_data, mpr_map map)
     return 0;
 }
 
+/* A map could use the same signal as both source and destination, so it is only returned for
+ * the first of its slots using the signal. */
+static mpr_slot first_sig_slot(mpr_map map, mpr_sig sig)
+{
+    int i;
+    if (map->dst->sig == sig)
+        return map->dst;
+    for (i = 0; i < map->num_src; i++) {
+        if (map->src[i]->sig == sig)
+            return map->src[i];
+    }
+    return 0;
+}
+
+static mpr_map next_sig_map(const void *context_data, mpr_map map)
+{
+    mpr_sig sig = *(mpr_sig*)context_data;
+    mpr_slot slot;
+    if (map) {
+        RETURN_ARG_UNLESS(slot = first_sig_slot(map, sig), 0);
+        slot = slot->next_sig_slot;
+    }
+    else
+        slot = sig->slots;
+    for (; slot; slot = slot->next_sig_slot) {
+        if (slot == first_sig_slot(slot->map, sig))
+            return slot->map;
+    }
+    return 0;
+}
+
 mpr_list mpr_sig_get_maps(mpr_sig sig, mpr_dir dir)
 {
     mpr_list q;
-    RETURN_ARG_UNLESS(sig && sig->obj.graph->maps, 0);
-    q = mpr_list_new_query((const void**)&sig->obj.graph->maps, (void*)cmp_qry_sig_maps,
-                           "vi", &sig, dir);
+    RETURN_ARG_UNLESS(sig && sig->slots && sig->obj.graph->maps, 0);
+    q = mpr_list_new_query_from((const void**)&sig->obj.graph->maps, (void*)next_sig_map,
+                                (void*)cmp_qry_sig_maps, "vi", &sig, dir);
     return mpr_list_start(q);
 }
 
@@ -946,7 +1403,7 @@ static int _add_idmap(mpr_local_sig lsig, mpr_sig_inst si, mpr_id_map map)
 {
     /* find unused signal map */
     int i;
-    for (i = 0; i < lsig->idmap_len; i++) {
+    for (i = lsig->idmap_free_hint; i < lsig->idmap_len; i++) {
         if (!lsig->idmaps[i].map)
             break;
     }
@@ -964,6 +1421,12 @@ static int _add_idmap(mpr_local_sig lsig, mpr_sig_inst si, mpr_id_map map)
     lsig->idmaps[i].map = map;
     lsig->idmaps[i].inst = si;
     lsig->idmaps[i].status = 0;
+    lsig->idmap_free_hint = i + 1;
+    si->idmap_idx = i;
+    if (lsig->idmap_hash_size < lsig->idmap_len * 2)
+        _rehash_idmaps(lsig);
+    else
+        _idx_tbl_add(lsig->idmap_hash, lsig->idmap_hash_size, map->GID, i);
     return i;
 }
 
@@ -1017,6 +1480,8 @@ int mpr_sig_set_from_msg(mpr_sig sig, mpr_msg msg)
         a = &msg->atoms[i];
         if (sig->is_local && (MASK_PROP_BITFLAGS(a->prop) != PROP(EXTRA)))
             continue;
+        if (!sig->is_local && !mpr_graph_keeps_sig_prop(sig->obj.graph, a->prop, a->key))
+            continue;
         switch (a->prop) {
             case PROP(DIR): {
                 int dir = 0;
@@ -1049,6 +1514,8 @@ int mpr_sig_set_from_msg(mpr_sig sig, mpr_msg msg)
                     stl = MPR_STEAL_OLDEST;
                 else if (strcmp(&(*a->vals)->s, "newest")==0)
                     stl = MPR_STEAL_NEWEST;
+                else if (strcmp(&(*a->vals)->s, "least_recent")==0)
+                    stl = MPR_STEAL_LEAST_RECENT;
                 else
                     break;
                 updated += mpr_tbl_set(tbl, PROP(STEAL_MODE), NULL, 1,
@@ -1060,5 +1527,7 @@ int mpr_sig_set_from_msg(mpr_sig sig, mpr_msg msg)
                 break;
         }
     }
+    if (updated)
+        mpr_graph_reindex_obj(sig->obj.graph, (mpr_obj)sig);
     return updated;
 }
@@ -18,6 +18,10 @@ mpr_slot mpr_slot_new(mpr_map map, mpr_sig sig, unsigned char is_local, unsigned
     slot->is_local = is_local;
     slot->dir = (is_src == sig->is_local) ? MPR_DIR_OUT : MPR_DIR_IN;
     slot->causes_update = 1; /* default */
+
+    /* add to the signal's list of slots */
+    slot->next_sig_slot = sig->slots;
+    sig->slots = slot;
     return slot;
 }
 
@@ -28,6 +32,14 @@ static int slot_mask(mpr_slot slot)
 
 void mpr_slot_free(mpr_slot slot)
 {
+    mpr_slot *ptr = slot->sig ? &slot->sig->slots : 0;
+    while (ptr && *ptr) {
+        if (*ptr == slot) {
+            *ptr = slot->next_sig_slot;
+            break;
+        }
+        ptr = &(*ptr)->next_sig_slot;
+    }
     free(slot);
 }
 
@@ -35,6 +47,9 @@ void mpr_slot_free_value(mpr_local_slot slot)
 {
     /* TODO: use rtr_sig for holding memory of local slots for effiency */
     mpr_value_free(&slot->val);
+    FUNC_IF(free, slot->pending_inst);
+    slot->pending_inst = 0;
+    slot->pending_size = 0;
 }
 
 int mpr_slot_set_from_msg(mpr_slot slot, mpr_msg msg)
@@ -127,7 +142,7 @@ void mpr_slot_alloc_values(mpr_local_slot slot, int num_inst, int hist_size)
 {
     RETURN_UNLESS(num_inst && hist_size && slot->sig->type && slot->sig->len);
     if (slot->sig->is_local)
-        num_inst = slot->sig->num_inst;
+        num_inst = mpr_sig_get_num_inst_idx(slot->sig);
 
     /* reallocate memory */
     mpr_value_realloc(&slot->val, slot->sig->len, slot->sig->type,
@@ -136,9 +151,28 @@ void mpr_slot_alloc_values(mpr_local_slot slot, int num_inst, int hist_size)
     slot->num_inst = num_inst;
 }
 
-void mpr_slot_remove_inst(mpr_local_slot slot, int idx)
+void mpr_slot_alloc_pending(mpr_local_slot slot, int num_inst)
+{
+    int size;
+    if (!num_inst) {
+        FUNC_IF(free, slot->pending_inst);
+        slot->pending_inst = 0;
+        slot->pending_size = 0;
+        return;
+    }
+    size = num_inst / 8 + 1;
+    RETURN_UNLESS(size > slot->pending_size);
+    /* keep any updates that are still waiting to be sent */
+    slot->pending_inst = realloc(slot->pending_inst, size);
+    memset(slot->pending_inst + slot->pending_size, 0, size - slot->pending_size);
+    slot->pending_size = size;
+}
+
+void mpr_slot_clear_inst(mpr_local_slot slot, int idx)
 {
-    RETURN_UNLESS(slot && idx >= 0 && idx < slot->num_inst);
-    /* TODO: remove slot->num_inst property */
-    slot->num_inst = mpr_value_remove_inst(&slot->val, idx);
+    RETURN_UNLESS(slot && idx >= 0);
+    if (idx < slot->num_inst)
+        mpr_value_reset_inst(&slot->val, idx);
+    if (idx / 8 < slot->pending_size)
+        unset_bitflag(slot->pending_inst, idx);
 }
@@ -1,10 +1,119 @@
 
+#include <stddef.h>
 #include <stdlib.h>
 #include <stdio.h>
 #include <string.h>
 
 #include "mapper_internal.h"
 
+#define KEY_POOL_INIT_SIZE 32
+
+MPR_INLINE static uint32_t hash_key(const char *str)
+{
+    /* FNV-1a */
+    uint32_t hash = 2166136261u;
+    while (*str) {
+        hash ^= (uint8_t)*str++;
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+/* Return the pooled copy of a key, adding it to the pool if necessary. */
+static const char *intern_key(mpr_key_pool pool, const char *str)
+{
+    int i;
+    size_t len;
+    uint32_t hash = hash_key(str);
+    mpr_interned_key key;
+
+    if (pool->size) {
+        key = pool->buckets[hash & (pool->size - 1)];
+        while (key) {
+            if (key->hash == hash && !strcmp(key->str, str)) {
+                ++key->refcount;
+                return key->str;
+            }
+            key = key->next;
+        }
+    }
+
+    if (pool->count >= pool->size) {
+        /* double the number of buckets and rehash */
+        int size = pool->size ? pool->size * 2 : KEY_POOL_INIT_SIZE;
+        mpr_interned_key *buckets = (mpr_interned_key*)calloc(1, size * sizeof(mpr_interned_key));
+        RETURN_ARG_UNLESS(buckets, 0);
+        for (i = 0; i < pool->size; i++) {
+            while ((key = pool->buckets[i])) {
+                pool->buckets[i] = key->next;
+                key->next = buckets[key->hash & (size - 1)];
+                buckets[key->hash & (size - 1)] = key;
+            }
+        }
+        FUNC_IF(free, pool->buckets);
+        pool->buckets = buckets;
+        pool->size = size;
+    }
+
+    len = strlen(str);
+    key = (mpr_interned_key)malloc(sizeof(mpr_interned_key_t) + len);
+    RETURN_ARG_UNLESS(key, 0);
+    memcpy(key->str, str, len + 1);
+    key->hash = hash;
+    key->refcount = 1;
+    i = hash & (pool->size - 1);
+    key->next = pool->buckets[i];
+    pool->buckets[i] = key;
+    ++pool->count;
+    return key->str;
+}
+
+static void release_key(mpr_key_pool pool, const char *str)
+{
+    mpr_interned_key key, *ptr;
+    RETURN_UNLESS(str);
+    key = (mpr_interned_key)(str - offsetof(mpr_interned_key_t, str));
+    RETURN_UNLESS(--key->refcount <= 0);
+    ptr = &pool->buckets[key->hash & (pool->size - 1)];
+    while (*ptr && *ptr != key)
+        ptr = &(*ptr)->next;
+    if (*ptr)
+        *ptr = key->next;
+    --pool->count;
+    free(key);
+}
+
+void mpr_key_pool_free(mpr_key_pool pool)
+{
+    int i;
+    for (i = 0; i < pool->size; i++) {
+        while (pool->buckets[i]) {
+            mpr_interned_key key = pool->buckets[i];
+            pool->buckets[i] = key->next;
+            free(key);
+        }
+    }
+    FUNC_IF(free, pool->buckets);
+    pool->buckets = 0;
+    pool->size = pool->count = 0;
+}
+
+MPR_INLINE static int count_bits(uint64_t bits)
+{
+#ifdef __GNUC__
+    return __builtin_popcountll(bits);
+#else
+    int count = 0;
+    for (; bits; count++)
+        bits &= bits - 1;
+    return count;
+#endif
+}
+
+/* Built-in properties are numbered in steps of 0x100 from MPR_PROP_UNKNOWN up to
+ * MPR_PROP_EXTRA, so each of them has one bit in mpr_tbl_t.slots. */
+#define SLOT_BIT(PROP) ((uint64_t)1 << (MASK_PROP_BITFLAGS(PROP) >> 8))
+
 /* we will sort so that indexed records come before keyed records */
 static int compare_rec(const void *l, const void *r)
 {
@@ -14,6 +123,8 @@ static int compare_rec(const void *l, const void *r)
     int idx_r = MASK_PROP_BITFLAGS(rec_r->prop);
     if ((idx_l == MPR_PROP_EXTRA) && (idx_r == MPR_PROP_EXTRA)) {
         const char *str_l = rec_l->key, *str_r = rec_r->key;
+        if (str_l == str_r)
+            return 0;
         if (str_l[0] == '@')
             ++str_l;
         if (str_r[0] == '@')
@@ -27,10 +138,11 @@ static int compare_rec(const void *l, const void *r)
     return idx_l - idx_r;
 }
 
-mpr_tbl mpr_tbl_new()
+mpr_tbl mpr_tbl_new(mpr_key_pool keys)
 {
     mpr_tbl t = (mpr_tbl)calloc(1, sizeof(mpr_tbl_t));
     RETURN_ARG_UNLESS(t, 0);
+    t->keys = keys;
     t->count = 0;
     t->alloced = 1;
     t->rec = (mpr_tbl_record)calloc(1, sizeof(mpr_tbl_record_t));
@@ -44,8 +156,7 @@ void mpr_tbl_clear(mpr_tbl t)
         mpr_tbl_record rec = &t->rec[i];
         if (!(rec->flags & PROP_OWNED))
             continue;
-        if (rec->key)
-            free((char*)rec->key);
+        release_key(t->keys, rec->key);
         if (free_vals && rec->val) {
             void *val = (rec->flags & INDIRECT) ? *rec->val : rec->val;
             if (val) {
@@ -65,6 +176,7 @@ void mpr_tbl_clear(mpr_tbl t)
         }
     }
     t->count = 0;
+    t->slots = 0;
     t->rec = realloc(t->rec, sizeof(mpr_tbl_record_t));
     t->alloced = 1;
 }
@@ -89,7 +201,9 @@ static mpr_tbl_record mpr_tbl_add(mpr_tbl t, mpr_prop prop, const char *key,
     rec = &t->rec[t->count-1];
     if (MPR_PROP_EXTRA == prop)
         flags |= MODIFIABLE;
-    rec->key = key ? strdup(key) : 0;
+    rec->key = key ? intern_key(t->keys, key) : 0;
+    if (MASK_PROP_BITFLAGS(prop) < MPR_PROP_EXTRA)
+        t->slots |= SLOT_BIT(prop);
     rec->prop = prop;
     rec->len = len;
     rec->type = type;
@@ -116,12 +230,20 @@ int mpr_tbl_get_size(mpr_tbl t)
 mpr_tbl_record mpr_tbl_get(mpr_tbl t, mpr_prop prop, const char *key)
 {
     mpr_tbl_record_t tmp;
-    mpr_tbl_record rec = 0;
+    int num_slots;
     RETURN_ARG_UNLESS(key || (MPR_PROP_UNKNOWN != prop && MPR_PROP_EXTRA != prop), 0);
+    if (MASK_PROP_BITFLAGS(prop) < MPR_PROP_EXTRA) {
+        /* built-in properties are found directly from the slot bits */
+        uint64_t bit = SLOT_BIT(prop);
+        RETURN_ARG_UNLESS(t->slots & bit, 0);
+        return &t->rec[count_bits(t->slots & (bit - 1))];
+    }
+    /* only search the records of extra properties */
+    num_slots = count_bits(t->slots);
     tmp.prop = prop;
     tmp.key = key;
-    rec = bsearch(&tmp, t->rec, t->count, sizeof(mpr_tbl_record_t), compare_rec);
-    return rec;
+    return bsearch(&tmp, t->rec + num_slots, t->count - num_slots, sizeof(mpr_tbl_record_t),
+                   compare_rec);
 }
 
 mpr_prop mpr_tbl_get_prop_by_key(mpr_tbl t, const char *key, int *len, mpr_type *type,
@@ -246,7 +368,7 @@ void mpr_tbl_clear_empty(mpr_tbl t)
         rec->prop &= ~PROP_REMOVE;
         if (MASK_PROP_BITFLAGS(rec->prop) != MPR_PROP_EXTRA)
             continue;
-        free((char*)rec->key);
+        release_key(t->keys, rec->key);
         for (j = rec - t->rec + 1; j < t->count; j++)
             t->rec[j-1] = t->rec[j];
         --t->count;
@@ -539,6 +661,9 @@ static void mpr_record_add_to_msg(mpr_tbl_record rec, lo_message msg)
         case MPR_PROP_STEAL_MODE:
             lo_message_add_string(msg, mpr_steal_as_str(*(int*)rec->val));
             break;
+        case MPR_PROP_COALESCE:
+            lo_message_add_string(msg, mpr_coalesce_as_str(*(int*)rec->val));
+            break;
         case MPR_PROP_DEV:
         case MPR_PROP_SIG:
         case MPR_PROP_SLOT:
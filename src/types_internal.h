@@ -70,9 +70,27 @@ typedef struct {
     char flags;
 } mpr_tbl_record_t, *mpr_tbl_record;
 
-/*! Used to hold look-up tables. */
+/*! A property key interned in a graph's key pool, shared by all records using it. */
+typedef struct _mpr_interned_key {
+    struct _mpr_interned_key *next;
+    uint32_t hash;
+    int refcount;
+    char str[1];                    /*!< The key itself, allocated along with the entry. */
+} mpr_interned_key_t, *mpr_interned_key;
+
+/*! A graph-wide hash set of interned property keys. */
+typedef struct _mpr_key_pool {
+    mpr_interned_key *buckets;
+    int size;                       /*!< Number of buckets, always a power of two. */
+    int count;                      /*!< Number of interned keys. */
+} mpr_key_pool_t, *mpr_key_pool;
+
+/*! Used to hold look-up tables. Records of built-in properties are kept sorted before those of
+ *  extra properties, so their position follows directly from the bits set in slots. */
 typedef struct _mpr_tbl {
     mpr_tbl_record rec;
+    mpr_key_pool keys;              /*!< Pool used to intern the keys of extra properties. */
+    uint64_t slots;                 /*!< One bit per built-in property present in the table. */
     int count;
     int alloced;
     char dirty;
@@ -216,8 +234,24 @@ typedef struct _mpr_subscriber {
     lo_address addr;
     uint32_t lease_exp;
     int flags;
+    int num_renewals;
 } *mpr_subscriber;
 
+#define MAX_TOMBSTONES 256          /* removals kept per device for catching up */
+#define FULL_SYNC_RENEWALS 10       /* lease renewals between full resyncs of a subscriber */
+
+/*! A removed signal or map of a local device, kept so that subscribers catching up from an
+ *  earlier version can be told about the removal. */
+typedef struct _mpr_tombstone {
+    struct _mpr_tombstone *next;    /*!< The next older tombstone. */
+    int version;                    /*!< Version stamped on the removal. */
+    int flags;                      /*!< Subscription flag covering the removed object. */
+    net_msg_t cmd;                  /*!< MSG_SIG_REM or MSG_UNMAPPED. */
+    mpr_id id;                      /*!< Id of a removed map. */
+    int num_names;
+    char names[1];                  /*!< Signal names of the message, each null-terminated. */
+} mpr_tombstone_t, *mpr_tombstone;
+
 #define TIMEOUT_SEC 10              /* timeout after 10 seconds without ping */
 
 /**** Object ****/
@@ -230,8 +264,60 @@ typedef struct _mpr_obj
     struct _mpr_dict props;         /*!< Properties associated with this signal. */
     int version;                    /*!< Version number. */
     mpr_type type;                  /*!< Object type. */
+
+    /*! Links in the graph's hash indices, by id [0] and by name [1]. */
+    struct {
+        struct _mpr_obj *next;      /*!< Next object in the same bucket. */
+        uint32_t hash;              /*!< Hash of the key the object is indexed under. */
+        uint8_t indexed;            /*!< 1 if the object is currently in the index. */
+    } idx[2];
 } mpr_obj_t, *mpr_obj;
 
+/*! A hash index of graph objects chained through mpr_obj_t.idx, so that adding an object to
+ *  an index never allocates. */
+typedef struct _mpr_graph_idx {
+    mpr_obj *buckets;
+    int size;                       /*!< Number of buckets, always a power of two. */
+    int count;                      /*!< Number of indexed objects. */
+} mpr_graph_idx_t, *mpr_graph_idx;
+
+/*! An entry of a property index, hashed both by property value and by object. */
+typedef struct _mpr_prop_idx_entry {
+    struct _mpr_prop_idx_entry *next_by_val;
+    struct _mpr_prop_idx_entry *next_by_obj;
+    mpr_obj obj;
+    uint32_t hash;                  /*!< Hash of the property value. */
+    int sorted_pos;                 /*!< Position in the sorted array, or -1 if not numeric. */
+    double num;                     /*!< The property value if it is a single number. */
+} mpr_prop_idx_entry_t, *mpr_prop_idx_entry;
+
+/*! A secondary index of graph objects by the value of one of their properties, used by
+ *  mpr_list_filter(). Equality is served from the value hash, and ranges of single numbers from
+ *  an array sorted lazily after changes. */
+typedef struct _mpr_prop_idx {
+    struct _mpr_prop_idx *next;
+    char *key;                      /*!< Property key, or zero if indexed by prop. */
+    mpr_prop prop;
+    int obj_type;
+    mpr_prop_idx_entry *by_val;
+    mpr_prop_idx_entry *by_obj;
+    int size;                       /*!< Number of buckets, always a power of two. */
+    int count;                      /*!< Number of indexed objects. */
+    mpr_prop_idx_entry *sorted;     /*!< Entries with numeric values, sorted by value. */
+    int num_sorted;
+    int sorted_dirty;
+} mpr_prop_idx_t, *mpr_prop_idx;
+
+/*! A slab pool of graph objects of one size, see mpr_list_add_item(). */
+typedef struct _mpr_pool {
+    struct _mpr_pool *next;
+    void *chunks;                   /*!< Allocated chunks, linked through their first word. */
+    void *free_items;               /*!< Released items, linked through their first word. */
+    size_t item_size;
+    int chunk_len;                  /*!< Number of items in the newest chunk. */
+    int num_unused;                 /*!< Items never handed out at the end of the newest chunk. */
+} mpr_pool_t, *mpr_pool;
+
 typedef struct _mpr_graph {
     mpr_obj_t obj;                  /* always first */
     mpr_net_t net;
@@ -241,6 +327,24 @@ typedef struct _mpr_graph {
     mpr_list links;                 /*!< List of links. */
     fptr_list callbacks;            /*!< List of object record callbacks. */
 
+    mpr_graph_idx_t devs_by_id;     /*!< Hash index of devices by id. */
+    mpr_graph_idx_t devs_by_name;   /*!< Hash index of devices by name. */
+    mpr_graph_idx_t sigs_by_id;     /*!< Hash index of signals by id. */
+    mpr_graph_idx_t sigs_by_name;   /*!< Hash index of signals by device and name. */
+    mpr_graph_idx_t maps_by_id;     /*!< Hash index of maps by id. */
+    mpr_prop_idx prop_idxs;         /*!< Secondary indices of property values. */
+    mpr_key_pool_t keys;            /*!< Interned keys of extra properties. */
+    mpr_pool pools;                 /*!< Slab pools of devices, signals, maps and links. */
+    int local_version;              /*!< Last version stamped on a change to a local object. */
+
+    uint64_t sig_props;             /*!< Bitflags of the remote signal properties to keep. */
+    char **sig_keys;                /*!< Names of the extra remote signal properties to keep. */
+    int num_sig_keys;
+    int max_sigs;                   /*!< Maximum number of remote signals, or 0 for no limit. */
+    int num_remote_sigs;
+    struct _mpr_sig *lru_oldest;    /*!< Remote signal updated least recently. */
+    struct _mpr_sig *lru_newest;    /*!< Remote signal updated most recently. */
+
     /*! Linked-list of autorenewing device subscriptions. */
     mpr_subscription subscriptions;
 
@@ -252,6 +356,7 @@ typedef struct _mpr_graph {
     int staged_maps;
 
     uint32_t resource_counter;
+    uint32_t version;               /*!< Incremented on changes, invalidates cached lists. */
 } mpr_graph_t, *mpr_graph;
 
 /**** Signal ****/
@@ -272,8 +377,8 @@ typedef struct _mpr_value
 {
     mpr_value_buffer inst;      /*!< Array of value histories for each signal instance. */
     int vlen;                   /*!< Vector length. */
-    uint8_t num_inst;           /*!< Number of instances. */
-    uint8_t num_active_inst;    /*!< Number of active instances. */
+    int num_inst;               /*!< Number of instances. */
+    int num_active_inst;        /*!< Number of active instances. */
     mpr_type type;              /*!< The type of this signal. */
     int8_t mlen;                /*!< History size of the buffer. */
 } mpr_value_t, *mpr_value;
@@ -289,6 +394,13 @@ typedef struct _mpr_value
 #define EXPR_UPDATE                0x10
 #define EXPR_EVAL_DONE             0x20
 
+/* Orderings of active signal instances, used to choose an instance to steal. */
+enum {
+    INST_BY_ACTIVATION,
+    INST_BY_UPDATE,
+    NUM_INST_ORDERS
+};
+
 /*! A signal is defined as a vector of values, along with some metadata. */
 /* plan: remove idx? we shouldn't need it anymore */
 typedef struct _mpr_sig_inst
@@ -301,7 +413,11 @@ typedef struct _mpr_sig_inst
     void *val;                  /*!< The current value of this signal instance. */
     mpr_time time;              /*!< The time associated with the current value. */
 
-    uint8_t idx;                /*!< Index for accessing value history. */
+    int idx;                    /*!< Index in the signal's instance chunks and value history. */
+    int idmap_idx;              /*!< Index of the associated idmap if active. */
+    int free_pos;               /*!< Position in the signal's free list, or -1 if active. */
+    int prev[NUM_INST_ORDERS];  /*!< Previous active instance index in each ordering. */
+    int next[NUM_INST_ORDERS];  /*!< Next active instance index in each ordering. */
     uint8_t has_val;            /*!< Indicates whether this instance has a value. */
     uint8_t active;             /*!< Status of this instance. */
 } mpr_sig_inst_t, *mpr_sig_inst;
@@ -332,6 +448,8 @@ typedef struct _mpr_sig_idmap
     int num_maps_out;           /* TODO: use dynamic query instead? */                  \
     mpr_steal_type steal_mode;  /*!< Type of voice stealing to perform. */              \
     mpr_type type;              /*!< The type of this signal. */                        \
+    struct _mpr_sig *next_dev_sig; /*!< Next signal of the same device. */              \
+    struct _mpr_slot *slots;    /*!< Map slots using this signal. */                    \
     int is_local;
 
 /*! A record that describes properties of a signal. */
@@ -339,6 +457,8 @@ typedef struct _mpr_sig
 {
     MPR_SIG_STRUCT_ITEMS
     mpr_dev dev;
+    struct _mpr_sig *lru_prev;  /*!< Remote signal updated before this one. */
+    struct _mpr_sig *lru_next;  /*!< Remote signal updated after this one. */
 } mpr_sig_t, *mpr_sig;
 
 typedef struct _mpr_local_sig
@@ -348,7 +468,26 @@ typedef struct _mpr_local_sig
 
     struct _mpr_sig_idmap *idmaps;  /*!< ID maps and active instances. */
     int idmap_len;
-    struct _mpr_sig_inst **inst;    /*!< Array of pointers to the signal insts. */
+    int *idmap_hash;                /*!< Open-addressed table of id map indices by GID. */
+    int idmap_hash_size;
+    int idmap_free_hint;            /*!< All id maps below this index are in use. */
+    /* Instances are stored in chunks of doubling size, chunk k holding instance indices
+     * 2^k-1 to 2^(k+1)-2 followed by their values and value flags, so that instances never
+     * move once reserved.  Indices of removed instances are kept for reuse. */
+    struct _mpr_sig_inst **inst_chunks;
+    int num_inst_chunks;
+    int num_inst_idx;               /*!< Number of instance indices in use or vacant. */
+    int *vacant_inst;               /*!< Stack of indices left by removed instances. */
+    int num_vacant_inst;
+
+    int *inst_order;                /*!< Instance indices sorted by id. */
+    int *free_inst;                 /*!< Min-heap of inactive instance indices by id. */
+    int num_free_inst;
+    int *inst_hash;                 /*!< Open-addressed table of instance indices by id. */
+    int inst_hash_size;
+    mpr_id inst_id_hint;            /*!< All instance ids below this value are in use. */
+    int inst_oldest[NUM_INST_ORDERS];   /*!< First active instance index in each ordering. */
+    int inst_newest[NUM_INST_ORDERS];   /*!< Last active instance index in each ordering. */
     char *vec_known;                /*!< Bitflags when entire vector is known. */
     char *updated_inst;             /*!< Bitflags to indicate updated instances. */
 
@@ -359,6 +498,7 @@ typedef struct _mpr_local_sig
                                      *  instance event handler. */
 
     mpr_sig_group group;            /* TODO: replace with hierarchical instancing */
+    struct _mpr_rtr_sig *rsig;      /*!< Router entry for this signal, if mapped. */
     uint8_t locked;
     uint8_t updated;                /* TODO: fold into updated_inst bitflags. */
 } mpr_local_sig_t, *mpr_local_sig;
@@ -377,6 +517,7 @@ typedef struct _mpr_bundle {
 typedef struct _mpr_link {
     mpr_obj_t obj;                  /* always first */
     mpr_dev devs[2];
+    struct _mpr_link *next_dev_link[2]; /*!< Next link involving each device. */
     int *num_maps;
 
     struct {
@@ -388,8 +529,28 @@ typedef struct _mpr_link {
     mpr_bundle_t bundles[NUM_BUNDLES];  /*!< Circular buffer to handle interrupts during poll() */
 
     mpr_sync_clock_t clock;
+    uint8_t compact;                    /*!< 1 if peer accepts compact signal updates. */
 } mpr_link_t, *mpr_link;
 
+/*! Header for compact signal updates, which are sent as a single OSC blob containing this
+ *  header followed by the packed vector value in the byte order of the sender.  Sparse updates
+ *  pack only the changed elements, followed by their indices as 16-bit integers. */
+typedef struct _mpr_compact_hdr {
+    uint8_t flags;                      /*!< Combination of MPR_COMPACT_* flags. */
+    char type;                          /*!< Type of the vector elements. */
+    uint16_t len;                       /*!< Number of vector elements. */
+    int32_t slot;                       /*!< Map slot id, if MPR_COMPACT_HAS_SLOT. */
+    int64_t GID;                        /*!< Instance id, if MPR_COMPACT_HAS_INST. */
+} mpr_compact_hdr_t;
+
+#define MPR_COMPACT_HAS_INST    0x01
+#define MPR_COMPACT_HAS_SLOT    0x02
+#define MPR_COMPACT_BIG_ENDIAN  0x04
+#define MPR_COMPACT_SPARSE      0x08
+
+/* Longest vector that fits the 16-bit length and indices, longer vectors are sent as plain OSC. */
+#define MPR_COMPACT_MAX_LEN     0xFFFF
+
 /**** Maps and Slots ****/
 
 #define MAX_NUM_MAP_SRC     8       /* arbitrary */
@@ -399,10 +560,11 @@ typedef struct _mpr_link {
     mpr_sig sig;                    /*!< Pointer to parent signal */            \
     mpr_link link;                                                              \
     int id;                                                                     \
-    uint8_t num_inst;                                                           \
+    int num_inst;                                                               \
     char dir;                       /*!< DI_INCOMING or DI_OUTGOING */          \
     char causes_update;             /*!< 1 if causes update, 0 otherwise. */    \
     char is_local;                                                              \
+    struct _mpr_slot *next_sig_slot; /*!< Next slot using the signal. */        \
 
 typedef struct _mpr_slot {
     MPR_SLOT_STRUCT_ITEMS
@@ -416,6 +578,8 @@ typedef struct _mpr_local_slot {
     /* each slot can point to local signal or a remote link structure */
     struct _mpr_rtr_sig *rsig;      /*!< Parent signal if local */
     mpr_value_t val;                /*!< Value histories for each signal instance. */
+    char *pending_inst;             /*!< Bitflags for coalesced instance updates. */
+    int pending_size;               /*!< Allocated size of pending_inst in bytes. */
     char status;
 } mpr_local_slot_t, *mpr_local_slot;
 
@@ -430,6 +594,10 @@ typedef struct _mpr_local_slot {
     mpr_loc process_loc;                                                        \
     int status;                                                                 \
     int protocol;                   /*!< Data transport protocol. */            \
+    int coalesce;                   /*!< Coalescing mode for updates. */        \
+    float rate;                     /*!< Maximum output rate in Hz. */          \
+    float deadband;                 /*!< Minimum change of sent output or -1. */\
+    int num_suppressed;             /*!< Number of suppressed updates. */       \
     int use_inst;                   /*!< 1 if using instances, 0 otherwise. */  \
     int is_local;
 
@@ -455,9 +623,23 @@ typedef struct _mpr_local_map {
     int num_vars;                   /*!< Number of user variables. */
     int num_inst;                   /*!< Number of local instances. */
 
+    /* output held back by rate limiting */
+    double *held_vals;              /*!< Combined output values per instance. */
+    int *held_counts;               /*!< Number of combined values per element. */
+    struct _mpr_id_map **held_idmaps; /*!< Associated mpr_id_map per instance. */
+    char *held_inst;                /*!< Bitflags to indicate held instances. */
+    mpr_time last_sent;             /*!< Time of the last rate-limited output. */
+
+    double *sent_vals;              /*!< Last output sent per instance, for deadband. */
+    char *dirty_elems;              /*!< Bitflags for changed input elements per instance,
+                                     *   only used by element-wise maps. */
+
+    int sync_version;               /*!< Version stamped on the last change to the map. */
+
     uint8_t is_local_only;
     uint8_t one_src;
     uint8_t updated;
+    uint8_t held;
 } mpr_local_map_t, *mpr_local_map;
 
 /*! The rtr_sig is a linked list containing a signal and a list of mapping
@@ -473,6 +655,9 @@ typedef struct _mpr_rtr_sig {
     int num_slots;
     int id_counter;
 
+    mpr_local_slot *slots_by_id;    /*!< Incoming slots indexed by slot id. */
+    int num_slots_by_id;
+
 } *mpr_rtr_sig;
 
 /*! The router structure. */
@@ -481,10 +666,10 @@ typedef struct _mpr_rtr {
     mpr_rtr_sig sigs;               /*!< The list of mappings for each signal. */
 } mpr_rtr_t, *mpr_rtr;
 
-/*! The instance ID map is a linked list of int32 instance ids for coordinating
+/*! The instance ID map associates local and global instance ids for coordinating
  *  remote and local instances. */
 typedef struct _mpr_id_map {
-    struct _mpr_id_map *next;       /*!< The next id map in the list. */
+    struct _mpr_id_map *next;       /*!< The next id map in the reserve list. */
 
     mpr_id GID;                     /*!< Hash for originating device. */
     mpr_id LID;                     /*!< Local instance id to map. */
@@ -492,6 +677,45 @@ typedef struct _mpr_id_map {
     int GID_refcount;
 } mpr_id_map_t, *mpr_id_map;
 
+/*! Hash indices of the active id maps in a signal group. */
+typedef struct _mpr_id_map_index {
+    struct _mpr_id_map **by_LID;    /*!< Open-addressed table of id maps by LID. */
+    struct _mpr_id_map **by_GID;    /*!< Open-addressed table of id maps by GID. */
+    int size;                       /*!< Size of each table, always a power of two. */
+    int count;                      /*!< Number of active id maps. */
+} mpr_id_map_index_t, *mpr_id_map_index;
+
+/**** Update queue ****/
+
+#define MPR_QUEUE_SIZE 256          /* must be a power of two */
+#ifndef MPR_QUEUE_VAL_BYTES
+#define MPR_QUEUE_VAL_BYTES 128     /* only handed-over values may be larger */
+#endif
+
+/*! A signal update pushed to a device's queue from another thread. */
+typedef struct _mpr_queued_update {
+    uint32_t seq;                   /*!< Position for which this slot is ready to be written
+                                     *   (seq == pos) or read (seq == pos + 1). */
+    int len;                        /*!< Value length, or 0 for a release. */
+    struct _mpr_local_sig *sig;
+    mpr_id inst;
+    mpr_time time;
+    mpr_type type;
+    union {
+        double d[MPR_QUEUE_VAL_BYTES / sizeof(double)];
+        char c[MPR_QUEUE_VAL_BYTES];
+    } val;
+    void *ext;                      /*!< Copy of a value too large for the slot, or zero. */
+} mpr_queued_update_t, *mpr_queued_update;
+
+/*! A bounded multiple-producer, single-consumer queue of signal updates. */
+typedef struct _mpr_update_queue {
+    mpr_queued_update_t *slots;
+    uint32_t head;                  /*!< Next position to be claimed by a producer. */
+    char pad[60];                   /*!< Keeps producers and the consumer off one cache line. */
+    uint32_t tail;                  /*!< Next position to be read by the polling thread. */
+} mpr_update_queue_t;
+
 /**** Device ****/
 
 #define MPR_DEV_STRUCT_ITEMS                                            \
@@ -507,7 +731,10 @@ typedef struct _mpr_id_map {
     int num_maps_out;   /*!< Number of associated outgoing maps. */     \
     int num_linked;     /*!< Number of linked devices. */               \
     int status;                                                         \
-    uint8_t subscribed;                                                 \
+    uint8_t subscribed; /*!< Flags of our autorenewing subscription. */ \
+    uint32_t sub_lease_end; /*!< End of a temporary subscription. */    \
+    struct _mpr_sig *sigs; /*!< Signals of this device. */              \
+    struct _mpr_link *links; /*!< Links to this device. */              \
     int is_local;
 
 /*! A record that keeps information about a device. */
@@ -524,13 +751,19 @@ struct _mpr_local_dev {
     int n_output_callbacks;
 
     mpr_subscriber subscribers;         /*!< Linked-list of subscribed peers. */
+    mpr_tombstone tombstones;           /*!< Removed signals and maps, newest first. */
+    int num_tombstones;
+    int sync_horizon;                   /*!< Oldest version subscribers can catch up from. */
+    int session;                        /*!< Random token identifying this run of the device. */
 
     struct {
-        struct _mpr_id_map **active;    /*!< The list of active instance id maps. */
+        struct _mpr_id_map_index *active;   /*!< Indices of active id maps per group. */
         struct _mpr_id_map *reserve;    /*!< The list of reserve instance id maps. */
     } idmaps;
 
     mpr_expr_stack expr_stack;
+    mpr_update_queue_t queue;           /*!< Updates queued from other threads. */
+    struct _mpr_thread_data *thread_data;   /*!< Background polling thread, if running. */
 
     mpr_time time;
     int num_sig_groups;
@@ -576,6 +809,8 @@ typedef struct _mpr_msg
 {
     mpr_msg_atom_t *atoms;
     int num_atoms;
-} *mpr_msg;
+    int allocated;              /*!< 1 if this structure must be freed by mpr_msg_free(). */
+    mpr_msg_atom_t buf[NUM_EXTRA_PROPS]; /*!< Atoms of messages with few properties. */
+} mpr_msg_t, *mpr_msg;
 
 #endif /* __MPR_TYPES_H__ */
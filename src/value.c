@@ -4,7 +4,6 @@
 #include <stdio.h>
 #include <stddef.h>
 #include <limits.h>
-#include <assert.h>
 
 #include "mapper_internal.h"
 #include "types_internal.h"
@@ -103,24 +102,6 @@ done:
     v->num_inst = num_inst;
 }
 
-int mpr_value_remove_inst(mpr_value v, int idx)
-{
-    int i;
-    RETURN_ARG_UNLESS(idx >= 0 && idx < v->num_inst, v->num_inst);
-    free(v->inst[idx].samps);
-    free(v->inst[idx].times);
-    if (v->inst[idx].pos >= 0)
-        --v->num_active_inst;
-    for (i = idx + 1; i < v->num_inst; i++) {
-        /* shift values down */
-        memcpy(&(v->inst[i-1]), &(v->inst[i]), sizeof(mpr_value_buffer_t));
-    }
-    --v->num_inst;
-    assert(v->num_inst >= 0);
-    v->inst = realloc(v->inst, sizeof(mpr_value_buffer_t) * v->num_inst);
-    return v->num_inst;
-}
-
 void mpr_value_reset_inst(mpr_value v, int idx)
 {
     mpr_value_buffer b;
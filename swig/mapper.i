@@ -871,6 +871,8 @@ static named_prop get_obj_prop_by_idx(mpr_obj obj, int idx) {
 /*! Symbolic representation of recognized properties. */
 %constant int PROP_UNKNOWN              = MPR_PROP_UNKNOWN;
 %constant int PROP_CALIB                = MPR_PROP_CALIB;
+%constant int PROP_COALESCE             = MPR_PROP_COALESCE;
+%constant int PROP_DEADBAND             = MPR_PROP_DEADBAND;
 %constant int PROP_DEV                  = MPR_PROP_DEV;
 %constant int PROP_DIR                  = MPR_PROP_DIR;
 %constant int PROP_EXPR                 = MPR_PROP_EXPR;
@@ -892,6 +894,7 @@ static named_prop get_obj_prop_by_idx(mpr_obj obj, int idx) {
 %constant int PROP_NUM_MAPS_OUT         = MPR_PROP_NUM_MAPS_OUT;
 %constant int PROP_NUM_SIGS_IN          = MPR_PROP_NUM_SIGS_IN;
 %constant int PROP_NUM_SIGS_OUT         = MPR_PROP_NUM_SIGS_OUT;
+%constant int PROP_NUM_SUPPRESSED       = MPR_PROP_NUM_SUPPRESSED;
 %constant int PROP_ORDINAL              = MPR_PROP_ORDINAL;
 %constant int PROP_PERIOD               = MPR_PROP_PERIOD;
 %constant int PROP_PORT                 = MPR_PROP_PORT;
@@ -951,6 +954,13 @@ static named_prop get_obj_prop_by_idx(mpr_obj obj, int idx) {
 %constant int STEAL_NONE                = MPR_STEAL_NONE;
 %constant int STEAL_OLDEST              = MPR_STEAL_OLDEST;
 %constant int STEAL_NEWEST              = MPR_STEAL_NEWEST;
+%constant int STEAL_LEAST_RECENT        = MPR_STEAL_LEAST_RECENT;
+
+/*! Describes how repeated updates are coalesced before map output is sent. */
+%constant int COALESCE_NONE             = MPR_COALESCE_NONE;
+%constant int COALESCE_LATEST           = MPR_COALESCE_LATEST;
+%constant int COALESCE_MEAN             = MPR_COALESCE_MEAN;
+%constant int COALESCE_MAX              = MPR_COALESCE_MAX;
 
 /*! The set of possible events for a graph record, used to inform callbacks
  *  of what is happening to a record. */
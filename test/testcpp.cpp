@@ -364,6 +364,7 @@ int main(int argc, char ** argv)
 
     // try combining queries
     out << "devices with name matching 'my*' AND >=0 inputs" << std::endl;
+    graph.add_index(Type::DEVICE, Property::NAME);
     List<Device> qdev = graph.devices();
     qdev.filter(Property::NAME, "my*", Operator::EQUAL);
     qdev.filter(Property::NUM_SIGNALS_IN, 0, Operator::GREATER_THAN_OR_EQUAL);
@@ -425,6 +426,19 @@ int main(int argc, char ** argv)
         dev.poll(period);
     }
 
+    // try updating several instances at once
+    std::vector<Id> ids = {5, 6, 7};
+    std::vector<float> vals = {1.0f, 2.0f, 3.0f};
+    multisend.set_value(ids, vals);
+    for (i = 0; i < 3; i++) {
+        const float *val = (const float*)multisend.instance(ids[i]).value();
+        if (!val || *val != vals[i]) {
+            out << "error: batch update of instance " << ids[i] << " failed" << std::endl;
+            result = 1;
+        }
+    }
+    dev.poll(period);
+
     // test some time manipulation
     Time t1(10, 200);
     Time t2(10, 300);
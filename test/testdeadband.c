@@ -0,0 +1,309 @@
+#include <mapper/mapper.h>
+#include <stdio.h>
+#include <stdarg.h>
+#include <math.h>
+#include <string.h>
+#include <signal.h>
+#include <unistd.h>
+
+int verbose = 1;
+int period = 10;
+int col = 0;
+
+mpr_dev src = 0;
+mpr_dev dst = 0;
+mpr_sig sendsig = 0;
+mpr_sig recvsig = 0;
+mpr_map map = 0;
+mpr_map src_map = 0;
+
+/* a negative deadband is disabled, zero drops repeated values */
+float deadbands[] = {-1.f, 0.f, 0.5f};
+float deadband = -1.f;
+int sent = 0;
+int received = 0;
+int mismatched = 0;
+float last_val = -1.f;
+int done = 0;
+
+int terminate = 0;
+
+static void eprintf(const char *format, ...)
+{
+    va_list args;
+    if (!verbose) {
+        if (col >= 50)
+            printf("\33[2K\r");
+        fprintf(stdout, ".");
+        ++col;
+        return;
+    }
+    va_start(args, format);
+    vprintf(format, args);
+    fflush(stdout);
+    va_end(args);
+}
+
+int setup_src(const char *iface)
+{
+    float mn=0, mx=1;
+    mpr_list l;
+
+    src = mpr_dev_new("testdeadband-send", 0);
+    if (!src)
+        goto error;
+    if (iface)
+        mpr_graph_set_interface(mpr_obj_get_graph(src), iface);
+    eprintf("source created using interface %s.\n",
+            mpr_graph_get_interface(mpr_obj_get_graph(src)));
+
+    sendsig = mpr_sig_new(src, MPR_DIR_OUT, "outsig", 1, MPR_FLT, NULL,
+                          &mn, &mx, NULL, NULL, 0);
+
+    eprintf("Output signal /outsig registered.\n");
+    l = mpr_dev_get_sigs(src, MPR_DIR_OUT);
+    eprintf("Number of outputs: %d\n", mpr_list_get_size(l));
+    mpr_list_free(l);
+    return 0;
+
+error:
+    return 1;
+}
+
+void cleanup_src()
+{
+    if (src) {
+        eprintf("Freeing source.. ");
+        fflush(stdout);
+        mpr_dev_free(src);
+        eprintf("ok\n");
+    }
+}
+
+void handler(mpr_sig sig, mpr_sig_evt event, mpr_id instance, int length,
+             mpr_type type, const void *value, mpr_time t)
+{
+    if (value) {
+        float f = *(float*)value;
+        eprintf("handler: Got %f\n", f);
+        /* repeated values should have been suppressed */
+        if (deadband >= 0 && f == last_val)
+            ++mismatched;
+        last_val = f;
+    }
+    received++;
+}
+
+int setup_dst(const char *iface)
+{
+    float mn=0, mx=1;
+    mpr_list l;
+
+    dst = mpr_dev_new("testdeadband-recv", 0);
+    if (!dst)
+        goto error;
+    if (iface)
+        mpr_graph_set_interface(mpr_obj_get_graph(dst), iface);
+    eprintf("destination created using interface %s.\n",
+            mpr_graph_get_interface(mpr_obj_get_graph(dst)));
+
+    recvsig = mpr_sig_new(dst, MPR_DIR_IN, "insig", 1, MPR_FLT, NULL,
+                          &mn, &mx, NULL, handler, MPR_SIG_UPDATE);
+
+    eprintf("Input signal /insig registered.\n");
+    l = mpr_dev_get_sigs(dst, MPR_DIR_IN);
+    eprintf("Number of inputs: %d\n", mpr_list_get_size(l));
+    mpr_list_free(l);
+    return 0;
+
+error:
+    return 1;
+}
+
+void cleanup_dst()
+{
+    if (dst) {
+        eprintf("Freeing destination.. ");
+        fflush(stdout);
+        mpr_dev_free(dst);
+        eprintf("ok\n");
+    }
+}
+
+void set_map_deadband()
+{
+    int len;
+    mpr_type type;
+    const void *val;
+
+    if (!map)
+        return;
+
+    mpr_obj_set_prop((mpr_obj)map, MPR_PROP_DEADBAND, NULL, 1, MPR_FLT, &deadband, 1);
+    mpr_obj_push((mpr_obj)map);
+
+    /* wait until change has taken effect at the source */
+    do {
+        mpr_dev_poll(src, 10);
+        mpr_dev_poll(dst, 10);
+        mpr_obj_get_prop_by_idx(src_map, MPR_PROP_DEADBAND, NULL, &len, &type, &val, 0);
+    }
+    while (1 != len || MPR_FLT != type || *(float*)val != deadband);
+}
+
+int setup_map()
+{
+    mpr_list maps;
+    map = mpr_map_new(1, &sendsig, 1, &recvsig);
+    mpr_obj_push(map);
+
+    /* wait until map is established */
+    while (!mpr_map_get_is_ready(map)) {
+        mpr_dev_poll(dst, 10);
+        mpr_dev_poll(src, 10);
+    }
+
+    /* updates are suppressed and counted by the copy of the map held by the source device */
+    maps = mpr_sig_get_maps(sendsig, MPR_DIR_OUT);
+    src_map = maps ? *maps : 0;
+    mpr_list_free(maps);
+    return !src_map;
+}
+
+void wait_ready()
+{
+    while (!(mpr_dev_get_is_ready(src) && mpr_dev_get_is_ready(dst))) {
+        mpr_dev_poll(src, 10);
+        mpr_dev_poll(dst, 10);
+    }
+}
+
+void loop()
+{
+    int i = 0;
+    const char *name = mpr_obj_get_prop_as_str(sendsig, MPR_PROP_NAME, NULL);
+    while (!done && i < 100) {
+        /* each value is repeated four times */
+        float val = i / 4;
+        eprintf("Updating signal %s to %f\n", name, val);
+        mpr_sig_set_value(sendsig, 0, 1, MPR_FLT, &val);
+        sent++;
+        mpr_dev_poll(src, 0);
+        mpr_dev_poll(dst, period);
+        ++i;
+        if (!verbose) {
+            printf("\r  Sent: %4i, Received: %4i   ", sent, received);
+            fflush(stdout);
+        }
+    }
+}
+
+void ctrlc(int sig)
+{
+    done = 1;
+}
+
+int main(int argc, char **argv)
+{
+    int i, j, result = 0;
+    char *iface = 0;
+
+    /* process flags for -v verbose, -t terminate, -h help */
+    for (i = 1; i < argc; i++) {
+        if (argv[i] && argv[i][0] == '-') {
+            int len = strlen(argv[i]);
+            for (j = 1; j < len; j++) {
+                switch (argv[i][j]) {
+                    case 'h':
+                        printf("testdeadband.c: possible arguments "
+                               "-q quiet (suppress output), "
+                               "-t terminate automatically, "
+                               "-f fast (execute quickly), "
+                               "-h help, "
+                               "--iface network interface\n");
+                        return 1;
+                        break;
+                    case 'f':
+                        period = 1;
+                        break;
+                    case 'q':
+                        verbose = 0;
+                        break;
+                    case 't':
+                        terminate = 1;
+                        break;
+                    case '-':
+                        if (strcmp(argv[i], "--iface")==0 && argc>i+1) {
+                            i++;
+                            iface = argv[i];
+                            j = 1;
+                        }
+                        break;
+                    default:
+                        break;
+                }
+            }
+        }
+    }
+
+    signal(SIGINT, ctrlc);
+
+    if (setup_dst(iface)) {
+        eprintf("Error initializing destination.\n");
+        result = 1;
+        goto done;
+    }
+
+    if (setup_src(iface)) {
+        eprintf("Done initializing source.\n");
+        result = 1;
+        goto done;
+    }
+
+    wait_ready();
+
+    if (setup_map()) {
+        eprintf("Error initializing map.\n");
+        result = 1;
+        goto done;
+    }
+
+    do {
+        for (i = 0; i < (int)(sizeof(deadbands) / sizeof(float)) && !done && !result; i++) {
+            int suppressed, expected;
+            deadband = deadbands[i];
+            set_map_deadband();
+            suppressed = mpr_obj_get_prop_as_int32(src_map, MPR_PROP_NUM_SUPPRESSED, NULL);
+
+            received = sent = mismatched = 0;
+            last_val = -1.f;
+            loop();
+
+            /* allow any remaining updates to arrive */
+            mpr_dev_poll(src, 0);
+            mpr_dev_poll(dst, 100);
+
+            suppressed = (mpr_obj_get_prop_as_int32(src_map, MPR_PROP_NUM_SUPPRESSED, NULL)
+                          - suppressed);
+            eprintf("Deadband %g: sent %d updates, received %d, suppressed %d.\n", deadband,
+                    sent, received, suppressed);
+            if (mismatched) {
+                eprintf("Received %d update%s that should have been suppressed.\n",
+                        mismatched, mismatched == 1 ? "" : "s");
+                result = 1;
+            }
+            expected = deadband < 0 ? 0 : sent - sent / 4;
+            if (received != sent - expected || suppressed != expected) {
+                eprintf("Expected %d updates to be suppressed.\n", expected);
+                result = 1;
+            }
+        }
+    } while (!terminate && !done && !result);
+
+done:
+    cleanup_dst();
+    cleanup_src();
+    printf("\r..................................................Test %s\x1B[0m.\n",
+           result ? "\x1B[31mFAILED" : "\x1B[32mPASSED");
+    return result;
+}
@@ -0,0 +1,260 @@
+#include "../src/mapper_internal.h"
+#include <mapper/mapper.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdarg.h>
+#include <string.h>
+#include <signal.h>
+
+/* Checks that device evaluation stacks are sized when maps are created or removed, and that
+ * polling with established maps never reallocates them. */
+
+#define VEC_LEN 8
+
+int verbose = 1;
+int terminate = 0;
+int done = 0;
+int col = 0;
+int iterations = 200;
+
+mpr_dev src = 0;
+mpr_dev dst = 0;
+mpr_sig sendsig = 0;
+mpr_sig recvsig1 = 0;
+mpr_sig recvsig2 = 0;
+mpr_map map1 = 0;
+mpr_map map2 = 0;
+
+int received1 = 0;
+int received2 = 0;
+
+static void eprintf(const char *format, ...)
+{
+    va_list args;
+    if (!verbose) {
+        if (col >= 50)
+            printf("\33[2K\r");
+        fprintf(stdout, ".");
+        ++col;
+        return;
+    }
+    va_start(args, format);
+    vprintf(format, args);
+    fflush(stdout);
+    va_end(args);
+}
+
+void handler(mpr_sig sig, mpr_sig_evt event, mpr_id instance, int length,
+             mpr_type type, const void *value, mpr_time t)
+{
+    if (!value)
+        return;
+    if (sig == recvsig1)
+        ++received1;
+    else
+        ++received2;
+}
+
+int setup_devs(const char *iface)
+{
+    src = mpr_dev_new("testevalstack-send", 0);
+    dst = mpr_dev_new("testevalstack-recv", 0);
+    if (!src || !dst)
+        goto error;
+    if (iface) {
+        mpr_graph_set_interface(mpr_obj_get_graph((mpr_obj)src), iface);
+        mpr_graph_set_interface(mpr_obj_get_graph((mpr_obj)dst), iface);
+    }
+    eprintf("devices created using interface %s.\n",
+            mpr_graph_get_interface(mpr_obj_get_graph((mpr_obj)src)));
+
+    sendsig = mpr_sig_new(src, MPR_DIR_OUT, "outsig", VEC_LEN, MPR_FLT, NULL,
+                          NULL, NULL, NULL, NULL, 0);
+    recvsig1 = mpr_sig_new(dst, MPR_DIR_IN, "insig1", VEC_LEN, MPR_FLT, NULL,
+                           NULL, NULL, NULL, handler, MPR_SIG_UPDATE);
+    recvsig2 = mpr_sig_new(dst, MPR_DIR_IN, "insig2", 1, MPR_FLT, NULL,
+                           NULL, NULL, NULL, handler, MPR_SIG_UPDATE);
+    if (!sendsig || !recvsig1 || !recvsig2)
+        goto error;
+    return 0;
+
+  error:
+    return 1;
+}
+
+void cleanup_devs()
+{
+    eprintf("Freeing devices.. ");
+    fflush(stdout);
+    if (src)
+        mpr_dev_free(src);
+    if (dst)
+        mpr_dev_free(dst);
+    eprintf("ok\n");
+}
+
+void wait_ready()
+{
+    while (!done && !(mpr_dev_get_is_ready(src) && mpr_dev_get_is_ready(dst))) {
+        mpr_dev_poll(src, 10);
+        mpr_dev_poll(dst, 10);
+    }
+}
+
+mpr_map make_map(mpr_sig dst_sig, const char *expr, mpr_loc loc)
+{
+    mpr_map map = mpr_map_new(1, &sendsig, 1, &dst_sig);
+    mpr_obj_set_prop((mpr_obj)map, MPR_PROP_EXPR, NULL, 1, MPR_STR, expr, 1);
+    mpr_obj_set_prop((mpr_obj)map, MPR_PROP_PROCESS_LOC, NULL, 1, MPR_INT32, &loc, 1);
+    mpr_obj_push((mpr_obj)map);
+    return map;
+}
+
+int setup_maps()
+{
+    /* expressions with different stack requirements, one processed on each device */
+    map1 = make_map(recvsig1, "y=x*2+x{-1}", MPR_LOC_SRC);
+    map2 = make_map(recvsig2, "y=(x-x{-1}).mean()", MPR_LOC_DST);
+
+    while (!done && !(mpr_map_get_is_ready(map1) && mpr_map_get_is_ready(map2))) {
+        mpr_dev_poll(src, 10);
+        mpr_dev_poll(dst, 10);
+    }
+    eprintf("Maps initialized.\n");
+    return 0;
+}
+
+mpr_expr_stack get_stack(mpr_dev dev)
+{
+    return ((mpr_local_dev)dev)->expr_stack;
+}
+
+int run_test()
+{
+    int i, j, src_count, dst_count;
+    float vec[VEC_LEN];
+
+    /* the stacks were sized when the map expressions were set */
+    src_count = mpr_expr_stack_get_num_realloc(get_stack(src));
+    dst_count = mpr_expr_stack_get_num_realloc(get_stack(dst));
+    eprintf("Stack allocations after map setup: source %d, destination %d\n",
+            src_count, dst_count);
+    if (!src_count || !dst_count) {
+        eprintf("Evaluation stacks were not sized for active maps.\n");
+        return 1;
+    }
+
+    mpr_expr_stack_set_guard(get_stack(src), 1);
+    mpr_expr_stack_set_guard(get_stack(dst), 1);
+
+    do {
+        for (i = 0; i < iterations && !done; i++) {
+            for (j = 0; j < VEC_LEN; j++)
+                vec[j] = i + j;
+            mpr_sig_set_value(sendsig, 0, VEC_LEN, MPR_FLT, vec);
+            mpr_dev_poll(src, 0);
+            mpr_dev_poll(dst, 1);
+        }
+        for (i = 0; i < 10; i++) {
+            mpr_dev_poll(src, 10);
+            mpr_dev_poll(dst, 10);
+        }
+        eprintf("Received %d and %d updates\n", received1, received2);
+        if (!received1 || !received2) {
+            eprintf("Updates were not received.\n");
+            return 1;
+        }
+        if (   mpr_expr_stack_get_num_realloc(get_stack(src)) != src_count
+            || mpr_expr_stack_get_num_realloc(get_stack(dst)) != dst_count) {
+            eprintf("Evaluation stack reallocated while polling.\n");
+            return 1;
+        }
+    } while (!terminate && !done);
+
+    /* removing the map processed at the destination should shrink its stack */
+    mpr_expr_stack_set_guard(get_stack(dst), 0);
+    mpr_map_release(map2);
+    for (i = 0; i < 100 && dst_count == mpr_expr_stack_get_num_realloc(get_stack(dst)); i++) {
+        mpr_dev_poll(src, 10);
+        mpr_dev_poll(dst, 10);
+    }
+    if (dst_count == mpr_expr_stack_get_num_realloc(get_stack(dst))) {
+        eprintf("Evaluation stack was not resized after removing map.\n");
+        return 1;
+    }
+    eprintf("Destination stack resized after removing map.\n");
+    return 0;
+}
+
+void ctrlc(int sig)
+{
+    done = 1;
+}
+
+int main(int argc, char **argv)
+{
+    int i, j, result = 0;
+    char *iface = 0;
+
+    /* process flags for -v verbose, -t terminate, -h help */
+    for (i = 1; i < argc; i++) {
+        if (argv[i] && argv[i][0] == '-') {
+            int len = strlen(argv[i]);
+            for (j = 1; j < len; j++) {
+                switch (argv[i][j]) {
+                    case 'h':
+                        printf("testevalstack.c: possible arguments "
+                               "-f fast (execute quickly), "
+                               "-q quiet (suppress output), "
+                               "-t terminate automatically, "
+                               "-h help, "
+                               "--iface network interface\n");
+                        return 1;
+                        break;
+                    case 'f':
+                        iterations = 50;
+                        break;
+                    case 'q':
+                        verbose = 0;
+                        break;
+                    case 't':
+                        terminate = 1;
+                        break;
+                    case '-':
+                        if (strcmp(argv[i], "--iface")==0 && argc>i+1) {
+                            i++;
+                            iface = argv[i];
+                            j = 1;
+                        }
+                        break;
+                    default:
+                        break;
+                }
+            }
+        }
+    }
+
+    signal(SIGINT, ctrlc);
+
+    if (setup_devs(iface)) {
+        eprintf("Error initializing devices.\n");
+        result = 1;
+        goto done;
+    }
+
+    wait_ready();
+
+    if (setup_maps()) {
+        eprintf("Error initializing maps.\n");
+        result = 1;
+        goto done;
+    }
+
+    result = run_test();
+
+  done:
+    cleanup_devs();
+    printf("\r..................................................Test %s\x1B[0m.\n",
+           result ? "\x1B[31mFAILED" : "\x1B[32mPASSED");
+    return result;
+}
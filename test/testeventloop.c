@@ -0,0 +1,250 @@
+#include <mapper/mapper.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdarg.h>
+#include <string.h>
+#include <signal.h>
+#include <poll.h>
+#include <sys/time.h>
+
+/* Drives two devices from an external poll() loop using the sockets returned by
+ * mpr_dev_get_fds() and the timeout from mpr_graph_get_next_timeout(), instead of calling
+ * mpr_dev_poll(). */
+
+#define MAX_FDS 16
+
+int verbose = 1;
+int terminate = 0;
+int done = 0;
+int col = 0;
+int period = 100;
+int idle_ms = 1000;
+
+mpr_dev src = 0;
+mpr_dev dst = 0;
+mpr_sig sendsig = 0;
+mpr_sig recvsig = 0;
+
+int sent = 0;
+int received = 0;
+int wakeups = 0;
+
+static void eprintf(const char *format, ...)
+{
+    va_list args;
+    if (!verbose) {
+        if (col >= 50)
+            printf("\33[2K\r");
+        fprintf(stdout, ".");
+        ++col;
+        return;
+    }
+    va_start(args, format);
+    vprintf(format, args);
+    fflush(stdout);
+    va_end(args);
+}
+
+/*! Internal function to get the current time. */
+static double current_time()
+{
+    struct timeval tv;
+    gettimeofday(&tv, NULL);
+    return tv.tv_sec + tv.tv_usec / 1000000.0;
+}
+
+void handler(mpr_sig sig, mpr_sig_evt event, mpr_id instance, int length,
+             mpr_type type, const void *value, mpr_time t)
+{
+    if (value) {
+        eprintf("handler: Got %d\n", *(int*)value);
+        ++received;
+    }
+}
+
+int setup_devs(const char *iface)
+{
+    int mn = 0, mx = 1;
+
+    src = mpr_dev_new("testeventloop-send", 0);
+    dst = mpr_dev_new("testeventloop-recv", 0);
+    if (!src || !dst)
+        goto error;
+    if (iface) {
+        mpr_graph_set_interface(mpr_obj_get_graph((mpr_obj)src), iface);
+        mpr_graph_set_interface(mpr_obj_get_graph((mpr_obj)dst), iface);
+    }
+    eprintf("devices created using interface %s.\n",
+            mpr_graph_get_interface(mpr_obj_get_graph((mpr_obj)src)));
+
+    sendsig = mpr_sig_new(src, MPR_DIR_OUT, "outsig", 1, MPR_INT32, NULL,
+                          &mn, &mx, NULL, NULL, 0);
+    recvsig = mpr_sig_new(dst, MPR_DIR_IN, "insig", 1, MPR_INT32, NULL,
+                          &mn, &mx, NULL, handler, MPR_SIG_UPDATE);
+    if (!sendsig || !recvsig)
+        goto error;
+    return 0;
+
+  error:
+    return 1;
+}
+
+void cleanup_devs()
+{
+    eprintf("Freeing devices.. ");
+    fflush(stdout);
+    if (src)
+        mpr_dev_free(src);
+    if (dst)
+        mpr_dev_free(dst);
+    eprintf("ok\n");
+}
+
+/* Wait until a socket is readable or a device has work due, then process both devices. */
+void run_loop(int block_ms)
+{
+    struct pollfd pfds[MAX_FDS];
+    int fds[MAX_FDS];
+    int i, num, num_pfds = 0;
+    int timeout = mpr_graph_get_next_timeout(mpr_obj_get_graph((mpr_obj)src));
+    int dst_timeout = mpr_graph_get_next_timeout(mpr_obj_get_graph((mpr_obj)dst));
+    if (dst_timeout < timeout)
+        timeout = dst_timeout;
+    if (block_ms < timeout)
+        timeout = block_ms;
+
+    /* device sockets are only opened once the device is registered */
+    num = mpr_dev_get_fds(src, fds, MAX_FDS);
+    num += mpr_dev_get_fds(dst, fds + num, MAX_FDS - num);
+    for (i = 0; i < num && i < MAX_FDS; i++) {
+        pfds[num_pfds].fd = fds[i];
+        pfds[num_pfds].events = POLLIN;
+        pfds[num_pfds].revents = 0;
+        ++num_pfds;
+    }
+
+    poll(pfds, num_pfds, timeout);
+    ++wakeups;
+    mpr_dev_process_ready(src);
+    mpr_dev_process_ready(dst);
+}
+
+void run_loop_for(int ms)
+{
+    double then = current_time(), left;
+    while (!done && (left = ms - (current_time() - then) * 1000) > 0)
+        run_loop((int)left + 1);
+}
+
+int run_test()
+{
+    int i;
+    mpr_map map;
+
+    while (!done && !(mpr_dev_get_is_ready(src) && mpr_dev_get_is_ready(dst)))
+        run_loop(100);
+    eprintf("Devices are ready.\n");
+
+    map = mpr_map_new(1, &sendsig, 1, &recvsig);
+    mpr_obj_push(map);
+    while (!done && !mpr_map_get_is_ready(map))
+        run_loop(100);
+    eprintf("Map initialized.\n");
+
+    /* nothing is due while idle apart from occasional housekeeping */
+    wakeups = 0;
+    run_loop_for(idle_ms);
+    eprintf("%d wakeups while idle for %d ms\n", wakeups, idle_ms);
+    if (wakeups > idle_ms / 20) {
+        eprintf("Too many wakeups while idle.\n");
+        return 1;
+    }
+
+    i = 0;
+    while ((!terminate || i < 50) && !done) {
+        eprintf("Updating signal to %d\n", i);
+        mpr_sig_set_value(sendsig, 0, 1, MPR_INT32, &i);
+        ++sent;
+        ++i;
+        run_loop_for(period);
+
+        if (!verbose) {
+            printf("\r  Sent: %4i, Received: %4i   ", sent, received);
+            fflush(stdout);
+        }
+    }
+    return 0;
+}
+
+void ctrlc(int sig)
+{
+    done = 1;
+}
+
+int main(int argc, char **argv)
+{
+    int i, j, result = 0;
+    char *iface = 0;
+
+    /* process flags for -v verbose, -t terminate, -h help */
+    for (i = 1; i < argc; i++) {
+        if (argv[i] && argv[i][0] == '-') {
+            int len = strlen(argv[i]);
+            for (j = 1; j < len; j++) {
+                switch (argv[i][j]) {
+                    case 'h':
+                        printf("testeventloop.c: possible arguments "
+                               "-f fast (execute quickly), "
+                               "-q quiet (suppress output), "
+                               "-t terminate automatically, "
+                               "-h help, "
+                               "--iface network interface\n");
+                        return 1;
+                        break;
+                    case 'f':
+                        period = 10;
+                        idle_ms = 500;
+                        break;
+                    case 'q':
+                        verbose = 0;
+                        break;
+                    case 't':
+                        terminate = 1;
+                        break;
+                    case '-':
+                        if (strcmp(argv[i], "--iface")==0 && argc>i+1) {
+                            i++;
+                            iface = argv[i];
+                            j = 1;
+                        }
+                        break;
+                    default:
+                        break;
+                }
+            }
+        }
+    }
+
+    signal(SIGINT, ctrlc);
+
+    if (setup_devs(iface)) {
+        eprintf("Error initializing devices.\n");
+        result = 1;
+        goto done;
+    }
+
+    result = run_test();
+
+    if (!result && (!received || sent > received)) {
+        eprintf("Not all sent messages were received.\n");
+        eprintf("Updated value %d time%s and received %d of them.\n",
+                sent, sent == 1 ? "" : "s", received);
+        result = 1;
+    }
+
+  done:
+    cleanup_devs();
+    printf("\r..................................................Test %s\x1B[0m.\n",
+           result ? "\x1B[31mFAILED" : "\x1B[32mPASSED");
+    return result;
+}
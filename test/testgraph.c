@@ -1025,6 +1025,62 @@ int main(int argc, char **argv)
         goto done;
     }
 
+    /*********/
+
+    eprintf("\nCache list of signals and modify graph:\n");
+
+    siglist = mpr_list_get_cached(mpr_graph_get_objs(graph, MPR_SIG));
+    count = mpr_list_get_size(siglist);
+    for (i = 0; i < count; i++) {
+        sig = (mpr_sig)mpr_list_get_idx(siglist, i);
+        if (!sig || mpr_obj_get_type((mpr_obj)sig) != MPR_SIG) {
+            eprintf("Cached list returned bad item at index %d.\n", i);
+            result = 1;
+            mpr_list_free(siglist);
+            goto done;
+        }
+    }
+    if (mpr_list_get_idx(siglist, count)) {
+        eprintf("Cached list returned item past its end.\n");
+        result = 1;
+        mpr_list_free(siglist);
+        goto done;
+    }
+
+    /* adding a signal must invalidate the cache */
+    mpr_graph_add_sig(graph, "cached", "testgraph.1", 0);
+    if (mpr_list_get_size(siglist) != count + 1) {
+        eprintf("Expected %d cached records, but counted %d.\n", count + 1,
+                mpr_list_get_size(siglist));
+        result = 1;
+        mpr_list_free(siglist);
+        goto done;
+    }
+
+    mpr_list_free(siglist);
+
+    /* the cache must remain iterable while removing the current item */
+    siglist = mpr_list_get_cached(mpr_graph_get_objs(graph, MPR_SIG));
+    count = 0;
+    while (siglist) {
+        sig = (mpr_sig)*siglist;
+        siglist = mpr_list_get_next(siglist);
+        if (strcmp(sig->dev->name, "testgraph.1") == 0)
+            mpr_graph_remove_sig(graph, sig, MPR_OBJ_REM, 0);
+        else
+            ++count;
+    }
+    siglist = mpr_graph_get_objs(graph, MPR_SIG);
+    if (mpr_list_get_size(siglist) != count) {
+        eprintf("Expected %d records after removal, but counted %d.\n", count,
+                mpr_list_get_size(siglist));
+        result = 1;
+        mpr_list_free(siglist);
+        goto done;
+    }
+    mpr_list_free(siglist);
+    eprintf("  ok.\n");
+
     goto done;
 
     /*********/
@@ -0,0 +1,354 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdarg.h>
+#include <string.h>
+#include <sys/time.h>
+#include "../src/mapper_internal.h"
+
+/* Builds a synthetic graph of many devices with many signals each, and compares the time taken
+ * to query the signals, maps and links of each device with a scan of the whole graph. Also
+ * compares filtering all signals by property with and without a property index, and checks that
+ * a graph with limited retention stays within its limit. */
+
+int verbose = 1;
+int num_devs = 1000;
+int num_sigs = 100;
+
+static void eprintf(const char *format, ...)
+{
+    va_list args;
+    if (!verbose)
+        return;
+    va_start(args, format);
+    vprintf(format, args);
+    va_end(args);
+}
+
+/*! Internal function to get the current time. */
+static double current_time()
+{
+    struct timeval tv;
+    gettimeofday(&tv, NULL);
+    return tv.tv_sec + tv.tv_usec / 1000000.0;
+}
+
+static int count_list(mpr_list l)
+{
+    int count = 0;
+    while (l) {
+        ++count;
+        l = mpr_list_get_next(l);
+    }
+    return count;
+}
+
+/* The cost of the previous implementation: test every signal in the graph. */
+static int count_sigs_by_scan(mpr_graph g, mpr_dev dev)
+{
+    int count = 0;
+    mpr_list l = mpr_graph_get_objs(g, MPR_SIG);
+    while (l) {
+        if (((mpr_sig)*l)->dev == dev)
+            ++count;
+        l = mpr_list_get_next(l);
+    }
+    return count;
+}
+
+/* The parsed properties refer to the message, so it must be freed after them. */
+static mpr_msg sig_props(lo_message lom, const char *unit, int tag)
+{
+    lo_message_add_string(lom, "@direction");
+    lo_message_add_string(lom, "output");
+    lo_message_add_string(lom, "@unit");
+    lo_message_add_string(lom, unit);
+    lo_message_add_string(lom, "@tag");
+    lo_message_add_int32(lom, tag);
+    lo_message_add_string(lom, "@note");
+    lo_message_add_int32(lom, tag);
+    return mpr_msg_parse_props(lo_message_get_argc(lom), lo_message_get_types(lom),
+                               lo_message_get_argv(lom));
+}
+
+static void build_graph(mpr_graph g)
+{
+    int i, j;
+    char dev_name[32], sig_name[32], src_name[64], dst_name[64];
+    const char *src = src_name;
+    mpr_msg *props = malloc(sizeof(mpr_msg) * num_sigs);
+    lo_message *msgs = malloc(sizeof(lo_message) * num_sigs);
+
+    /* signal j has unit "u<j % 10>", tag j and note j */
+    for (j = 0; j < num_sigs; j++) {
+        snprintf(sig_name, 32, "u%d", j % 10);
+        msgs[j] = lo_message_new();
+        props[j] = sig_props(msgs[j], sig_name, j);
+    }
+    for (i = 0; i < num_devs; i++) {
+        snprintf(dev_name, 32, "scale.%d", i);
+        mpr_graph_add_dev(g, dev_name, 0);
+        for (j = 0; j < num_sigs; j++) {
+            snprintf(sig_name, 32, "sig%d", j);
+            mpr_graph_add_sig(g, sig_name, dev_name, props[j]);
+        }
+    }
+    for (j = 0; j < num_sigs; j++) {
+        mpr_msg_free(props[j]);
+        lo_message_free(msgs[j]);
+    }
+    free(props);
+    free(msgs);
+    /* connect each device to the next one */
+    for (i = 0; i < num_devs; i++) {
+        snprintf(src_name, 64, "scale.%d/sig0", i);
+        snprintf(dst_name, 64, "scale.%d/sig1", (i + 1) % num_devs);
+        mpr_graph_add_map(g, i + 1, 1, &src, dst_name);
+    }
+}
+
+static int check_dev(mpr_dev dev)
+{
+    mpr_list l;
+    int count;
+    if ((count = count_list(mpr_dev_get_sigs(dev, MPR_DIR_ANY))) != num_sigs) {
+        eprintf("Device %s has %d signals, expected %d\n", dev->name, count, num_sigs);
+        return 1;
+    }
+    if (   count_list(mpr_dev_get_maps(dev, MPR_DIR_OUT)) != 1
+        || count_list(mpr_dev_get_maps(dev, MPR_DIR_IN)) != 1
+        || count_list(mpr_dev_get_maps(dev, MPR_DIR_ANY)) != 2) {
+        eprintf("Device %s has the wrong number of maps\n", dev->name);
+        return 1;
+    }
+    if (count_list(mpr_dev_get_links(dev, MPR_DIR_ANY)) != 2) {
+        eprintf("Device %s has the wrong number of links\n", dev->name);
+        return 1;
+    }
+    /* filtering a device's signals only tests the device's own signals */
+    l = mpr_dev_get_sigs(dev, MPR_DIR_ANY);
+    l = mpr_list_filter(l, MPR_PROP_NAME, NULL, 1, MPR_STR, "sig1", MPR_OP_EQ);
+    if (count_list(l) != 1) {
+        eprintf("Filtering signals of device %s failed\n", dev->name);
+        return 1;
+    }
+    if (count_list(mpr_sig_get_maps(mpr_dev_get_sig_by_name(dev, "sig0"), MPR_DIR_ANY)) != 1) {
+        eprintf("Signal %s/sig0 has the wrong number of maps\n", dev->name);
+        return 1;
+    }
+    return 0;
+}
+
+static int check_filters(mpr_graph g, const char *label)
+{
+    int count, tag = num_sigs - 5;
+    double then = current_time();
+    mpr_list l = mpr_graph_get_objs(g, MPR_SIG);
+    l = mpr_list_filter(l, MPR_PROP_UNIT, NULL, 1, MPR_STR, "u3", MPR_OP_EQ);
+    if ((count = count_list(l)) != num_devs * num_sigs / 10) {
+        eprintf("Filtering by unit %s returned %d signals\n", label, count);
+        return 1;
+    }
+    l = mpr_graph_get_objs(g, MPR_SIG);
+    l = mpr_list_filter(l, MPR_PROP_EXTRA, "tag", 1, MPR_INT32, &tag, MPR_OP_GTE);
+    if ((count = count_list(l)) != num_devs * 5) {
+        eprintf("Filtering by tag range %s returned %d signals\n", label, count);
+        return 1;
+    }
+    eprintf("Filtered signals by unit and tag range %s in %f seconds\n", label,
+            current_time() - then);
+    return 0;
+}
+
+int run_test(mpr_graph g)
+{
+    int i, count = 0;
+    double then;
+    char name[32];
+    mpr_list devs;
+
+    then = current_time();
+    build_graph(g);
+    eprintf("Built graph with %d devices and %d signals in %f seconds\n", num_devs,
+            num_devs * num_sigs, current_time() - then);
+
+    then = current_time();
+    devs = mpr_graph_get_objs(g, MPR_DEV);
+    while (devs) {
+        if (check_dev((mpr_dev)*devs)) {
+            mpr_list_free(devs);
+            return 1;
+        }
+        devs = mpr_list_get_next(devs);
+    }
+    eprintf("Queried signals, maps and links of every device in %f seconds\n",
+            current_time() - then);
+
+    then = current_time();
+    devs = mpr_graph_get_objs(g, MPR_DEV);
+    while (devs) {
+        count += count_sigs_by_scan(g, (mpr_dev)*devs);
+        devs = mpr_list_get_next(devs);
+    }
+    eprintf("Scanned the whole graph for the signals of every device in %f seconds\n",
+            current_time() - then);
+    if (count != num_devs * num_sigs)
+        return 1;
+
+    if (check_filters(g, "without index"))
+        return 1;
+    mpr_graph_add_index(g, MPR_SIG, MPR_PROP_UNIT, NULL);
+    mpr_graph_add_index(g, MPR_SIG, MPR_PROP_EXTRA, "tag");
+    /* the first range query also sorts the index */
+    if (check_filters(g, "with new index") || check_filters(g, "with index"))
+        return 1;
+
+    /* the index must follow property changes */
+    {
+        lo_message lom = lo_message_new();
+        mpr_msg props = sig_props(lom, "changed", 0);
+        mpr_list l;
+        mpr_graph_add_sig(g, "sig3", "scale.0", props);
+        mpr_msg_free(props);
+        lo_message_free(lom);
+        l = mpr_list_filter(mpr_graph_get_objs(g, MPR_SIG), MPR_PROP_UNIT, NULL, 1, MPR_STR,
+                            "changed", MPR_OP_EQ);
+        if (count_list(l) != 1) {
+            eprintf("Index was not updated after a property change\n");
+            return 1;
+        }
+        lom = lo_message_new();
+        props = sig_props(lom, "u3", 3);
+        mpr_graph_add_sig(g, "sig3", "scale.0", props);
+        mpr_msg_free(props);
+        lo_message_free(lom);
+    }
+
+    /* removing a device must also remove it from the lists of its neighbours */
+    snprintf(name, 32, "scale.%d", num_devs / 2);
+    mpr_graph_remove_dev(g, mpr_graph_get_dev_by_name(g, name), MPR_OBJ_REM, 1);
+    if (mpr_graph_get_dev_by_name(g, name)) {
+        eprintf("Device %s was not removed\n", name);
+        return 1;
+    }
+    for (i = num_devs / 2 - 1; i <= num_devs / 2 + 1; i += 2) {
+        mpr_dev dev;
+        snprintf(name, 32, "scale.%d", i);
+        dev = mpr_graph_get_dev_by_name(g, name);
+        if (   count_list(mpr_dev_get_maps(dev, MPR_DIR_ANY)) != 1
+            || count_list(mpr_dev_get_links(dev, MPR_DIR_ANY)) != 1) {
+            eprintf("Maps or links of device %s were not updated after removal\n", name);
+            return 1;
+        }
+    }
+    --num_devs;
+    return check_filters(g, "after removal");
+}
+
+int run_retention_test(mpr_graph g)
+{
+    int count, max_sigs = num_devs * 10;
+    char name[32];
+    /* user-defined properties are only kept if named */
+    mpr_prop keep[] = {MPR_PROP_UNIT, MPR_PROP_EXTRA};
+    const char *keep_key = "note";
+    mpr_list l;
+    mpr_dev dev;
+    mpr_sig sig;
+    double then = current_time();
+
+    mpr_graph_set_retention(g, 2, keep, 1, &keep_key, max_sigs);
+    build_graph(g);
+    eprintf("Built graph keeping at most %d of %d signals in %f seconds\n", max_sigs,
+            num_devs * num_sigs, current_time() - then);
+
+    if ((count = count_list(mpr_graph_get_objs(g, MPR_SIG))) > max_sigs) {
+        eprintf("Graph kept %d signals, expected at most %d\n", count, max_sigs);
+        return 1;
+    }
+    if ((count = count_list(mpr_graph_get_objs(g, MPR_MAP))) != num_devs) {
+        eprintf("Graph kept %d maps, expected %d\n", count, num_devs);
+        return 1;
+    }
+    /* evicted signals still exist on their devices */
+    l = mpr_graph_get_objs(g, MPR_DEV);
+    while (l) {
+        if (((mpr_dev)*l)->num_outputs) {
+            eprintf("Evicting signals changed the signal count of %s\n", ((mpr_dev)*l)->name);
+            mpr_list_free(l);
+            return 1;
+        }
+        l = mpr_list_get_next(l);
+    }
+
+    /* the most recently updated signals are kept, with only the requested properties */
+    snprintf(name, 32, "scale.%d", num_devs - 1);
+    dev = mpr_graph_get_dev_by_name(g, name);
+    snprintf(name, 32, "sig%d", num_sigs - 1);
+    sig = mpr_dev_get_sig_by_name(dev, name);
+    snprintf(name, 32, "u%d", (num_sigs - 1) % 10);
+    if (!sig || !sig->unit || strcmp(sig->unit, name)) {
+        eprintf("Last updated signal was not kept with its unit\n");
+        return 1;
+    }
+    if (num_sigs - 1 != mpr_obj_get_prop_as_int32((mpr_obj)sig, MPR_PROP_EXTRA, "note")) {
+        eprintf("Last updated signal was not kept with its note\n");
+        return 1;
+    }
+    l = mpr_graph_get_objs(g, MPR_SIG);
+    while (l) {
+        if (mpr_obj_get_prop_by_key((mpr_obj)*l, "tag", 0, 0, 0, 0)) {
+            eprintf("Graph kept a property that was not requested\n");
+            mpr_list_free(l);
+            return 1;
+        }
+        l = mpr_list_get_next(l);
+    }
+    return 0;
+}
+
+int main(int argc, char **argv)
+{
+    int i, j, result = 0;
+    mpr_graph graph;
+
+    /* process flags for -v verbose, -f fast, -h help */
+    for (i = 1; i < argc; i++) {
+        if (argv[i] && argv[i][0] == '-') {
+            int len = strlen(argv[i]);
+            for (j = 1; j < len; j++) {
+                switch (argv[i][j]) {
+                    case 'h':
+                        printf("testgraphscale.c: possible arguments "
+                               "-f fast (execute quickly), "
+                               "-q quiet (suppress output), "
+                               "-h help\n");
+                        return 1;
+                        break;
+                    case 'f':
+                        num_devs = 100;
+                        break;
+                    case 'q':
+                        verbose = 0;
+                        break;
+                    default:
+                        break;
+                }
+            }
+        }
+    }
+
+    graph = mpr_graph_new(0);
+    result = run_test(graph);
+    mpr_graph_free(graph);
+
+    if (!result) {
+        graph = mpr_graph_new(0);
+        result = run_retention_test(graph);
+        mpr_graph_free(graph);
+    }
+
+    if (!verbose)
+        printf("..................................................");
+    printf("Test %s\x1B[0m.\n", result ? "\x1B[31mFAILED" : "\x1B[32mPASSED");
+    return result;
+}
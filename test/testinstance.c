@@ -256,8 +256,19 @@ int setup_dst(const char *iface)
     if (!multirecv)
         goto error;
 
-    for (i = 2; i < 10; i += 2) {
-        mpr_sig_reserve_inst(multirecv, 1, (mpr_id*)&i, 0);
+    for (i = 8; i > 0; i -= 2) {
+        mpr_id id = i;
+        mpr_sig_reserve_inst(multirecv, 1, &id, 0);
+    }
+
+    /* instances are indexed in order of their ids regardless of reservation order */
+    num_inst = mpr_sig_get_num_inst(multirecv, MPR_STATUS_ALL);
+    for (i = 1; i < num_inst; i++) {
+        if (mpr_sig_get_inst_id(multirecv, i, MPR_STATUS_ALL)
+            <= mpr_sig_get_inst_id(multirecv, i - 1, MPR_STATUS_ALL)) {
+            eprintf("Instance ids are not in ascending order.\n");
+            goto error;
+        }
     }
 
     eprintf("Input signal added with %i instances.\n",
@@ -306,7 +317,7 @@ void print_instance_idx(mpr_sig sig)
     const char *name = mpr_obj_get_prop_as_str((mpr_obj)sig, MPR_PROP_NAME, NULL);
     eprintf("%s: [ ", name);
     for (i = 0; i < n; i++) {
-        eprintf("%2i, ", ((mpr_local_sig)sig)->inst[i]->idx);
+        eprintf("%2i, ", ((mpr_local_sig)sig)->inst_order[i]);
     }
     if (i)
         eprintf("\b\b ");
@@ -416,6 +427,35 @@ void loop(instance_type src_type, instance_type dst_type)
     }
 }
 
+/* Count the active id maps of a device's first signal group by walking its LID index,
+ * optionally printing each one. */
+int count_active_idmaps(mpr_local_dev dev, int print)
+{
+    int i, count = 0;
+    mpr_id_map_index idx = &dev->idmaps.active[0];
+    for (i = 0; i < idx->size; i++) {
+        mpr_id_map id_map = idx->by_LID[i];
+        if (!id_map)
+            continue;
+        ++count;
+        if (print)
+            printf("  LID*%d: %"PR_MPR_ID", GID*%d: %"PR_MPR_ID"\n", id_map->LID_refcount,
+                   id_map->LID, id_map->GID_refcount, id_map->GID);
+    }
+    return count;
+}
+
+int count_reserve_idmaps(mpr_local_dev dev)
+{
+    int count = 0;
+    mpr_id_map id_map = dev->idmaps.reserve;
+    while (id_map) {
+        ++count;
+        id_map = id_map->next;
+    }
+    return count;
+}
+
 void ctrlc(int sig)
 {
     done = 1;
@@ -428,7 +468,6 @@ int run_test(test_config *config)
     int num_src = 1, stl, evt = MPR_SIG_UPDATE, use_inst, compare_count;
     int result = 0, active_count = 0, reserve_count = 0, count_epsilon;
     mpr_map map;
-    mpr_id_map *id_map;
 
     both_src[0] = monosend;
     both_src[1] = multisend;
@@ -549,48 +588,31 @@ int run_test(test_config *config)
         ++result;
     }
 
-    id_map = &((mpr_local_dev)src)->idmaps.active[0];
-    while (*id_map) {
-        ++active_count;
-        id_map = &(*id_map)->next;
-    }
-    id_map = &((mpr_local_dev)src)->idmaps.reserve;
-    while (*id_map) {
-        ++reserve_count;
-        id_map = &(*id_map)->next;
+    active_count = count_active_idmaps((mpr_local_dev)src, 0);
+    reserve_count = count_reserve_idmaps((mpr_local_dev)src);
+    if (active_count != ((mpr_local_dev)src)->idmaps.active[0].count) {
+        printf("Error: src device id map index holds %d id maps but counts %d\n",
+               active_count, ((mpr_local_dev)src)->idmaps.active[0].count);
+        ++result;
     }
     if (active_count > 1 || reserve_count > 5) {
         printf("Error: src device using %d active and %d reserve id maps (should be 0 and <=10)\n",
                active_count, reserve_count);
-        id_map = &((mpr_local_dev)src)->idmaps.active[0];
-        while (*id_map) {
-            printf("  LID*%d: %"PR_MPR_ID", GID*%d: %"PR_MPR_ID"\n", (*id_map)->LID_refcount,
-                   (*id_map)->LID, (*id_map)->GID_refcount, (*id_map)->GID);
-            id_map = &(*id_map)->next;
-        }
+        count_active_idmaps((mpr_local_dev)src, 1);
         ++result;
     }
 
-    active_count = reserve_count = 0;
-    id_map = &((mpr_local_dev)dst)->idmaps.active[0];
-    while (*id_map) {
-        ++active_count;
-        id_map = &(*id_map)->next;
-    }
-    id_map = &((mpr_local_dev)dst)->idmaps.reserve;
-    while (*id_map) {
-        ++reserve_count;
-        id_map = &(*id_map)->next;
+    active_count = count_active_idmaps((mpr_local_dev)dst, 0);
+    reserve_count = count_reserve_idmaps((mpr_local_dev)dst);
+    if (active_count != ((mpr_local_dev)dst)->idmaps.active[0].count) {
+        printf("Error: dst device id map index holds %d id maps but counts %d\n",
+               active_count, ((mpr_local_dev)dst)->idmaps.active[0].count);
+        ++result;
     }
     if (active_count > 1 || reserve_count >= 10) {
         printf("Error: dst device using %d active and %d reserve id maps (should be 0 and <10)\n",
                active_count, reserve_count);
-        id_map = &((mpr_local_dev)dst)->idmaps.active[0];
-        while (*id_map) {
-            printf("  LID*%d: %"PR_MPR_ID", GID*%d: %"PR_MPR_ID"\n", (*id_map)->LID_refcount,
-                   (*id_map)->LID, (*id_map)->GID_refcount, (*id_map)->GID);
-            id_map = &(*id_map)->next;
-        }
+        count_active_idmaps((mpr_local_dev)dst, 1);
         ++result;
     }
 
@@ -623,6 +645,107 @@ int run_test(test_config *config)
     return result;
 }
 
+/* Handler that reserves another instance on every update, so that the signal's instance storage
+ * grows while the update is being handled. */
+int reserve_errors = 0;
+void reserve_handler(mpr_sig sig, mpr_sig_evt e, mpr_id inst, int len, mpr_type type,
+                     const void *val, mpr_time t)
+{
+    float before;
+    if (!val) {
+        mpr_sig_release_inst(sig, inst);
+        return;
+    }
+    before = *(float*)val;
+    if (mpr_sig_get_num_inst(sig, MPR_STATUS_ALL) < 64)
+        mpr_sig_reserve_inst(sig, 1, 0, 0);
+    if (*(float*)val != before) {
+        eprintf("value of instance %i changed while reserving instances\n", (int)inst);
+        ++reserve_errors;
+    }
+    ++received;
+}
+
+/* Reserve instances from within an update handler, then remove them and check that their
+ * indices are reused by new reservations. */
+int run_reserve_test()
+{
+    int i, j, num_inst, result = 0, stl = MPR_STEAL_NONE, use_inst = 1;
+    float valf;
+    mpr_map map;
+
+    eprintf("Reserving instances from within the update handler\n");
+    if (!verbose) {
+        printf("Reserving instances from within the update handler");
+        fflush(stdout);
+    }
+
+    mpr_obj_set_prop((mpr_obj)multirecv, MPR_PROP_STEAL_MODE, NULL, 1, MPR_INT32, &stl, 1);
+    mpr_sig_set_cb(multirecv, reserve_handler, MPR_SIG_UPDATE);
+    map = mpr_map_new(1, &multisend, 1, &multirecv);
+    mpr_obj_set_prop((mpr_obj)map, MPR_PROP_USE_INST, NULL, 1, MPR_BOOL, &use_inst, 1);
+    mpr_obj_push((mpr_obj)map);
+    while (!done && !mpr_map_get_is_ready(map)) {
+        mpr_dev_poll(src, 100);
+        mpr_dev_poll(dst, 100);
+    }
+
+    received = 0;
+    reserve_errors = 0;
+    for (i = 0; i < 20 && !done; i++) {
+        for (j = 0; j < 3; j++) {
+            valf = i * 10 + j;
+            mpr_sig_set_value(multisend, j, 1, MPR_FLT, &valf);
+        }
+        mpr_dev_poll(src, 0);
+        mpr_dev_poll(dst, period);
+    }
+    release_active_instances(multisend);
+    mpr_map_release(map);
+    mpr_dev_poll(src, 100);
+    mpr_dev_poll(dst, 100);
+    release_active_instances(multirecv);
+
+    num_inst = mpr_sig_get_num_inst(multirecv, MPR_STATUS_ALL);
+    eprintf("Received %d updates, destination has %d instances\n", received, num_inst);
+    if (!received || num_inst <= 8 || reserve_errors)
+        ++result;
+
+    /* remove the added instances and reserve some more in their place */
+    while (5 <= mpr_sig_get_num_inst(multirecv, MPR_STATUS_ALL))
+        mpr_sig_remove_inst(multirecv, mpr_sig_get_inst_id(multirecv, 4, MPR_STATUS_ALL));
+    num_inst = ((mpr_local_sig)multirecv)->num_inst_idx;
+    mpr_sig_reserve_inst(multirecv, 4, 0, 0);
+    if (mpr_sig_get_num_inst(multirecv, MPR_STATUS_ALL) != 8) {
+        printf("Error: reserved %d instances (should be 8)\n",
+               mpr_sig_get_num_inst(multirecv, MPR_STATUS_ALL));
+        ++result;
+    }
+    if (((mpr_local_sig)multirecv)->num_inst_idx != num_inst) {
+        printf("Error: reserving instances used %d new indices instead of reusing removed ones\n",
+               ((mpr_local_sig)multirecv)->num_inst_idx - num_inst);
+        ++result;
+    }
+    for (i = 1; i < 8; i++) {
+        if (mpr_sig_get_inst_id(multirecv, i, MPR_STATUS_ALL)
+            <= mpr_sig_get_inst_id(multirecv, i - 1, MPR_STATUS_ALL)) {
+            printf("Error: instance ids are not in ascending order.\n");
+            ++result;
+            break;
+        }
+    }
+    while (5 <= mpr_sig_get_num_inst(multirecv, MPR_STATUS_ALL))
+        mpr_sig_remove_inst(multirecv, mpr_sig_get_inst_id(multirecv, 4, MPR_STATUS_ALL));
+
+    if (!verbose) {
+        if (result)
+            printf(" ...... \x1B[31mFAILED\x1B[0m.\n");
+        else
+            printf(" ...... \x1B[32mPASSED\x1B[0m.\n");
+    }
+    return result;
+}
+
 int main(int argc, char **argv)
 {
     int i, j, result = 0;
@@ -694,6 +817,8 @@ int main(int argc, char **argv)
         }
         ++i;
     }
+    if (!result && !done)
+        result = run_reserve_test();
 
   done:
     cleanup_dst();
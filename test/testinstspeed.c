@@ -0,0 +1,296 @@
+#include <mapper/mapper.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdarg.h>
+#include <string.h>
+#include <signal.h>
+#include <sys/time.h>
+
+/* Benchmark of signal instance storage: times reserving, updating and reading back a large
+ * number of instances. Also checks that a batch update of a mapped signal reaches every
+ * destination instance. */
+
+#define VEC_LEN 3
+#define NUM_MAPPED 100
+
+int verbose = 1;
+int terminate = 0;
+int done = 0;
+int col = 0;
+int num_inst = 10000;
+
+mpr_dev dev = 0;
+mpr_dev recv_dev = 0;
+mpr_sig sig = 0;
+mpr_sig mapped_sig = 0;
+mpr_sig recv_sig = 0;
+int received = 0;
+
+static void eprintf(const char *format, ...)
+{
+    va_list args;
+    if (!verbose) {
+        if (col >= 50)
+            printf("\33[2K\r");
+        fprintf(stdout, ".");
+        ++col;
+        return;
+    }
+    va_start(args, format);
+    vprintf(format, args);
+    fflush(stdout);
+    va_end(args);
+}
+
+/*! Internal function to get the current time. */
+static double current_time()
+{
+    struct timeval tv;
+    gettimeofday(&tv, NULL);
+    return tv.tv_sec + tv.tv_usec / 1000000.0;
+}
+
+void handler(mpr_sig sig, mpr_sig_evt e, mpr_id inst, int len, mpr_type type,
+             const void *val, mpr_time t)
+{
+    if (val && ((const float*)val)[0] == -(int)inst)
+        ++received;
+}
+
+int setup_dev(const char *iface)
+{
+    int num_mapped = NUM_MAPPED;
+    dev = mpr_dev_new("testinstspeed", 0);
+    recv_dev = mpr_dev_new("testinstspeed-recv", 0);
+    if (!dev || !recv_dev)
+        goto error;
+    if (iface) {
+        mpr_graph_set_interface(mpr_obj_get_graph(dev), iface);
+        mpr_graph_set_interface(mpr_obj_get_graph(recv_dev), iface);
+    }
+    eprintf("devices created using interface %s.\n",
+            mpr_graph_get_interface(mpr_obj_get_graph(dev)));
+
+    mapped_sig = mpr_sig_new(dev, MPR_DIR_OUT, "mapped", VEC_LEN, MPR_FLT, NULL,
+                             NULL, NULL, &num_mapped, NULL, 0);
+    recv_sig = mpr_sig_new(recv_dev, MPR_DIR_IN, "insig", VEC_LEN, MPR_FLT, NULL,
+                           NULL, NULL, &num_mapped, handler, MPR_SIG_UPDATE);
+    if (!mapped_sig || !recv_sig)
+        goto error;
+    return 0;
+
+error:
+    return 1;
+}
+
+void cleanup_dev()
+{
+    if (dev) {
+        eprintf("Freeing device.. ");
+        fflush(stdout);
+        mpr_dev_free(dev);
+        eprintf("ok\n");
+    }
+    if (recv_dev) {
+        eprintf("Freeing receiving device.. ");
+        fflush(stdout);
+        mpr_dev_free(recv_dev);
+        eprintf("ok\n");
+    }
+}
+
+void wait_ready()
+{
+    while (!done && !(mpr_dev_get_is_ready(dev) && mpr_dev_get_is_ready(recv_dev))) {
+        mpr_dev_poll(dev, 10);
+        mpr_dev_poll(recv_dev, 10);
+    }
+}
+
+int setup_map()
+{
+    mpr_map map = mpr_map_new(1, &mapped_sig, 1, &recv_sig);
+    mpr_obj_push((mpr_obj)map);
+    while (!done && !mpr_map_get_is_ready(map)) {
+        mpr_dev_poll(dev, 10);
+        mpr_dev_poll(recv_dev, 10);
+    }
+    return done;
+}
+
+/* Update all instances of a mapped signal in one batch and count the updates received. */
+int run_mapped_batch()
+{
+    int i, j, result = 0;
+    mpr_id ids[NUM_MAPPED];
+    float vals[NUM_MAPPED * VEC_LEN];
+
+    for (i = 0; i < NUM_MAPPED; i++) {
+        ids[i] = i;
+        for (j = 0; j < VEC_LEN; j++)
+            vals[i * VEC_LEN + j] = -(i + j);
+    }
+    received = 0;
+    mpr_sig_set_values(mapped_sig, NUM_MAPPED, ids, VEC_LEN, MPR_FLT, vals);
+    mpr_dev_poll(dev, 0);
+    for (i = 0; i < 10 && received < NUM_MAPPED && !done; i++)
+        mpr_dev_poll(recv_dev, 10);
+
+    eprintf("Mapped batch update of %d instances: received %d updates.\n", NUM_MAPPED, received);
+    if (received != NUM_MAPPED)
+        result = 1;
+    for (i = 0; i < NUM_MAPPED; i++)
+        mpr_sig_release_inst(mapped_sig, ids[i]);
+    mpr_dev_poll(dev, 0);
+    mpr_dev_poll(recv_dev, 10);
+    return result;
+}
+
+int run_trial()
+{
+    int i, j, result = 0;
+    float val[VEC_LEN];
+    float *vals;
+    mpr_id *ids;
+    double then, t_reserve, t_update, t_read, t_batch;
+
+    /* reserve instances */
+    then = current_time();
+    sig = mpr_sig_new(dev, MPR_DIR_OUT, "outsig", VEC_LEN, MPR_FLT, NULL,
+                      NULL, NULL, &num_inst, NULL, 0);
+    t_reserve = current_time() - then;
+    if (!sig || mpr_sig_get_num_inst(sig, MPR_STATUS_ALL) != num_inst) {
+        eprintf("Error reserving %d instances.\n", num_inst);
+        return 1;
+    }
+
+    /* activate and update every instance */
+    then = current_time();
+    for (i = 0; i < num_inst && !done; i++) {
+        for (j = 0; j < VEC_LEN; j++)
+            val[j] = i + j;
+        mpr_sig_set_value(sig, i, VEC_LEN, MPR_FLT, val);
+    }
+    t_update = current_time() - then;
+    if (mpr_sig_get_num_inst(sig, MPR_STATUS_ACTIVE) != num_inst) {
+        eprintf("Expected %d active instances, found %d.\n", num_inst,
+                mpr_sig_get_num_inst(sig, MPR_STATUS_ACTIVE));
+        result = 1;
+    }
+
+    /* read back values */
+    then = current_time();
+    for (i = 0; i < num_inst && !done && !result; i++) {
+        const float *f = (const float*)mpr_sig_get_value(sig, i, 0);
+        if (!f || f[0] != i || f[VEC_LEN - 1] != i + VEC_LEN - 1) {
+            eprintf("Bad value for instance %d.\n", i);
+            result = 1;
+        }
+    }
+    t_read = current_time() - then;
+
+    /* update every instance again in a single batch */
+    ids = (mpr_id*)malloc(sizeof(mpr_id) * num_inst);
+    vals = (float*)malloc(sizeof(float) * num_inst * VEC_LEN);
+    for (i = 0; i < num_inst; i++) {
+        ids[i] = i;
+        for (j = 0; j < VEC_LEN; j++)
+            vals[i * VEC_LEN + j] = -(i + j);
+    }
+    then = current_time();
+    mpr_sig_set_values(sig, num_inst, ids, VEC_LEN, MPR_FLT, vals);
+    t_batch = current_time() - then;
+    for (i = 0; i < num_inst && !done && !result; i++) {
+        const float *f = (const float*)mpr_sig_get_value(sig, i, 0);
+        if (!f || f[0] != -i || f[VEC_LEN - 1] != -(i + VEC_LEN - 1)) {
+            eprintf("Bad batch value for instance %d.\n", i);
+            result = 1;
+        }
+    }
+    free(ids);
+    free(vals);
+
+    eprintf("%d instances: reserve %f s, update %f s, read %f s, batch update %f s\n",
+            num_inst, t_reserve, t_update, t_read, t_batch);
+
+    mpr_sig_free(sig);
+    sig = 0;
+    mpr_dev_poll(dev, 0);
+    return result;
+}
+
+void ctrlc(int sig)
+{
+    done = 1;
+}
+
+int main(int argc, char **argv)
+{
+    int i, j, result = 0;
+    char *iface = 0;
+
+    /* process flags for -v verbose, -t terminate, -h help */
+    for (i = 1; i < argc; i++) {
+        if (argv[i] && argv[i][0] == '-') {
+            int len = strlen(argv[i]);
+            for (j = 1; j < len; j++) {
+                switch (argv[i][j]) {
+                    case 'h':
+                        printf("testinstspeed.c: possible arguments "
+                               "-q quiet (suppress output), "
+                               "-t terminate automatically, "
+                               "-f fast (execute quickly), "
+                               "-h help, "
+                               "--iface network interface\n");
+                        return 1;
+                        break;
+                    case 'f':
+                        num_inst = 1000;
+                        break;
+                    case 'q':
+                        verbose = 0;
+                        break;
+                    case 't':
+                        terminate = 1;
+                        break;
+                    case '-':
+                        if (strcmp(argv[i], "--iface")==0 && argc>i+1) {
+                            i++;
+                            iface = argv[i];
+                            j = 1;
+                        }
+                        break;
+                    default:
+                        break;
+                }
+            }
+        }
+    }
+
+    signal(SIGINT, ctrlc);
+
+    if (setup_dev(iface)) {
+        eprintf("Error initializing device.\n");
+        result = 1;
+        goto done;
+    }
+
+    wait_ready();
+
+    if (setup_map()) {
+        eprintf("Error initializing map.\n");
+        result = 1;
+        goto done;
+    }
+
+    do {
+        result = run_trial();
+        result += run_mapped_batch();
+    } while (!terminate && !done && !result);
+
+done:
+    cleanup_dev();
+    printf("\r..................................................Test %s\x1B[0m.\n",
+           result ? "\x1B[31mFAILED" : "\x1B[32mPASSED");
+    return result;
+}
@@ -248,6 +248,33 @@ int main(int argc, char **argv)
     }
 
     /*****/
+
+    eprintf("4: looking up property keys\n");
+
+    for (i = MPR_PROP_UNKNOWN + 0x0100; i < MPR_PROP_EXTRA; i += 0x0100) {
+        const char *key = mpr_prop_as_str(i, 1);
+        if (mpr_prop_from_str(key) != i) {
+            eprintf("4: Property key '%s' was not found.\n", key);
+            result = 1;
+            goto done;
+        }
+    }
+    if (   mpr_prop_from_str("expression") != MPR_PROP_EXPR
+        || mpr_prop_from_str("maximum") != MPR_PROP_MAX
+        || mpr_prop_from_str("minimum") != MPR_PROP_MIN) {
+        eprintf("4: Property alias was not found.\n");
+        result = 1;
+        goto done;
+    }
+    if (   mpr_prop_from_str("foo") != MPR_PROP_EXTRA
+        || mpr_prop_from_str("") != MPR_PROP_EXTRA
+        || mpr_prop_from_str("types") != MPR_PROP_EXTRA) {
+        eprintf("4: Unknown property key was not treated as extra.\n");
+        result = 1;
+        goto done;
+    }
+
+    /*****/
 done:
     mpr_msg_free(msg);
     if (!verbose)
@@ -0,0 +1,206 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdarg.h>
+#include <string.h>
+#include <sys/time.h>
+#include <lo/lo.h>
+#include "../src/types_internal.h"
+#include "../src/mapper_internal.h"
+
+/* Benchmark of admin message parsing: replays a trace of the admin messages exchanged when
+ * devices announce themselves and map their signals, parsing the properties of each message
+ * into heap-allocated and stack-allocated structures. */
+
+int verbose = 1;
+int iterations = 100000;
+
+/* The trace lists the path, the OSC types and the arguments of each message, one argument per
+ * word. Boolean arguments have no word. The offset is the number of leading arguments that the
+ * handler of the message skips before parsing properties. */
+typedef struct {
+    const char *path;
+    int offset;
+    const char *types;
+    const char *args;
+} trace_msg_t;
+
+static const trace_msg_t trace[] = {
+    { "/device", 1, "ssssisisisisisisssssish",
+      "testsend.1 @host 192.168.1.20 @num_maps_in 0 @num_maps_out 1 @num_sigs_in 0 "
+      "@num_sigs_out 2 @ordinal 1 @port 9012 @lib_version 2.4.5 @linked testrecv.1 "
+      "@version 7 @id 8734562891" },
+    { "/signal", 1, "sssscsisfsfssshsisT",
+      "testsend.1/outsig @direction output @type f @length 1 @min 0.0 @max 1.0 @unit Hz "
+      "@id 8734562892 @num_instances 1 @use_inst" },
+    { "/signal", 1, "sssscsisffffsffffssshsisFsi",
+      "testsend.1/position @direction output @type f @length 4 @min 0.0 -1.0 -1.0 -1.0 "
+      "@max 1.0 1.0 1.0 1.0 @unit m @id 8734562893 @num_instances 1 @use_inst @tag 12" },
+    { "/device", 1, "ssssisisisisisisssish",
+      "testrecv.1 @host 192.168.1.21 @num_maps_in 1 @num_maps_out 0 @num_sigs_in 1 "
+      "@num_sigs_out 0 @ordinal 1 @port 9014 @lib_version 2.4.5 @version 4 @id 9871234561" },
+    { "/signal", 1, "sssscsisfsfssshsisF",
+      "testrecv.1/insig @direction input @type f @length 1 @min 0.0 @max 10.0 @unit Hz "
+      "@id 9871234562 @num_instances 1 @use_inst" },
+    { "/mapped", 0, "sssssshssssssscsisfsfsisisFsi",
+      "testsend.1/outsig -> testrecv.1/insig @expr y=x*10 @id 8734562894 @process_loc src "
+      "@protocol osc.udp @scope testsend.1 @src@type f @src@length 1 @src@min 0.0 @dst@max 10.0 "
+      "@status 3 @version 2 @muted @num_inst 1" },
+    { "/signal/modify", 1, "ssssf", "testsend.1/outsig @unit Hz @rate 100.0" },
+};
+
+#define NUM_TRACE_MSGS (sizeof(trace) / sizeof(trace[0]))
+
+lo_message msgs[NUM_TRACE_MSGS];
+
+static void eprintf(const char *format, ...)
+{
+    va_list args;
+    if (!verbose)
+        return;
+    va_start(args, format);
+    vprintf(format, args);
+    va_end(args);
+}
+
+static double current_time()
+{
+    struct timeval tv;
+    gettimeofday(&tv, NULL);
+    return (double)tv.tv_sec + tv.tv_usec / 1000000.0;
+}
+
+static lo_message build_msg(const trace_msg_t *t)
+{
+    char *args = strdup(t->args), *word = strtok(args, " ");
+    const char *type;
+    lo_message msg = lo_message_new();
+    for (type = t->types; *type; type++) {
+        if ('T' == *type) {
+            lo_message_add_true(msg);
+            continue;
+        }
+        else if ('F' == *type) {
+            lo_message_add_false(msg);
+            continue;
+        }
+        if (!word) {
+            eprintf("Trace message %s is missing arguments.\n", t->path);
+            lo_message_free(msg);
+            msg = 0;
+            break;
+        }
+        switch (*type) {
+            case 's':   lo_message_add_string(msg, word);           break;
+            case 'c':   lo_message_add_char(msg, word[0]);          break;
+            case 'i':   lo_message_add_int32(msg, atoi(word));      break;
+            case 'h':   lo_message_add_int64(msg, atoll(word));     break;
+            case 'f':   lo_message_add_float(msg, atof(word));      break;
+            default:                                                break;
+        }
+        word = strtok(NULL, " ");
+    }
+    if (msg && word) {
+        eprintf("Trace message %s has too many arguments.\n", t->path);
+        lo_message_free(msg);
+        msg = 0;
+    }
+    free(args);
+    return msg;
+}
+
+static int parse(int i, mpr_msg_t *buf)
+{
+    int num_atoms, offset = trace[i].offset;
+    int argc = lo_message_get_argc(msgs[i]) - offset;
+    const char *types = lo_message_get_types(msgs[i]) + offset;
+    lo_arg **argv = lo_message_get_argv(msgs[i]) + offset;
+    mpr_msg props;
+    if (buf)
+        props = mpr_msg_parse_props_into(buf, argc, types, argv);
+    else
+        props = mpr_msg_parse_props(argc, types, argv);
+    num_atoms = props ? props->num_atoms : 0;
+    mpr_msg_free(props);
+    return num_atoms;
+}
+
+static int check_trace()
+{
+    int i, j, counts[2];
+    mpr_msg_t buf;
+    for (i = 0; i < NUM_TRACE_MSGS; i++) {
+        for (j = 0; j < 2; j++)
+            counts[j] = parse(i, j ? &buf : 0);
+        if (!counts[0] || counts[0] != counts[1]) {
+            eprintf("Message %d (%s) parsed into %d and %d properties.\n", i, trace[i].path,
+                    counts[0], counts[1]);
+            return 1;
+        }
+    }
+    return 0;
+}
+
+static void run_mode(const char *label, mpr_msg_t *buf)
+{
+    int i, n, count = 0;
+    double then = current_time(), elapsed;
+    for (n = 0; n < iterations; n++) {
+        for (i = 0; i < NUM_TRACE_MSGS; i++)
+            count += parse(i, buf);
+    }
+    elapsed = current_time() - then;
+    eprintf("%-8s %d messages (%d properties) in %f seconds (%.1f ns/message)\n", label,
+            n * (int)NUM_TRACE_MSGS, count, elapsed, elapsed * 1e9 / (n * NUM_TRACE_MSGS));
+}
+
+int main(int argc, char **argv)
+{
+    int i, j, result = 0;
+    mpr_msg_t buf;
+
+    /* process flags for -v verbose, -f fast, -h help */
+    for (i = 1; i < argc; i++) {
+        if (argv[i] && argv[i][0] == '-') {
+            int len = strlen(argv[i]);
+            for (j = 1; j < len; j++) {
+                switch (argv[i][j]) {
+                    case 'h':
+                        printf("testparsespeed.c: possible arguments "
+                               "-f fast (execute quickly), "
+                               "-q quiet (suppress output), "
+                               "-h help\n");
+                        return 1;
+                        break;
+                    case 'f':
+                        iterations = 1000;
+                        break;
+                    case 'q':
+                        verbose = 0;
+                        break;
+                    default:
+                        break;
+                }
+            }
+        }
+    }
+
+    for (i = 0; i < NUM_TRACE_MSGS; i++) {
+        if (!(msgs[i] = build_msg(&trace[i])))
+            result = 1;
+    }
+    if (result || (result = check_trace()))
+        goto done;
+
+    run_mode("heap", 0);
+    run_mode("stack", &buf);
+
+done:
+    for (i = 0; i < NUM_TRACE_MSGS; i++) {
+        if (msgs[i])
+            lo_message_free(msgs[i]);
+    }
+    if (!verbose)
+        printf("..................................................");
+    printf("Test %s\x1B[0m.\n", result ? "\x1B[31mFAILED" : "\x1B[32mPASSED");
+    return result;
+}
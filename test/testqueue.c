@@ -0,0 +1,258 @@
+#include <mapper/mapper.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdarg.h>
+#include <unistd.h>
+#include <string.h>
+#include <signal.h>
+
+#include <pthread.h>
+
+#if defined(WIN32) || defined(_MSC_VER)
+#define SLEEP_MS(x) Sleep(x)
+#else
+#define SLEEP_MS(x) usleep((x)*1000)
+#endif
+
+/* Tests queueing signal updates from another thread: updates must be applied in order by the
+ * polling thread, vectors filling a whole queue slot must survive the hand-over, values too
+ * large for a slot must be rejected, queued releases must release their instances, and a full
+ * queue must reject updates rather than overwrite pending ones. */
+
+#define VEC_LEN 32
+#define BIG_LEN 64
+#define NUM_INST 4
+
+int verbose = 1;
+int num_updates = 10000;
+
+mpr_dev dev = 0;
+mpr_sig scalar = 0;
+mpr_sig vector = 0;
+mpr_sig big = 0;
+
+int last_vec_val[NUM_INST];
+volatile sig_atomic_t producing = 1;
+
+static void eprintf(const char *format, ...)
+{
+    va_list args;
+    if (!verbose)
+        return;
+    va_start(args, format);
+    vprintf(format, args);
+    va_end(args);
+}
+
+int setup_dev()
+{
+    int num_inst = NUM_INST;
+
+    dev = mpr_dev_new("testqueue", 0);
+    if (!dev)
+        goto error;
+
+    scalar = mpr_sig_new(dev, MPR_DIR_OUT, "scalar", 1, MPR_INT32, NULL,
+                         NULL, NULL, NULL, NULL, 0);
+    vector = mpr_sig_new(dev, MPR_DIR_OUT, "vector", VEC_LEN, MPR_FLT, NULL,
+                         NULL, NULL, &num_inst, NULL, 0);
+    big = mpr_sig_new(dev, MPR_DIR_OUT, "big", BIG_LEN, MPR_FLT, NULL,
+                      NULL, NULL, NULL, NULL, 0);
+    if (!scalar || !vector || !big)
+        goto error;
+    eprintf("Signals registered.\n");
+    return 0;
+
+  error:
+    return 1;
+}
+
+void cleanup_dev()
+{
+    if (dev) {
+        eprintf("Freeing device.. ");
+        fflush(stdout);
+        mpr_dev_free(dev);
+        eprintf("ok\n");
+    }
+}
+
+/* Queue an update, retrying while the queue is full. */
+static void queue(mpr_sig sig, mpr_id inst, int len, mpr_type type, const void *val)
+{
+    while (mpr_sig_queue_value(sig, inst, len, type, val, MPR_NOW))
+        SLEEP_MS(1);
+}
+
+#ifdef HAVE_WIN32_THREADS
+unsigned __stdcall update_thread(void *context)
+#else
+void *update_thread(void *context)
+#endif
+{
+    int i, j;
+    float vec[VEC_LEN];
+    for (i = 1; i <= num_updates; i++) {
+        queue(scalar, 0, 1, MPR_INT32, &i);
+        if (i % 10)
+            continue;
+        for (j = 0; j < VEC_LEN; j++)
+            vec[j] = i + j;
+        queue(vector, (i / 10) % NUM_INST, VEC_LEN, MPR_FLT, vec);
+        last_vec_val[(i / 10) % NUM_INST] = i;
+    }
+    /* release the last instance */
+    queue(vector, NUM_INST - 1, 0, MPR_FLT, NULL);
+    producing = 0;
+    return 0;
+}
+
+int check_values()
+{
+    int i, j, result = 0;
+    const int *ival = (const int*)mpr_sig_get_value(scalar, 0, 0);
+    if (!ival || *ival != num_updates) {
+        eprintf("Scalar value is %d, expected %d.\n", ival ? *ival : -1, num_updates);
+        ++result;
+    }
+    for (i = 0; i < NUM_INST; i++) {
+        const float *fval = (const float*)mpr_sig_get_value(vector, i, 0);
+        if (i == NUM_INST - 1) {
+            if (fval) {
+                eprintf("Vector instance %d was not released.\n", i);
+                ++result;
+            }
+            continue;
+        }
+        for (j = 0; j < VEC_LEN; j++) {
+            if (!fval || fval[j] != last_vec_val[i] + j) {
+                eprintf("Vector instance %d element %d is %f, expected %d.\n", i, j,
+                        fval ? fval[j] : -1.f, last_vec_val[i] + j);
+                ++result;
+                break;
+            }
+        }
+    }
+    return result;
+}
+
+int run_producer()
+{
+#ifdef HAVE_WIN32_THREADS
+    HANDLE thread;
+    if (!(thread=(HANDLE)_beginthreadex(NULL, 0, &update_thread, 0, 0, NULL)))
+#else
+    pthread_t thread;
+    if (pthread_create(&thread, 0, update_thread, 0))
+#endif
+    {
+        perror("pthread_create");
+        return 1;
+    }
+
+    while (producing)
+        mpr_dev_poll(dev, 0);
+
+#ifdef HAVE_WIN32_THREADS
+    WaitForSingleObject(thread, INFINITE);
+    CloseHandle(thread);
+#else
+    pthread_join(thread, NULL);
+#endif
+    mpr_dev_poll(dev, 0);
+
+    eprintf("Queued %d updates from another thread.\n", num_updates);
+    return check_values();
+}
+
+int fill_queue()
+{
+    int i, accepted = 0, last = 0;
+    const int *ival;
+    for (i = 1; i <= 1000; i++) {
+        if (!mpr_sig_queue_value(scalar, 0, 1, MPR_INT32, &i, MPR_NOW)) {
+            ++accepted;
+            last = i;
+        }
+    }
+    eprintf("Queue accepted %d of %d updates without polling.\n", accepted, i - 1);
+    if (!accepted || accepted == i - 1) {
+        eprintf("Expected the queue to accept some but not all updates.\n");
+        return 1;
+    }
+    mpr_dev_poll(dev, 0);
+    ival = (const int*)mpr_sig_get_value(scalar, 0, 0);
+    if (!ival || *ival != last) {
+        eprintf("Scalar value is %d after filling the queue, expected %d.\n",
+                ival ? *ival : -1, last);
+        return 1;
+    }
+    return 0;
+}
+
+int reject_large()
+{
+    int i;
+    float vec[BIG_LEN];
+    for (i = 0; i < BIG_LEN; i++)
+        vec[i] = i;
+    if (!mpr_sig_queue_value(big, 0, BIG_LEN, MPR_FLT, vec, MPR_NOW)) {
+        eprintf("Queue accepted a value too large for a slot.\n");
+        return 1;
+    }
+    mpr_dev_poll(dev, 0);
+    if (mpr_sig_get_value(big, 0, 0)) {
+        eprintf("Rejected value was applied.\n");
+        return 1;
+    }
+    eprintf("Queue rejected a value too large for a slot.\n");
+    return 0;
+}
+
+int main(int argc, char **argv)
+{
+    int i, j, result = 0;
+
+    /* process flags for -v verbose, -f fast, -h help */
+    for (i = 1; i < argc; i++) {
+        if (argv[i] && argv[i][0] == '-') {
+            int len = strlen(argv[i]);
+            for (j = 1; j < len; j++) {
+                switch (argv[i][j]) {
+                    case 'h':
+                        printf("testqueue.c: possible arguments "
+                               "-f fast (execute quickly), "
+                               "-q quiet (suppress output), "
+                               "-h help\n");
+                        return 1;
+                        break;
+                    case 'f':
+                        num_updates = 1000;
+                        break;
+                    case 'q':
+                        verbose = 0;
+                        break;
+                    default:
+                        break;
+                }
+            }
+        }
+    }
+
+    if (setup_dev()) {
+        eprintf("Error initializing device.\n");
+        result = 1;
+        goto done;
+    }
+
+    result = run_producer();
+    result += reject_large();
+    result += fill_queue();
+
+  done:
+    cleanup_dev();
+    if (!verbose)
+        printf("..................................................");
+    printf("Test %s\x1B[0m.\n", result ? "\x1B[31mFAILED" : "\x1B[32mPASSED");
+    return result;
+}
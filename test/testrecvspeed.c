@@ -0,0 +1,264 @@
+#include "../src/mapper_internal.h"
+#include <mapper/mapper.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdarg.h>
+#include <string.h>
+#include <signal.h>
+#include <sys/time.h>
+#include <lo/lo.h>
+
+/* Benchmark of the signal receive path alone: prebuilt update messages are passed directly to
+ * the signal handler, bypassing the network. */
+
+#define VEC_LEN 4
+#define NUM_MANY_INST 1024
+
+int verbose = 1;
+int terminate = 0;
+int done = 0;
+int col = 0;
+int iterations = 100000;
+
+mpr_dev dev = 0;
+mpr_sig vecsig = 0;
+mpr_sig instsig = 0;
+mpr_sig manysig = 0;
+
+int received = 0;
+float last_val = 0.f;
+
+typedef enum {
+    MODE_VECTOR,
+    MODE_INST,
+    MODE_COMPACT,
+    MODE_MANY_INST,
+    NUM_MODES
+} test_mode;
+
+const char *mode_names[] = {"vector", "instanced vector", "compact vector", "many instances"};
+
+static void eprintf(const char *format, ...)
+{
+    va_list args;
+    if (!verbose) {
+        if (col >= 50)
+            printf("\33[2K\r");
+        fprintf(stdout, ".");
+        ++col;
+        return;
+    }
+    va_start(args, format);
+    vprintf(format, args);
+    fflush(stdout);
+    va_end(args);
+}
+
+/*! Internal function to get the current time. */
+static double current_time()
+{
+    struct timeval tv;
+    gettimeofday(&tv, NULL);
+    return tv.tv_sec + tv.tv_usec / 1000000.0;
+}
+
+void handler(mpr_sig sig, mpr_sig_evt event, mpr_id instance, int length,
+             mpr_type type, const void *value, mpr_time t)
+{
+    if (value)
+        last_val = ((float*)value)[VEC_LEN - 1];
+    ++received;
+}
+
+int setup_dev(const char *iface)
+{
+    int num_inst = 4, num_many = NUM_MANY_INST;
+
+    dev = mpr_dev_new("testrecvspeed", 0);
+    if (!dev)
+        goto error;
+    if (iface)
+        mpr_graph_set_interface(mpr_obj_get_graph((mpr_obj)dev), iface);
+    eprintf("device created using interface %s.\n",
+            mpr_graph_get_interface(mpr_obj_get_graph((mpr_obj)dev)));
+
+    vecsig = mpr_sig_new(dev, MPR_DIR_IN, "vec", VEC_LEN, MPR_FLT, NULL,
+                         NULL, NULL, NULL, handler, MPR_SIG_UPDATE);
+    instsig = mpr_sig_new(dev, MPR_DIR_IN, "inst", VEC_LEN, MPR_FLT, NULL,
+                          NULL, NULL, &num_inst, handler, MPR_SIG_UPDATE);
+    manysig = mpr_sig_new(dev, MPR_DIR_IN, "many", VEC_LEN, MPR_FLT, NULL,
+                          NULL, NULL, &num_many, handler, MPR_SIG_UPDATE);
+    if (!vecsig || !instsig || !manysig)
+        goto error;
+
+    eprintf("Input signals /vec, /inst and /many registered.\n");
+    return 0;
+
+error:
+    return 1;
+}
+
+void cleanup_dev()
+{
+    if (dev) {
+        eprintf("Freeing device.. ");
+        fflush(stdout);
+        mpr_dev_free(dev);
+        eprintf("ok\n");
+    }
+}
+
+void wait_ready()
+{
+    while (!done && !mpr_dev_get_is_ready(dev))
+        mpr_dev_poll(dev, 10);
+}
+
+lo_message build_msg(test_mode mode, mpr_id id)
+{
+    int i;
+    float vals[VEC_LEN];
+    lo_message msg = lo_message_new();
+    if (!msg)
+        return 0;
+
+    for (i = 0; i < VEC_LEN; i++)
+        vals[i] = i;
+
+    if (MODE_COMPACT == mode) {
+        char data[sizeof(mpr_compact_hdr_t) + sizeof(vals)];
+        mpr_compact_hdr_t *hdr = (mpr_compact_hdr_t*)data;
+        lo_blob blob;
+        memset(hdr, 0, sizeof(mpr_compact_hdr_t));
+        hdr->flags = mpr_get_is_big_endian() ? MPR_COMPACT_BIG_ENDIAN : 0;
+        hdr->type = MPR_FLT;
+        hdr->len = VEC_LEN;
+        memcpy(data + sizeof(mpr_compact_hdr_t), vals, sizeof(vals));
+        blob = lo_blob_new(sizeof(data), data);
+        lo_message_add_blob(msg, blob);
+        lo_blob_free(blob);
+        return msg;
+    }
+
+    for (i = 0; i < VEC_LEN; i++)
+        lo_message_add_float(msg, vals[i]);
+    if (MODE_INST == mode || MODE_MANY_INST == mode) {
+        lo_message_add_string(msg, "@in");
+        lo_message_add_int64(msg, id);
+    }
+    return msg;
+}
+
+int run_mode(test_mode mode)
+{
+    int i, n, num_msgs = MODE_MANY_INST == mode ? NUM_MANY_INST : 1;
+    double elapsed;
+    mpr_sig sig = MODE_MANY_INST == mode ? manysig : MODE_INST == mode ? instsig : vecsig;
+    lo_message msgs[NUM_MANY_INST];
+    const char *types[NUM_MANY_INST];
+    lo_arg **argv[NUM_MANY_INST];
+    int argc[NUM_MANY_INST];
+
+    /* instanced messages use distinct global instance ids */
+    for (i = 0; i < num_msgs; i++) {
+        if (!(msgs[i] = build_msg(mode, 0x1234 + i))) {
+            eprintf("Error building message for mode '%s'.\n", mode_names[mode]);
+            while (--i >= 0)
+                lo_message_free(msgs[i]);
+            return 1;
+        }
+        types[i] = lo_message_get_types(msgs[i]);
+        argv[i] = lo_message_get_argv(msgs[i]);
+        argc[i] = lo_message_get_argc(msgs[i]);
+    }
+
+    received = 0;
+    last_val = 0.f;
+    elapsed = current_time();
+    for (n = 0; n < iterations && !done; n++) {
+        i = n % num_msgs;
+        mpr_dev_handler(NULL, types[i], argv[i], argc[i], msgs[i], (void*)sig);
+    }
+    elapsed = current_time() - elapsed;
+    for (i = 0; i < num_msgs; i++)
+        lo_message_free(msgs[i]);
+
+    eprintf("%-20s %d messages in %f seconds (%.1f ns/message)\n", mode_names[mode], n,
+            elapsed, elapsed * 1e9 / n);
+
+    if (received != n || last_val != VEC_LEN - 1) {
+        eprintf("Received %d of %d updates for mode '%s'.\n", received, n, mode_names[mode]);
+        return 1;
+    }
+    return 0;
+}
+
+void ctrlc(int sig)
+{
+    done = 1;
+}
+
+int main(int argc, char **argv)
+{
+    int i, j, result = 0;
+    char *iface = 0;
+
+    /* process flags for -v verbose, -t terminate, -h help */
+    for (i = 1; i < argc; i++) {
+        if (argv[i] && argv[i][0] == '-') {
+            int len = strlen(argv[i]);
+            for (j = 1; j < len; j++) {
+                switch (argv[i][j]) {
+                    case 'h':
+                        printf("testrecvspeed.c: possible arguments "
+                               "-q quiet (suppress output), "
+                               "-t terminate automatically, "
+                               "-f fast (execute quickly), "
+                               "-h help, "
+                               "--iface network interface\n");
+                        return 1;
+                        break;
+                    case 'f':
+                        iterations = 1000;
+                        break;
+                    case 'q':
+                        verbose = 0;
+                        break;
+                    case 't':
+                        terminate = 1;
+                        break;
+                    case '-':
+                        if (strcmp(argv[i], "--iface")==0 && argc>i+1) {
+                            i++;
+                            iface = argv[i];
+                            j = 1;
+                        }
+                        break;
+                    default:
+                        break;
+                }
+            }
+        }
+    }
+
+    signal(SIGINT, ctrlc);
+
+    if (setup_dev(iface)) {
+        eprintf("Error initializing device.\n");
+        result = 1;
+        goto done;
+    }
+
+    wait_ready();
+
+    do {
+        for (i = 0; i < NUM_MODES && !done && !result; i++)
+            result = run_mode(i);
+    } while (!terminate && !done && !result);
+
+done:
+    cleanup_dev();
+    printf("\r..................................................Test %s\x1B[0m.\n",
+           result ? "\x1B[31mFAILED" : "\x1B[32mPASSED");
+    return result;
+}
@@ -0,0 +1,326 @@
+#include "../src/mapper_internal.h"
+#include <mapper/mapper.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdarg.h>
+#include <string.h>
+#include <signal.h>
+#include <sys/time.h>
+#include <lo/lo.h>
+
+/* Updates a few elements of a long vector signal at a time through an element-wise map, checks
+ * that the destination reconstructs the whole vector, and compares the size of sparse update
+ * messages with updates carrying the whole vector. */
+
+#define VEC_LEN 64
+
+int verbose = 1;
+int terminate = 0;
+int done = 0;
+int col = 0;
+int iterations = 1000;
+
+mpr_dev src = 0;
+mpr_dev dst = 0;
+mpr_sig sendsig = 0;
+mpr_sig recvsig = 0;
+mpr_map map = 0;
+mpr_map src_map = 0;
+
+float sent_vec[VEC_LEN];
+float recv_vec[VEC_LEN];
+int received = 0;
+
+static void eprintf(const char *format, ...)
+{
+    va_list args;
+    if (!verbose) {
+        if (col >= 50)
+            printf("\33[2K\r");
+        fprintf(stdout, ".");
+        ++col;
+        return;
+    }
+    va_start(args, format);
+    vprintf(format, args);
+    fflush(stdout);
+    va_end(args);
+}
+
+/*! Internal function to get the current time. */
+static double current_time()
+{
+    struct timeval tv;
+    gettimeofday(&tv, NULL);
+    return tv.tv_sec + tv.tv_usec / 1000000.0;
+}
+
+void handler(mpr_sig sig, mpr_sig_evt event, mpr_id instance, int length,
+             mpr_type type, const void *value, mpr_time t)
+{
+    if (value) {
+        memcpy(recv_vec, value, sizeof(recv_vec));
+        ++received;
+    }
+}
+
+int setup_devs(const char *iface)
+{
+    src = mpr_dev_new("testsparse-send", 0);
+    dst = mpr_dev_new("testsparse-recv", 0);
+    if (!src || !dst)
+        goto error;
+    if (iface) {
+        mpr_graph_set_interface(mpr_obj_get_graph((mpr_obj)src), iface);
+        mpr_graph_set_interface(mpr_obj_get_graph((mpr_obj)dst), iface);
+    }
+    eprintf("devices created using interface %s.\n",
+            mpr_graph_get_interface(mpr_obj_get_graph((mpr_obj)src)));
+
+    sendsig = mpr_sig_new(src, MPR_DIR_OUT, "outsig", VEC_LEN, MPR_FLT, NULL,
+                          NULL, NULL, NULL, NULL, 0);
+    recvsig = mpr_sig_new(dst, MPR_DIR_IN, "insig", VEC_LEN, MPR_FLT, NULL,
+                          NULL, NULL, NULL, handler, MPR_SIG_UPDATE);
+    if (!sendsig || !recvsig)
+        goto error;
+    return 0;
+
+  error:
+    return 1;
+}
+
+void cleanup_devs()
+{
+    eprintf("Freeing devices.. ");
+    fflush(stdout);
+    if (src)
+        mpr_dev_free(src);
+    if (dst)
+        mpr_dev_free(dst);
+    eprintf("ok\n");
+}
+
+void wait_ready()
+{
+    while (!done && !(mpr_dev_get_is_ready(src) && mpr_dev_get_is_ready(dst))) {
+        mpr_dev_poll(src, 10);
+        mpr_dev_poll(dst, 10);
+    }
+}
+
+int setup_map()
+{
+    mpr_loc loc = MPR_LOC_SRC;
+    mpr_list maps;
+    map = mpr_map_new(1, &sendsig, 1, &recvsig);
+    /* an element-wise expression processed at the source */
+    mpr_obj_set_prop((mpr_obj)map, MPR_PROP_EXPR, NULL, 1, MPR_STR, "y=x*2", 1);
+    mpr_obj_set_prop((mpr_obj)map, MPR_PROP_PROCESS_LOC, NULL, 1, MPR_INT32, &loc, 1);
+    mpr_obj_push((mpr_obj)map);
+
+    while (!done && !mpr_map_get_is_ready(map)) {
+        mpr_dev_poll(src, 10);
+        mpr_dev_poll(dst, 10);
+    }
+    /* updates are processed by the copy of the map held by the source device */
+    maps = mpr_sig_get_maps(sendsig, MPR_DIR_OUT);
+    src_map = maps ? (mpr_map)*maps : 0;
+    mpr_list_free(maps);
+    if (!src_map || !((mpr_local_map)src_map)->dirty_elems) {
+        eprintf("Map is not tracking changed elements.\n");
+        return 1;
+    }
+    eprintf("Map initialized.\n");
+    return 0;
+}
+
+int check_received(const char *label)
+{
+    int i;
+    for (i = 0; i < VEC_LEN; i++) {
+        if (recv_vec[i] != sent_vec[i] * 2) {
+            eprintf("%s: element %d received %f, expected %f\n", label, i, recv_vec[i],
+                    sent_vec[i] * 2);
+            return 1;
+        }
+    }
+    return 0;
+}
+
+/* Compare the size of messages carrying a given number of changed elements, with and without
+ * the compact encoding. */
+int compare_sizes()
+{
+    int i, j, num_changed[] = {1, 4, 16, VEC_LEN};
+    mpr_local_map lmap = (mpr_local_map)src_map;
+    mpr_link link = lmap->dst->link;
+    uint8_t compact = link->compact;
+    const char *path = recvsig->path;
+    mpr_type types[VEC_LEN];
+    size_t full[2], sparse[2];
+    lo_message msg;
+
+    eprintf("%8s %12s %12s %14s %14s\n", "changed", "osc full", "osc sparse", "compact full",
+            "compact sparse");
+    for (i = 0; i < (int)(sizeof(num_changed) / sizeof(int)); i++) {
+        for (j = 0; j < 2; j++) {
+            link->compact = j;
+
+            memset(types, MPR_FLT, VEC_LEN);
+            msg = mpr_map_build_msg(lmap, lmap->src[0], sent_vec, types, 0);
+            full[j] = lo_message_length(msg, path);
+            lo_message_free(msg);
+
+            memset(types, MPR_NULL, VEC_LEN);
+            memset(types, MPR_FLT, num_changed[i]);
+            msg = mpr_map_build_msg(lmap, lmap->src[0], sent_vec, types, 0);
+            sparse[j] = lo_message_length(msg, path);
+            lo_message_free(msg);
+        }
+        eprintf("%8d %12d %12d %14d %14d\n", num_changed[i], (int)full[0], (int)sparse[0],
+                (int)full[1], (int)sparse[1]);
+        if (num_changed[i] < VEC_LEN / 4 && (sparse[0] >= full[0] || sparse[1] >= full[1])) {
+            eprintf("Sparse update is not smaller than full update.\n");
+            link->compact = compact;
+            return 1;
+        }
+    }
+    link->compact = compact;
+    return 0;
+}
+
+/* Time updates of a single element, sent either as a whole vector or as a sparse update. */
+int run_updates(int use_elements)
+{
+    int i, idx, last_received;
+    float val;
+    double elapsed = current_time();
+    const char *label = use_elements ? "sparse" : "full";
+
+    for (i = 0; i < iterations && !done; i++) {
+        idx = (i * 7) % VEC_LEN;
+        val = i;
+        sent_vec[idx] = val;
+        if (use_elements)
+            mpr_sig_set_elements(sendsig, 0, 1, &idx, MPR_FLT, &val);
+        else
+            mpr_sig_set_value(sendsig, 0, VEC_LEN, MPR_FLT, sent_vec);
+        mpr_dev_poll(src, 0);
+        mpr_dev_poll(dst, 0);
+    }
+    elapsed = current_time() - elapsed;
+
+    /* allow the last update to arrive */
+    last_received = -1;
+    while (!done && last_received != received) {
+        last_received = received;
+        mpr_dev_poll(src, 10);
+        mpr_dev_poll(dst, 10);
+    }
+
+    eprintf("%-8s %d updates in %f seconds (%.1f us/update), %d received\n", label, i,
+            elapsed, elapsed * 1e6 / (i ? i : 1), received);
+    return check_received(label);
+}
+
+int run_test()
+{
+    int i;
+
+    /* send the whole vector once so the destination has a value for every element */
+    for (i = 0; i < VEC_LEN; i++)
+        sent_vec[i] = i;
+    mpr_sig_set_value(sendsig, 0, VEC_LEN, MPR_FLT, sent_vec);
+    while (!done && !received) {
+        mpr_dev_poll(src, 10);
+        mpr_dev_poll(dst, 10);
+    }
+    if (check_received("initial"))
+        return 1;
+
+    if (compare_sizes())
+        return 1;
+
+    do {
+        received = 0;
+        if (run_updates(0))
+            return 1;
+        received = 0;
+        if (run_updates(1))
+            return 1;
+    } while (!terminate && !done);
+    return 0;
+}
+
+void ctrlc(int sig)
+{
+    done = 1;
+}
+
+int main(int argc, char **argv)
+{
+    int i, j, result = 0;
+    char *iface = 0;
+
+    /* process flags for -v verbose, -t terminate, -h help */
+    for (i = 1; i < argc; i++) {
+        if (argv[i] && argv[i][0] == '-') {
+            int len = strlen(argv[i]);
+            for (j = 1; j < len; j++) {
+                switch (argv[i][j]) {
+                    case 'h':
+                        printf("testsparse.c: possible arguments "
+                               "-f fast (execute quickly), "
+                               "-q quiet (suppress output), "
+                               "-t terminate automatically, "
+                               "-h help, "
+                               "--iface network interface\n");
+                        return 1;
+                        break;
+                    case 'f':
+                        iterations = 100;
+                        break;
+                    case 'q':
+                        verbose = 0;
+                        break;
+                    case 't':
+                        terminate = 1;
+                        break;
+                    case '-':
+                        if (strcmp(argv[i], "--iface")==0 && argc>i+1) {
+                            i++;
+                            iface = argv[i];
+                            j = 1;
+                        }
+                        break;
+                    default:
+                        break;
+                }
+            }
+        }
+    }
+
+    signal(SIGINT, ctrlc);
+
+    if (setup_devs(iface)) {
+        eprintf("Error initializing devices.\n");
+        result = 1;
+        goto done;
+    }
+
+    wait_ready();
+
+    if (setup_map()) {
+        eprintf("Error initializing map.\n");
+        result = 1;
+        goto done;
+    }
+
+    result = run_test();
+
+  done:
+    cleanup_devs();
+    printf("\r..................................................Test %s\x1B[0m.\n",
+           result ? "\x1B[31mFAILED" : "\x1B[32mPASSED");
+    return result;
+}
@@ -0,0 +1,196 @@
+#include <mapper/mapper.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdarg.h>
+#include <string.h>
+#include <signal.h>
+
+/* Test of instance stealing: an output signal with a few instances is updated with more
+ * instance ids than it has instances, and the stolen instance is checked for each mode. */
+
+#define NUM_INST 4
+
+int verbose = 1;
+int terminate = 0;
+int done = 0;
+int col = 0;
+
+mpr_dev dev = 0;
+
+mpr_id stolen = 0;
+int num_stolen = 0;
+
+typedef struct _steal_config {
+    mpr_steal_type mode;
+    const char *name;
+    mpr_id expected;
+} steal_config;
+
+/* Instances 10-13 are activated in order and then 10 and 11 are updated again. */
+steal_config configs[] = {
+    { MPR_STEAL_OLDEST,         "oldest",       10 },
+    { MPR_STEAL_NEWEST,         "newest",       13 },
+    { MPR_STEAL_LEAST_RECENT,   "least recent", 12 },
+};
+#define NUM_CONFIGS (sizeof(configs) / sizeof(steal_config))
+
+static void eprintf(const char *format, ...)
+{
+    va_list args;
+    if (!verbose) {
+        if (col >= 50)
+            printf("\33[2K\r");
+        fprintf(stdout, ".");
+        ++col;
+        return;
+    }
+    va_start(args, format);
+    vprintf(format, args);
+    fflush(stdout);
+    va_end(args);
+}
+
+void handler(mpr_sig sig, mpr_sig_evt evt, mpr_id inst, int len,
+             mpr_type type, const void *val, mpr_time t)
+{
+    if (evt & MPR_SIG_REL_UPSTRM) {
+        eprintf("--> releasing instance %i\n", (int)inst);
+        stolen = inst;
+        ++num_stolen;
+        mpr_sig_release_inst(sig, inst);
+    }
+}
+
+int setup_dev(const char *iface)
+{
+    dev = mpr_dev_new("teststeal", 0);
+    if (!dev)
+        goto error;
+    if (iface)
+        mpr_graph_set_interface(mpr_obj_get_graph(dev), iface);
+    eprintf("device created using interface %s.\n",
+            mpr_graph_get_interface(mpr_obj_get_graph(dev)));
+    return 0;
+
+error:
+    return 1;
+}
+
+void cleanup_dev()
+{
+    if (dev) {
+        eprintf("Freeing device.. ");
+        fflush(stdout);
+        mpr_dev_free(dev);
+        eprintf("ok\n");
+    }
+}
+
+void wait_ready()
+{
+    while (!done && !mpr_dev_get_is_ready(dev))
+        mpr_dev_poll(dev, 10);
+}
+
+int run_config(steal_config *config)
+{
+    int i, num_inst = NUM_INST, stl = config->mode, result = 0;
+    float val = 0.f;
+    mpr_sig sig = mpr_sig_new(dev, MPR_DIR_OUT, "outsig", 1, MPR_FLT, NULL, NULL, NULL,
+                              &num_inst, handler, MPR_SIG_REL_UPSTRM);
+    if (!sig) {
+        eprintf("Error creating signal.\n");
+        return 1;
+    }
+    mpr_obj_set_prop((mpr_obj)sig, MPR_PROP_STEAL_MODE, NULL, 1, MPR_INT32, &stl, 1);
+
+    for (i = 0; i < NUM_INST; i++)
+        mpr_sig_set_value(sig, 10 + i, 1, MPR_FLT, &val);
+    mpr_sig_set_value(sig, 10, 1, MPR_FLT, &val);
+    mpr_sig_set_value(sig, 11, 1, MPR_FLT, &val);
+
+    stolen = 0;
+    num_stolen = 0;
+    mpr_sig_set_value(sig, 20, 1, MPR_FLT, &val);
+
+    eprintf("Steal %s: stole instance %i\n", config->name, (int)stolen);
+    if (num_stolen != 1 || stolen != config->expected) {
+        eprintf("Error: expected instance %i to be stolen.\n", (int)config->expected);
+        result = 1;
+    }
+    else if (!mpr_sig_get_value(sig, 20, 0) || mpr_sig_get_value(sig, stolen, 0)) {
+        eprintf("Error: instance 20 was not activated in place of instance %i.\n",
+                (int)stolen);
+        result = 1;
+    }
+
+    mpr_sig_free(sig);
+    mpr_dev_poll(dev, 0);
+    return result;
+}
+
+void ctrlc(int sig)
+{
+    done = 1;
+}
+
+int main(int argc, char **argv)
+{
+    int i, j, result = 0;
+    char *iface = 0;
+
+    /* process flags for -v verbose, -t terminate, -h help */
+    for (i = 1; i < argc; i++) {
+        if (argv[i] && argv[i][0] == '-') {
+            int len = strlen(argv[i]);
+            for (j = 1; j < len; j++) {
+                switch (argv[i][j]) {
+                    case 'h':
+                        printf("teststeal.c: possible arguments "
+                               "-q quiet (suppress output), "
+                               "-t terminate automatically, "
+                               "-h help, "
+                               "--iface network interface\n");
+                        return 1;
+                        break;
+                    case 'q':
+                        verbose = 0;
+                        break;
+                    case 't':
+                        terminate = 1;
+                        break;
+                    case '-':
+                        if (strcmp(argv[i], "--iface")==0 && argc>i+1) {
+                            i++;
+                            iface = argv[i];
+                            j = 1;
+                        }
+                        break;
+                    default:
+                        break;
+                }
+            }
+        }
+    }
+
+    signal(SIGINT, ctrlc);
+
+    if (setup_dev(iface)) {
+        eprintf("Error initializing device.\n");
+        result = 1;
+        goto done;
+    }
+
+    wait_ready();
+
+    do {
+        for (i = 0; i < NUM_CONFIGS && !done && !result; i++)
+            result = run_config(&configs[i]);
+    } while (!terminate && !done && !result);
+
+done:
+    cleanup_dev();
+    printf("\r..................................................Test %s\x1B[0m.\n",
+           result ? "\x1B[31mFAILED" : "\x1B[32mPASSED");
+    return result;
+}